@@ -0,0 +1,41 @@
+/*
+ * SHA-1 using the ARMv8 Crypto Extensions, with a run-time fallback to
+ * the generic implementation in lib/sha1.c
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha1.h>
+
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data,
+		       unsigned int blocks);
+
+static bool sha1_ce_available(void)
+{
+	return ID_AA64ISAR0_FIELD(read_id_aa64isar0(),
+				  ID_AA64ISAR0_SHA1_SHIFT) != 0;
+}
+
+void sha1_transform(sha1_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	uint32_t state[5];
+	int i;
+
+	if (!blocks)
+		return;
+
+	if (!sha1_ce_available()) {
+		sha1_transform_generic(ctx, data, blocks);
+		return;
+	}
+
+	/* sha1_context keeps the state in unsigned longs, the core wants u32 */
+	for (i = 0; i < 5; i++)
+		state[i] = ctx->state[i];
+	sha1_ce_transform(state, data, blocks);
+	for (i = 0; i < 5; i++)
+		ctx->state[i] = state[i];
+}
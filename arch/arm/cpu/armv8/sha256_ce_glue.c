@@ -0,0 +1,35 @@
+/*
+ * SHA-256 using the ARMv8 Crypto Extensions, with a run-time fallback to
+ * the generic implementation in lib/sha256.c
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha256.h>
+
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 unsigned int blocks);
+
+/*
+ * The ID register read is a handful of cycles, far less than a single
+ * block, and avoids writing a cached flag before relocation.
+ */
+static bool sha256_ce_available(void)
+{
+	return ID_AA64ISAR0_FIELD(read_id_aa64isar0(),
+				  ID_AA64ISAR0_SHA2_SHIFT) != 0;
+}
+
+void sha256_transform(uint32_t state[8], const uint8_t *data,
+		      unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (sha256_ce_available())
+		sha256_ce_transform(state, data, blocks);
+	else
+		sha256_transform_generic(state, data, blocks);
+}
@@ -69,4 +69,14 @@ int sip_smc_set_sip_version(unsigned long version);
 struct arm_smccc_res sip_smc_get_sip_version(void);
 int psci_cpu_on(unsigned long cpuid, unsigned long entry_point);
 
+/* As psci_cpu_on(), but @context_id is passed to the new CPU in x0/r0 */
+int psci_cpu_on_context(unsigned long cpuid, unsigned long entry_point,
+			unsigned long context_id);
+
+/* Power down the calling CPU, only returns on error */
+int psci_cpu_off(void);
+
+/* Returns PSCI_AFFINITY_LEVEL_ON/OFF/ON_PENDING, or -ve on error */
+int psci_affinity_info(unsigned long cpuid, unsigned long lowest_level);
+
 #endif
@@ -10,6 +10,7 @@
 #define VENDOR_WIFI_MAC_ID	2 /* wifi mac */
 #define VENDOR_LAN_MAC_ID	3 /* lan mac */
 #define VENDOR_BLUETOOTH_ID	4 /* bluetooth mac */
+#define VENDOR_MMC_TUNING_ID	64 /* mmc sample phases */
 
 struct vendor_item {
 	u16  id;
@@ -21,6 +22,9 @@ struct vendor_item {
 int vendor_storage_test(void);
 int vendor_storage_read(u16 id, void *pbuf, u16 size);
 int vendor_storage_write(u16 id, void *pbuf, u16 size);
+int emmc_vendor_storage_peek(int (*read)(void *priv, u32 sec, u32 n_sec,
+					 void *buffer),
+			     void *priv, u16 id, void *pbuf, u16 size);
 int flash_vendor_dev_ops_register(int (*read)(struct blk_desc *dev_desc,
 					      u32 sec,
 					      u32 n_sec,
@@ -29,4 +33,10 @@ int flash_vendor_dev_ops_register(int (*read)(struct blk_desc *dev_desc,
 					       u32 sec,
 					       u32 n_sec,
 					       void *p_data));
+
+/*
+ * Write the mmc sample phases found since boot to the vendor storage. This is
+ * left until the boot device is up, since tuning happens while it is set up.
+ */
+int rockchip_dwmmc_save_tuning(void);
 #endif /* _ROCKCHIP_VENDOR_ */
@@ -78,6 +78,39 @@ lr	.req	x30
 	b.eq	\el1_label
 .endm
 
+/*
+ * Branch unless the MMU and D-cache are on and alignment checks are off at
+ * the current exception level, i.e. unless unaligned accesses and DC ZVA
+ * may be used on memory.
+ */
+.macro	branch_if_dcache_off, xreg, off_label
+	switch_el \xreg, 3f, 2f, 1f
+3:	mrs	\xreg, sctlr_el3
+	b	4f
+2:	mrs	\xreg, sctlr_el2
+	b	4f
+1:	mrs	\xreg, sctlr_el1
+4:	and	\xreg, \xreg, #(CR_M | CR_A | CR_C)
+	cmp	\xreg, #(CR_M | CR_C)
+	b.ne	\off_label
+.endm
+
+/*
+ * Branch unless \start to \end lies in the DRAM used by U-Boot, from
+ * CONFIG_SYS_SDRAM_BASE to gd->ram_top. Anything else, e.g. SRAM or MMIO,
+ * may be mapped as Device memory, where unaligned accesses and DC ZVA fault.
+ * Nothing is taken as DRAM while gd->ram_top is still 0. GD_RAM_TOP comes
+ * from <asm-offsets.h>.
+ */
+.macro	branch_if_not_ram, start, end, xreg, label
+	ldr	\xreg, =CONFIG_SYS_SDRAM_BASE
+	cmp	\start, \xreg
+	b.lo	\label
+	ldr	\xreg, [x18, #GD_RAM_TOP]
+	cmp	\end, \xreg
+	b.hi	\label
+.endm
+
 /*
  * Branch if current processor is a Cortex-A57 core.
  */
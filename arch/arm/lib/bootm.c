@@ -23,9 +23,12 @@
 #include <mapmem.h>
 #include <fdt_support.h>
 #include <asm/bootm.h>
+#include <asm/sections.h>
 #include <asm/secure.h>
 #include <linux/compiler.h>
 #include <bootm.h>
+#include <serial.h>
+#include <smp_job.h>
 #include <vxworks.h>
 
 #ifdef CONFIG_ARMV7_NONSEC
@@ -63,6 +66,13 @@ void arch_lmb_reserve(struct lmb *lmb)
 
 	/* adjust sp by 4K to be safe */
 	sp -= 4096;
+#ifdef CONFIG_SKIP_RELOCATE
+	/*
+	 * U-Boot runs where it was loaded, with its stack, data and malloc()
+	 * area between the end of its BSS and CONFIG_SKIP_RELOCATE_TOP
+	 */
+	sp = min(sp, (ulong)__image_copy_start);
+#endif
 	lmb_reserve(lmb, sp,
 		    gd->ram_top - sp);
 }
@@ -92,6 +102,9 @@ static void announce_and_cleanup(int fake)
 	udc_disconnect();
 #endif
 
+	/* Send buffered console output before the OS takes the UART */
+	serial_flush();
+
 #ifdef CONFIG_ARCH_ROCKCHIP
 	/* Enable this flag, call putc to flush console(ns16550_serial_putc)*/
 	gd->flags |= GD_FLG_OS_RUN;
@@ -104,6 +117,9 @@ static void announce_and_cleanup(int fake)
 	putc('\n');
 #endif
 
+	/* Power off the secondary CPUs so that the OS can start them */
+	smp_job_exit();
+
 	board_quiesce_devices();
 
 	/*
@@ -22,6 +22,8 @@
  */
 
 #include <common.h>
+#include <serial.h>
+#include <smp_job.h>
 
 __weak void reset_misc(void)
 {
@@ -30,6 +32,8 @@ __weak void reset_misc(void)
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	puts ("resetting ...\n");
+	serial_flush();
+	smp_job_exit();
 
 	udelay (50000);				/* wait 50 ms */
 
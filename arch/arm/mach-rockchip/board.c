@@ -30,6 +30,7 @@
 #endif
 #include <mmc.h>
 #include <of_live.h>
+#include <dm/probe.h>
 #include <dm/root.h>
 #include <led.h>
 
@@ -113,6 +114,13 @@ static int charge_display(void)
 	int ret;
 	struct udevice *dev;
 
+	/*
+	 * This pulls in the PMIC, fuel gauge and display. If the boot flow
+	 * does not need it, leave it to the 'charge' command.
+	 */
+	if (!dm_probe_needed(UCLASS_CHARGE_DISPLAY))
+		return 0;
+
 	ret = uclass_get_device(UCLASS_CHARGE_DISPLAY, 0, &dev);
 	if (ret) {
 		if (ret != -ENODEV) {
@@ -187,6 +195,9 @@ int board_late_init(void)
 #endif
 
 	rockchip_set_serialno();
+#ifdef CONFIG_MMC_DW_ROCKCHIP_TUNING_CACHE
+	rockchip_dwmmc_save_tuning();
+#endif
 
 	soc_clk_dump();
 
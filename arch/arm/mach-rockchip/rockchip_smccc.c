@@ -14,9 +14,11 @@
 #ifdef CONFIG_ARM64
 #define ARM_PSCI_1_0_SYSTEM_SUSPEND	ARM_PSCI_1_0_FN64_SYSTEM_SUSPEND
 #define ARM_PSCI_0_2_CPU_ON		ARM_PSCI_0_2_FN64_CPU_ON
+#define ARM_PSCI_0_2_AFFINITY_INFO	ARM_PSCI_0_2_FN64_AFFINITY_INFO
 #else
 #define ARM_PSCI_1_0_SYSTEM_SUSPEND	ARM_PSCI_1_0_FN_SYSTEM_SUSPEND
 #define ARM_PSCI_0_2_CPU_ON		ARM_PSCI_0_2_FN_CPU_ON
+#define ARM_PSCI_0_2_AFFINITY_INFO	ARM_PSCI_0_2_FN_AFFINITY_INFO
 #endif
 
 #define SIZE_PAGE(n)	((n) << 12)
@@ -33,10 +35,36 @@ static struct arm_smccc_res __invoke_sip_fn_smc(unsigned long function_id,
 }
 
 int psci_cpu_on(unsigned long cpuid, unsigned long entry_point)
+{
+	return psci_cpu_on_context(cpuid, entry_point, 0);
+}
+
+int psci_cpu_on_context(unsigned long cpuid, unsigned long entry_point,
+			unsigned long context_id)
+{
+	struct arm_smccc_res res;
+
+	res = __invoke_sip_fn_smc(ARM_PSCI_0_2_CPU_ON, cpuid, entry_point,
+				  context_id);
+
+	return res.a0;
+}
+
+int psci_cpu_off(void)
+{
+	struct arm_smccc_res res;
+
+	res = __invoke_sip_fn_smc(ARM_PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+
+	return res.a0;
+}
+
+int psci_affinity_info(unsigned long cpuid, unsigned long lowest_level)
 {
 	struct arm_smccc_res res;
 
-	res = __invoke_sip_fn_smc(ARM_PSCI_0_2_CPU_ON, cpuid, entry_point, 0);
+	res = __invoke_sip_fn_smc(ARM_PSCI_0_2_AFFINITY_INFO, cpuid,
+				  lowest_level, 0);
 
 	return res.a0;
 }
@@ -0,0 +1,171 @@
+/*
+ * Start secondary CPUs with PSCI to run smp_job work
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <libfdt.h>
+#include <malloc.h>
+#include <smp_job.h>
+#include <asm/psci.h>
+#include <asm/system.h>
+#include <asm/arch/rockchip_smccc.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SMP_JOB_STACK_SIZE	SZ_16K
+#define SMP_JOB_STOP_TIMEOUT_MS	100
+#define MPIDR_HWID_MASK		0xff00ffffffUL
+
+/* Read by rockchip_smp_job_entry() with the MMU off, keep in sync */
+struct rockchip_smp_job_boot {
+	ulong sp;
+	ulong gd;
+	ulong vbar;
+	ulong mair;
+	ulong tcr;
+	ulong ttbr;
+	ulong sctlr;
+	struct smp_job_cpu *cpu;
+	void *stack;
+} __aligned(ARCH_DMA_MINALIGN);
+
+extern char rockchip_smp_job_entry[], rockchip_smp_job_entry_end[];
+
+void rockchip_smp_job_main(struct smp_job_cpu *cpu)
+{
+	smp_job_worker(cpu);
+	psci_cpu_off();
+}
+
+static void smp_job_get_mmu(struct rockchip_smp_job_boot *boot)
+{
+	if (current_el() == 2) {
+		asm volatile("mrs %0, vbar_el2" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el2" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el2" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (boot->ttbr));
+		asm volatile("mrs %0, sctlr_el2" : "=r" (boot->sctlr));
+	} else {
+		asm volatile("mrs %0, vbar_el1" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el1" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el1" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (boot->ttbr));
+		asm volatile("mrs %0, sctlr_el1" : "=r" (boot->sctlr));
+	}
+}
+
+static int smp_job_start_cpu(struct smp_job_cpu *cpu, ulong mpidr)
+{
+	struct rockchip_smp_job_boot *boot;
+	int ret;
+
+	boot = memalign(ARCH_DMA_MINALIGN, sizeof(*boot));
+	if (!boot)
+		return -ENOMEM;
+	boot->stack = malloc(SMP_JOB_STACK_SIZE);
+	if (!boot->stack) {
+		free(boot);
+		return -ENOMEM;
+	}
+	boot->sp = round_down((ulong)boot->stack + SMP_JOB_STACK_SIZE, 16);
+	boot->gd = (ulong)gd;
+	boot->cpu = cpu;
+	smp_job_get_mmu(boot);
+	cpu->id = mpidr;
+	cpu->priv = boot;
+
+	/* The new CPU reads these before it turns on its MMU and caches */
+	flush_dcache_range((ulong)boot, (ulong)boot + sizeof(*boot));
+	flush_dcache_range(round_down((ulong)rockchip_smp_job_entry,
+				      ARCH_DMA_MINALIGN),
+			   ALIGN((ulong)rockchip_smp_job_entry_end,
+				 ARCH_DMA_MINALIGN));
+
+	ret = psci_cpu_on_context(mpidr, (ulong)rockchip_smp_job_entry,
+				  (ulong)boot);
+	if (ret) {
+		debug("%s: CPU %lx failed to start: %d\n", __func__, mpidr,
+		      ret);
+		free(boot->stack);
+		free(boot);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int smp_job_arch_start(struct smp_job_cpu *cpus, int max)
+{
+	const void *blob = gd->fdt_blob;
+	ulong self = read_mpidr() & MPIDR_HWID_MASK;
+	int node, count = 0;
+	const fdt32_t *reg;
+	const char *prop;
+	ulong mpidr;
+	int len;
+
+	node = fdt_path_offset(blob, "/cpus");
+	if (node < 0)
+		return 0;
+
+	for (node = fdt_first_subnode(blob, node);
+	     node >= 0 && count < max;
+	     node = fdt_next_subnode(blob, node)) {
+		prop = fdt_getprop(blob, node, "device_type", NULL);
+		if (!prop || strcmp(prop, "cpu"))
+			continue;
+		prop = fdt_getprop(blob, node, "enable-method", NULL);
+		if (prop && strcmp(prop, "psci"))
+			continue;
+		reg = fdt_getprop(blob, node, "reg", &len);
+		if (!reg)
+			continue;
+		if (len >= sizeof(fdt64_t))
+			mpidr = fdt64_to_cpu(*(fdt64_t *)reg);
+		else
+			mpidr = fdt32_to_cpu(*reg);
+		if ((mpidr & MPIDR_HWID_MASK) == self)
+			continue;
+		if (!smp_job_start_cpu(&cpus[count], mpidr))
+			count++;
+	}
+
+	return count;
+}
+
+void smp_job_arch_stop(struct smp_job_cpu *cpus, int count)
+{
+	struct rockchip_smp_job_boot *boot;
+	ulong start;
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		boot = cpus[i].priv;
+		start = get_timer(0);
+		do {
+			ret = psci_affinity_info(cpus[i].id, 0);
+			if (ret == PSCI_AFFINITY_LEVEL_OFF && !cpus[i].running)
+				break;
+		} while (get_timer(start) < SMP_JOB_STOP_TIMEOUT_MS);
+		if (ret != PSCI_AFFINITY_LEVEL_OFF) {
+			/* Leave its stack alone since it may still be used */
+			printf("CPU %lx did not stop (%d)\n", cpus[i].id, ret);
+			continue;
+		}
+		free(boot->stack);
+		free(boot);
+	}
+}
+
+void smp_job_arch_idle(void)
+{
+	asm volatile("wfe" : : : "memory");
+}
+
+void smp_job_arch_kick(void)
+{
+	asm volatile("dsb sy\n\tsev" : : : "memory");
+}
@@ -12,6 +12,7 @@
 #include <asm/arch/bootrom.h>
 #include <asm/arch-rockchip/sys_proto.h>
 #include <asm/io.h>
+#include <asm/system.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -86,6 +87,36 @@ __weak int rk_board_init_f(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(ROCKCHIP_EARLY_DCACHE)
+/* Map DRAM cacheable, with the page table at its top, and enable D-cache */
+static void rk_spl_dcache_enable(void)
+{
+	int ret;
+
+	ret = dram_init();
+	if (ret) {
+		debug("%s: no DRAM size, caches stay off: %d\n", __func__, ret);
+		return;
+	}
+	/* The size is already limited to SDRAM_MAX_SIZE */
+	gd->ram_top = CONFIG_SYS_SDRAM_BASE + gd->ram_size;
+
+	gd->arch.tlb_size = PGTABLE_SIZE;
+	gd->arch.tlb_addr = (gd->ram_top - gd->arch.tlb_size) & ~(0x10000 - 1);
+	debug("SPL TLB table from %08lx to %08lx\n", gd->arch.tlb_addr,
+	      gd->arch.tlb_addr + gd->arch.tlb_size);
+
+	dcache_enable();
+}
+
+void spl_board_prepare_for_boot(void)
+{
+	/* Write the loaded images back to DRAM for a next stage without caches */
+	dcache_disable();
+	invalidate_icache_all();
+}
+#endif
+
 void board_init_f(ulong dummy)
 {
 #ifdef CONFIG_SPL_FRAMEWORK
@@ -133,6 +164,9 @@ void board_init_f(ulong dummy)
 	sdram_init();
 #endif
 
+#if CONFIG_IS_ENABLED(ROCKCHIP_EARLY_DCACHE)
+	rk_spl_dcache_enable();
+#endif
 	rk_board_init_f();
 #if CONFIG_IS_ENABLED(ROCKCHIP_BACK_TO_BROM) && !defined(CONFIG_SPL_BOARD_INIT)
 	back_to_bootrom(BROM_BOOT_NEXTSTAGE);
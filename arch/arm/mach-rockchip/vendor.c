@@ -8,6 +8,7 @@
 #include <malloc.h>
 #include <asm/arch/vendor.h>
 #include <boot_rkimg.h>
+#include <u-boot/crc.h>
 
 /* tag for vendor check */
 #define VENDOR_TAG		0x524B5644
@@ -109,8 +110,10 @@ struct vendor_info {
 #define FLASH_VENDOR_HASH_OFFSET (FLASH_VENDOR_INFO_SIZE - 8)
 #define FLASH_VENDOR_VERSION2_OFFSET (FLASH_VENDOR_INFO_SIZE - 4)
 
+#ifndef CONFIG_ROCKCHIP_VENDOR_JOURNAL
 /* vendor info */
 static struct vendor_info vendor_info;
+#endif
 /* The storage type of the device */
 static int bootdev_type;
 
@@ -219,6 +222,595 @@ static int vendor_ops(u8 *buffer, u32 addr, u32 n_sec, int write)
 	return ret;
 }
 
+#ifdef CONFIG_ROCKCHIP_VENDOR_JOURNAL
+/*
+ * With CONFIG_ROCKCHIP_VENDOR_JOURNAL the VendorStorage partition is split
+ * into two halves rather than four copies. One half holds a log of records,
+ * each of them the new content of one item, and the newest record of an id
+ * is the live one:
+ *
+ * |************************ FLASH ************************|
+ * ---------------------------------------------------------
+ * | hdr | rec | rec | ... | rec | free |     other half    |
+ * ---------------------------------------------------------
+ * Notices:
+ *   1. A write appends a record and writes back only the blocks it
+ *      touches. Records carry a crc32 and the log ends at the first bad
+ *      one, which is all an interrupted write leaves behind.
+ *   2. When the half is full the live records are copied to the other
+ *      half, whose header has a larger "version" and is written last, so
+ *      one of the halves is always valid.
+ *   3. An index from id to record is built when the log is read, so
+ *      items are found without walking it.
+ *   4. A partition in the old layout is read into a log on init, which is
+ *      written to the half not holding the newest copy on the first write.
+ */
+#define VENDOR_LOG_TAG		0x524B564C
+#define VENDOR_REC_TAG		0x52454344
+/* align records to 8 bytes */
+#define VENDOR_REC_ALIGN	8
+/* Slots in the id index, a power of two above twice the item limit */
+#define VENDOR_INDEX_SIZE	256
+
+struct vendor_log_hdr {
+	u32	tag;
+	u32	version;
+	u32	size; /* Bytes in each half */
+	u32	crc; /* crc32 of the fields above */
+};
+
+struct vendor_rec {
+	u32	tag;
+	u16	id;
+	u16	size;
+	u32	crc; /* crc32 of id, size and the data which follows */
+};
+
+struct vendor_index {
+	u16	id;
+	u16	used;
+	u32	offset; /* Offset of the newest record in the half */
+};
+
+struct vendor_log {
+	u8 *buf; /* Both halves */
+	u32 half_blks;
+	u32 size; /* Bytes in each half */
+	u32 cur; /* Half holding the log */
+	u32 end; /* Offset of the free space */
+	u32 live; /* Bytes taken by the header and the live records */
+	u32 version;
+	bool saved; /* False until the half is on the flash */
+	u16 item_num;
+	u16 max_item_num;
+	struct vendor_index index[VENDOR_INDEX_SIZE];
+};
+
+/* The old layout of each Flash type */
+struct vendor_geo {
+	u16 part_size;
+	u16 part_num;
+	u16 item_num;
+	u16 data_offset;
+	u16 version2_offset;
+};
+
+static struct vendor_log vendor_log;
+
+static int vendor_get_geo(int if_type, struct vendor_geo *geo)
+{
+	switch (if_type) {
+	case IF_TYPE_MMC:
+		geo->part_size = EMMC_VENDOR_PART_BLKS;
+		geo->part_num = VENDOR_PART_NUM;
+		geo->item_num = EMMC_VENDOR_ITEM_NUM;
+		geo->data_offset = EMMC_VENDOR_DATA_OFFSET;
+		geo->version2_offset = EMMC_VENDOR_VERSION2_OFFSET;
+		break;
+	case IF_TYPE_RKNAND:
+	case IF_TYPE_SPINAND:
+		geo->part_size = NAND_VENDOR_PART_BLKS;
+		geo->part_num = NAND_VENDOR_PART_NUM;
+		geo->item_num = NAND_VENDOR_ITEM_NUM;
+		geo->data_offset = NAND_VENDOR_DATA_OFFSET;
+		geo->version2_offset = NAND_VENDOR_VERSION2_OFFSET;
+		break;
+	case IF_TYPE_SPINOR:
+		geo->part_size = FLASH_VENDOR_PART_BLKS;
+		geo->part_num = VENDOR_PART_NUM;
+		geo->item_num = FLASH_VENDOR_ITEM_NUM;
+		geo->data_offset = FLASH_VENDOR_DATA_OFFSET;
+		geo->version2_offset = FLASH_VENDOR_VERSION2_OFFSET;
+		break;
+	default:
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+static u8 *vendor_log_half(u32 half)
+{
+	return vendor_log.buf + half * vendor_log.size;
+}
+
+static u32 vendor_rec_len(u16 size)
+{
+	return ALIGN(sizeof(struct vendor_rec) + size, VENDOR_REC_ALIGN);
+}
+
+static u32 vendor_rec_crc(struct vendor_rec *rec)
+{
+	u32 crc;
+
+	crc = crc32(0, (u8 *)&rec->id, sizeof(rec->id) + sizeof(rec->size));
+	return crc32(crc, (u8 *)(rec + 1), rec->size);
+}
+
+/* Return the length of the record at @offset of @half, 0 if it is bad */
+static u32 vendor_rec_check(u8 *half, u32 offset, u32 size)
+{
+	struct vendor_rec *rec = (struct vendor_rec *)(half + offset);
+	u32 len;
+
+	if (offset + sizeof(*rec) > size || rec->tag != VENDOR_REC_TAG)
+		return 0;
+	len = vendor_rec_len(rec->size);
+	if (offset + len > size || rec->crc != vendor_rec_crc(rec))
+		return 0;
+
+	return len;
+}
+
+static u32 vendor_log_hdr_crc(struct vendor_log_hdr *hdr)
+{
+	return crc32(0, (u8 *)hdr, offsetof(struct vendor_log_hdr, crc));
+}
+
+static bool vendor_log_hdr_valid(struct vendor_log_hdr *hdr, u32 size)
+{
+	return hdr->tag == VENDOR_LOG_TAG && hdr->version &&
+	       hdr->size == size && hdr->crc == vendor_log_hdr_crc(hdr);
+}
+
+/* Return the slot of @id, or the free slot for it; NULL if full */
+static struct vendor_index *vendor_index_find(u16 id)
+{
+	struct vendor_index *idx;
+	u32 i;
+
+	for (i = 0; i < VENDOR_INDEX_SIZE; i++) {
+		idx = &vendor_log.index[(id + i) & (VENDOR_INDEX_SIZE - 1)];
+		if (!idx->used || idx->id == id)
+			return idx;
+	}
+
+	return NULL;
+}
+
+/* Make the record at @offset of the log the live one of its id */
+static int vendor_index_add(u32 offset)
+{
+	u8 *half = vendor_log_half(vendor_log.cur);
+	struct vendor_rec *rec = (struct vendor_rec *)(half + offset);
+	struct vendor_rec *old;
+	struct vendor_index *idx;
+
+	idx = vendor_index_find(rec->id);
+	if (!idx)
+		return -ENOMEM;
+	if (idx->used) {
+		old = (struct vendor_rec *)(half + idx->offset);
+		vendor_log.live -= vendor_rec_len(old->size);
+	} else {
+		idx->id = rec->id;
+		idx->used = 1;
+		vendor_log.item_num++;
+	}
+	idx->offset = offset;
+	vendor_log.live += vendor_rec_len(rec->size);
+
+	return 0;
+}
+
+/* Start an empty log in @half, newer than the current one */
+static void vendor_log_start(u32 half)
+{
+	struct vendor_log_hdr *hdr;
+
+	hdr = (struct vendor_log_hdr *)vendor_log_half(half);
+	memset(hdr, 0, vendor_log.size);
+	hdr->tag = VENDOR_LOG_TAG;
+	hdr->version = ++vendor_log.version;
+	hdr->size = vendor_log.size;
+	hdr->crc = vendor_log_hdr_crc(hdr);
+
+	vendor_log.cur = half;
+	vendor_log.end = sizeof(*hdr);
+	vendor_log.saved = false;
+}
+
+/* Append a record to the log in memory */
+static void vendor_log_add(u16 id, void *pbuf, u16 size)
+{
+	u8 *half = vendor_log_half(vendor_log.cur);
+	struct vendor_rec *rec = (struct vendor_rec *)(half + vendor_log.end);
+
+	rec->tag = VENDOR_REC_TAG;
+	rec->id = id;
+	rec->size = size;
+	memcpy(rec + 1, pbuf, size);
+	rec->crc = vendor_rec_crc(rec);
+
+	if (!vendor_index_add(vendor_log.end))
+		vendor_log.end += vendor_rec_len(size);
+}
+
+/* Index the log in @half, which ends at the first bad record */
+static void vendor_log_scan(u32 half)
+{
+	u8 *buf = vendor_log_half(half);
+	u32 offset, len;
+
+	memset(vendor_log.index, 0, sizeof(vendor_log.index));
+	vendor_log.item_num = 0;
+	vendor_log.live = sizeof(struct vendor_log_hdr);
+	vendor_log.cur = half;
+
+	offset = sizeof(struct vendor_log_hdr);
+	while ((len = vendor_rec_check(buf, offset, vendor_log.size))) {
+		if (vendor_index_add(offset))
+			break;
+		offset += len;
+	}
+	vendor_log.end = offset;
+	/* Drop what an interrupted write left, it is rewritten by the next */
+	memset(buf + offset, 0, vendor_log.size - offset);
+}
+
+/*
+ * Copy the live records to a new log in the other half, leaving out the
+ * one of @skip, which is about to be replaced.
+ */
+static void vendor_log_compact(struct vendor_index *skip)
+{
+	u8 *src = vendor_log_half(vendor_log.cur);
+	struct vendor_index *idx;
+	struct vendor_rec *rec;
+	u32 i, len;
+
+	debug("[Vendor INFO]:Compact vendor log, live=%d\n", vendor_log.live);
+	if (skip->used) {
+		rec = (struct vendor_rec *)(src + skip->offset);
+		vendor_log.live -= vendor_rec_len(rec->size);
+		vendor_log.item_num--;
+		skip->used = 0;
+	}
+
+	vendor_log_start(vendor_log.cur ^ 1);
+	for (i = 0; i < VENDOR_INDEX_SIZE; i++) {
+		idx = &vendor_log.index[i];
+		if (!idx->used)
+			continue;
+		rec = (struct vendor_rec *)(src + idx->offset);
+		len = vendor_rec_len(rec->size);
+		memcpy(vendor_log_half(vendor_log.cur) + vendor_log.end,
+		       rec, len);
+		idx->offset = vendor_log.end;
+		vendor_log.end += len;
+	}
+}
+
+/* Write the whole log, header block last, see above */
+static int vendor_log_save(void)
+{
+	u32 blks = vendor_log.half_blks;
+	u32 base = vendor_log.cur * blks;
+	u8 *buf = vendor_log_half(vendor_log.cur);
+
+	if (vendor_ops(buf + VENDOR_BLOCK_SIZE, base + 1, blks - 1, 1) !=
+	    blks - 1 || vendor_ops(buf, base, 1, 1) != 1)
+		return -EIO;
+	vendor_log.saved = true;
+
+	return 0;
+}
+
+/* Write the blocks of the log holding @len bytes at @offset */
+static int vendor_log_write(u32 offset, u32 len)
+{
+	u32 first = offset / VENDOR_BLOCK_SIZE;
+	u32 n_sec = DIV_ROUND_UP(offset + len, VENDOR_BLOCK_SIZE) - first;
+	u8 *buf = vendor_log_half(vendor_log.cur);
+	int cnt;
+
+	cnt = vendor_ops(buf + first * VENDOR_BLOCK_SIZE,
+			 vendor_log.cur * vendor_log.half_blks + first,
+			 n_sec, 1);
+
+	return (cnt == n_sec) ? 0 : -EIO;
+}
+
+/*
+ * Read the newest valid copy of the old layout into a log in the half
+ * which does not hold it, see vendor_storage_init(). Nothing is written
+ * until the first write.
+ */
+static void vendor_log_migrate(struct vendor_geo *geo)
+{
+	u32 copy_size = geo->part_size * VENDOR_BLOCK_SIZE;
+	u32 max_ver = 0, max_index = 0;
+	struct vendor_hdr *hdr;
+	struct vendor_item *item;
+	u32 i, half;
+	u8 *copy;
+
+	for (i = 0; i < geo->part_num; i++) {
+		copy = vendor_log.buf + copy_size * i;
+		hdr = (struct vendor_hdr *)copy;
+		if ((hdr->tag == VENDOR_TAG) &&
+		    (*(u32 *)(copy + geo->version2_offset) == hdr->version) &&
+		    (max_ver < hdr->version)) {
+			max_index = i;
+			max_ver = hdr->version;
+		}
+	}
+
+	if (!max_ver) {
+		debug("[Vendor INFO]:Reset vendor log...\n");
+		vendor_log_start(0);
+		return;
+	}
+
+	debug("[Vendor INFO]:Migrate vendor %d, max_ver=%d\n", max_index,
+	      max_ver);
+	half = max_index * geo->part_size / vendor_log.half_blks;
+	vendor_log_start(half ^ 1);
+
+	copy = vendor_log.buf + copy_size * max_index;
+	hdr = (struct vendor_hdr *)copy;
+	item = (struct vendor_item *)(copy + sizeof(struct vendor_hdr));
+	for (i = 0; i < hdr->item_num && i < geo->item_num; i++) {
+		if (geo->data_offset + item[i].offset + item[i].size >
+		    geo->version2_offset)
+			continue;
+		vendor_log_add(item[i].id, copy + geo->data_offset +
+			       item[i].offset, item[i].size);
+	}
+}
+
+int vendor_storage_init(void)
+{
+	struct blk_desc *dev_desc;
+	struct vendor_log_hdr *hdr;
+	struct vendor_geo geo;
+	u32 i, blks, max_ver = 0, max_index = 0;
+	u8 *buffer;
+	int ret;
+
+	dev_desc = rockchip_get_bootdev();
+	if (!dev_desc) {
+		printf("[Vendor ERROR]:Invalid boot device type(%d)\n",
+		       bootdev_type);
+		return -ENODEV;
+	}
+
+	ret = vendor_get_geo(dev_desc->if_type, &geo);
+	if (ret) {
+		debug("[Vendor ERROR]:Boot device type is invalid!\n");
+		return ret;
+	}
+
+	/* Always use, no need to release */
+	blks = geo.part_size * geo.part_num;
+	buffer = memalign(ARCH_DMA_MINALIGN, blks * VENDOR_BLOCK_SIZE);
+	if (!buffer) {
+		printf("[Vendor ERROR]:Malloc failed!\n");
+		return -ENOMEM;
+	}
+	/* The whole partition, in one read */
+	bootdev_type = dev_desc->if_type;
+	if (vendor_ops(buffer, 0, blks, 0) != blks) {
+		bootdev_type = 0;
+		free(buffer);
+		return -EIO;
+	}
+
+	vendor_log.buf = buffer;
+	vendor_log.half_blks = blks / 2;
+	vendor_log.size = vendor_log.half_blks * VENDOR_BLOCK_SIZE;
+	vendor_log.max_item_num = geo.item_num;
+	vendor_log.version = 0;
+
+	for (i = 0; i < 2; i++) {
+		hdr = (struct vendor_log_hdr *)vendor_log_half(i);
+		if (vendor_log_hdr_valid(hdr, vendor_log.size) &&
+		    max_ver < hdr->version) {
+			max_index = i;
+			max_ver = hdr->version;
+		}
+	}
+
+	if (max_ver) {
+		debug("[Vendor INFO]:max_ver=%d, half=%d.\n", max_ver,
+		      max_index);
+		vendor_log.version = max_ver;
+		vendor_log_scan(max_index);
+		vendor_log.saved = true;
+	} else {
+		memset(vendor_log.index, 0, sizeof(vendor_log.index));
+		vendor_log.item_num = 0;
+		vendor_log.live = sizeof(struct vendor_log_hdr);
+		vendor_log_migrate(&geo);
+	}
+
+	return 0;
+}
+
+/*
+ * @id: item id, first 4 id is occupied:
+ *	VENDOR_SN_ID
+ *	VENDOR_WIFI_MAC_ID
+ *	VENDOR_LAN_MAC_ID
+ *	VENDOR_BLUETOOTH_ID
+ * @pbuf: read data buffer;
+ * @size: read bytes;
+ *
+ * return: bytes equal to @size is success, other fail;
+ */
+int vendor_storage_read(u16 id, void *pbuf, u16 size)
+{
+	struct vendor_index *idx;
+	struct vendor_rec *rec;
+	int ret;
+
+	/* init vendor storage */
+	if (!bootdev_type) {
+		ret = vendor_storage_init();
+		if (ret < 0)
+			return ret;
+	}
+
+	idx = vendor_index_find(id);
+	if (!idx || !idx->used) {
+		debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+		return -EINVAL;
+	}
+
+	rec = (struct vendor_rec *)(vendor_log_half(vendor_log.cur) +
+				    idx->offset);
+	/* Correct the size value */
+	if (size > rec->size)
+		size = rec->size;
+	memcpy(pbuf, rec + 1, size);
+
+	return size;
+}
+
+/*
+ * @id: item id, first 4 id is occupied:
+ *	VENDOR_SN_ID
+ *	VENDOR_WIFI_MAC_ID
+ *	VENDOR_LAN_MAC_ID
+ *	VENDOR_BLUETOOTH_ID
+ * @pbuf: write data buffer;
+ * @size: write bytes;
+ *
+ * return: bytes equal to @size is success, other fail;
+ */
+int vendor_storage_write(u16 id, void *pbuf, u16 size)
+{
+	struct vendor_index *idx;
+	struct vendor_rec *old;
+	u32 offset, len, old_len = 0;
+	int ret;
+
+	/* init vendor storage */
+	if (!bootdev_type) {
+		ret = vendor_storage_init();
+		if (ret < 0)
+			return ret;
+	}
+
+	idx = vendor_index_find(id);
+	if (!idx || (!idx->used &&
+		     vendor_log.item_num >= vendor_log.max_item_num)) {
+		debug("[Vendor ERROR]:Vendor has no item left!\n");
+		return -ENOMEM;
+	}
+	if (idx->used) {
+		old = (struct vendor_rec *)(vendor_log_half(vendor_log.cur) +
+					    idx->offset);
+		old_len = vendor_rec_len(old->size);
+	}
+	len = vendor_rec_len(size);
+	if (vendor_log.live - old_len + len > vendor_log.size) {
+		debug("[Vendor ERROR]:Vendor has no space left!\n");
+		return -ENOMEM;
+	}
+
+	/* Only copy the log to the other half once it is full */
+	if (vendor_log.end + len > vendor_log.size)
+		vendor_log_compact(idx);
+
+	offset = vendor_log.end;
+	vendor_log_add(id, pbuf, size);
+	if (vendor_log.saved)
+		ret = vendor_log_write(offset, len);
+	else
+		ret = vendor_log_save();
+
+	return ret ? ret : size;
+}
+
+/*
+ * Find @id in a log in the vendor storage of an eMMC, see
+ * emmc_vendor_storage_peek(). Returns -ENOENT if there is no log.
+ */
+static int emmc_vendor_log_peek(int (*read)(void *priv, u32 sec, u32 n_sec,
+					    void *buffer),
+				void *priv, u16 id, void *pbuf, u16 size)
+{
+	const u32 half_blks = EMMC_VENDOR_PART_BLKS * VENDOR_PART_NUM / 2;
+	const u32 half_size = half_blks * VENDOR_BLOCK_SIZE;
+	struct vendor_log_hdr *hdr;
+	struct vendor_rec *rec;
+	u32 max_ver = 0, max_index = 0;
+	u32 i, base, offset, len, found = 0;
+	u8 *buffer;
+	int ret;
+
+	buffer = memalign(ARCH_DMA_MINALIGN, half_size);
+	if (!buffer)
+		return -ENOMEM;
+	hdr = (struct vendor_log_hdr *)buffer;
+
+	for (i = 0; i < 2; i++) {
+		base = EMMC_VENDOR_PART_OFFSET + half_blks * i;
+		if (read(priv, base, 1, buffer) != 1) {
+			ret = -EIO;
+			goto out;
+		}
+		if (vendor_log_hdr_valid(hdr, half_size) &&
+		    max_ver < hdr->version) {
+			max_index = i;
+			max_ver = hdr->version;
+		}
+	}
+	if (!max_ver) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	base = EMMC_VENDOR_PART_OFFSET + half_blks * max_index;
+	if (read(priv, base, half_blks, buffer) != half_blks) {
+		ret = -EIO;
+		goto out;
+	}
+	offset = sizeof(*hdr);
+	while ((len = vendor_rec_check(buffer, offset, half_size))) {
+		rec = (struct vendor_rec *)(buffer + offset);
+		if (rec->id == id)
+			found = offset;
+		offset += len;
+	}
+	if (!found) {
+		debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	rec = (struct vendor_rec *)(buffer + found);
+	if (size > rec->size)
+		size = rec->size;
+	memcpy(pbuf, rec + 1, size);
+	ret = size;
+out:
+	free(buffer);
+	return ret;
+}
+#else
+
 /*
  * The VendorStorage partition is divided into four parts
  * (vendor 0-3) and its structure is shown in the following figure.
@@ -498,9 +1090,137 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 	return -ENOMEM;
 }
 
+#endif /* CONFIG_ROCKCHIP_VENDOR_JOURNAL */
+
+/*
+ * Read an item from the vendor storage of an eMMC through @read, without
+ * going through its block device. This is for items which are needed while
+ * the card is still being set up, e.g. the sample phase used to tune it, so
+ * only the headers of each vendor copy and the blocks holding the item are
+ * read, one or two blocks at a time. With CONFIG_ROCKCHIP_VENDOR_JOURNAL the
+ * first block of each half of the log is read, then the whole of the newer
+ * half; the vendor copies are only read if there is no log.
+ *
+ * @read: read @n_sec blocks at @sec, returns the number of blocks read;
+ * @priv: passed to @read;
+ * @id: item id;
+ * @pbuf: read data buffer;
+ * @size: read bytes;
+ *
+ * return: bytes read on success, other fail;
+ */
+int emmc_vendor_storage_peek(int (*read)(void *priv, u32 sec, u32 n_sec,
+					 void *buffer),
+			     void *priv, u16 id, void *pbuf, u16 size)
+{
+	const u32 hdr_blks = DIV_ROUND_UP(EMMC_VENDOR_DATA_OFFSET,
+					  VENDOR_BLOCK_SIZE);
+	struct vendor_hdr *hdr;
+	struct vendor_item *item;
+	u32 max_ver = 0, max_index = 0;
+	u32 i, base, start, n_sec;
+	u32 *version2;
+	u8 *buffer, *data;
+	int ret;
+
+#ifdef CONFIG_ROCKCHIP_VENDOR_JOURNAL
+	ret = emmc_vendor_log_peek(read, priv, id, pbuf, size);
+	if (ret != -ENOENT)
+		return ret;
+#endif
+	buffer = memalign(ARCH_DMA_MINALIGN, hdr_blks * VENDOR_BLOCK_SIZE);
+	if (!buffer)
+		return -ENOMEM;
+	hdr = (struct vendor_hdr *)buffer;
+	item = (struct vendor_item *)(buffer + sizeof(struct vendor_hdr));
+	version2 = (u32 *)(buffer + VENDOR_BLOCK_SIZE +
+			   EMMC_VENDOR_VERSION2_OFFSET % VENDOR_BLOCK_SIZE);
+
+	/* Same rules as vendor_storage_init(), see there */
+	for (i = 0; i < VENDOR_PART_NUM; i++) {
+		base = EMMC_VENDOR_PART_OFFSET + EMMC_VENDOR_PART_BLKS * i;
+		if (read(priv, base, 1, buffer) != 1 ||
+		    read(priv, base + EMMC_VENDOR_PART_BLKS - 1, 1,
+			 buffer + VENDOR_BLOCK_SIZE) != 1) {
+			ret = -EIO;
+			goto out;
+		}
+		if (hdr->tag == VENDOR_TAG && *version2 == hdr->version &&
+		    max_ver < hdr->version) {
+			max_index = i;
+			max_ver = hdr->version;
+		}
+	}
+	if (!max_ver) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	base = EMMC_VENDOR_PART_OFFSET + EMMC_VENDOR_PART_BLKS * max_index;
+	if (read(priv, base, hdr_blks, buffer) != hdr_blks) {
+		ret = -EIO;
+		goto out;
+	}
+	for (i = 0; i < hdr->item_num && i < EMMC_VENDOR_ITEM_NUM; i++) {
+		if (item[i].id == id)
+			break;
+	}
+	if (i == hdr->item_num || i == EMMC_VENDOR_ITEM_NUM) {
+		debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (size > item[i].size)
+		size = item[i].size;
+	start = EMMC_VENDOR_DATA_OFFSET + item[i].offset;
+	n_sec = DIV_ROUND_UP(start + size, VENDOR_BLOCK_SIZE) -
+		start / VENDOR_BLOCK_SIZE;
+	data = memalign(ARCH_DMA_MINALIGN, n_sec * VENDOR_BLOCK_SIZE);
+	if (!data) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	if (read(priv, base + start / VENDOR_BLOCK_SIZE, n_sec, data) ==
+	    n_sec) {
+		memcpy(pbuf, data + start % VENDOR_BLOCK_SIZE, size);
+		ret = size;
+	} else {
+		ret = -EIO;
+	}
+	free(data);
+out:
+	free(buffer);
+	return ret;
+}
+
 /**********************************************************/
 /*              vendor API uinit test                      */
 /**********************************************************/
+#ifdef CONFIG_ROCKCHIP_VENDOR_JOURNAL
+/* Reset the vendor storage space to the initial state */
+static void vendor_test_reset(void)
+{
+	u32 blks = vendor_log.half_blks * 2;
+
+	memset(vendor_log.index, 0, sizeof(vendor_log.index));
+	vendor_log.item_num = 0;
+	vendor_log.live = sizeof(struct vendor_log_hdr);
+	vendor_log.version = 0;
+	memset(vendor_log.buf, 0, blks * VENDOR_BLOCK_SIZE);
+	vendor_log_start(0);
+	/* write to flash. */
+	if (vendor_ops(vendor_log.buf, 0, blks, 1) == blks)
+		vendor_log.saved = true;
+}
+
+/* Bytes left for the data of item_num items */
+static u32 vendor_test_data_size(u16 item_num)
+{
+	return vendor_log.size - sizeof(struct vendor_log_hdr) -
+	       item_num * vendor_rec_len(0);
+}
+#else
 /* Reset the vendor storage space to the initial state */
 static void vendor_test_reset(void)
 {
@@ -545,6 +1265,13 @@ static void vendor_test_reset(void)
 		vendor_ops((u8 *)vendor_info.hdr, part_size * i, part_size, 1);
 }
 
+static u32 vendor_test_data_size(u16 item_num)
+{
+	return (unsigned long)vendor_info.hash -
+	       (unsigned long)vendor_info.data;
+}
+#endif
+
 /*
  * A total of four tests
  * 1.All items test.
@@ -575,21 +1302,18 @@ int vendor_storage_test(void)
 	switch (bootdev_type) {
 	case IF_TYPE_MMC:
 		item_num = EMMC_VENDOR_ITEM_NUM;
-		total_size = (unsigned long)vendor_info.hash -
-			     (unsigned long)vendor_info.data;
+		total_size = vendor_test_data_size(item_num);
 		size = total_size/item_num;
 		break;
 	case IF_TYPE_RKNAND:
 	case IF_TYPE_SPINAND:
 		item_num = NAND_VENDOR_ITEM_NUM;
-		total_size = (unsigned long)vendor_info.hash -
-			     (unsigned long)vendor_info.data;
+		total_size = vendor_test_data_size(item_num);
 		size = total_size/item_num;
 		break;
 	case IF_TYPE_SPINOR:
 		item_num = FLASH_VENDOR_ITEM_NUM;
-		total_size = (unsigned long)vendor_info.hash -
-			     (unsigned long)vendor_info.data;
+		total_size = vendor_test_data_size(item_num);
 		size = total_size/item_num;
 		break;
 	default:
@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <libfdt.h>
 #include <os.h>
+#include <smp_job.h>
 #include <asm/io.h>
 #include <asm/state.h>
 #include <dm/root.h>
@@ -27,6 +28,7 @@ void sandbox_exit(void)
 {
 	/* Do this here while it still has an effect */
 	os_fd_restore();
+	smp_job_exit();
 	if (state_uninit())
 		os_exit(2);
 
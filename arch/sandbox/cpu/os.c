@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -609,3 +610,69 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_yday = tm->tm_yday;
 	rt->tm_isdst = tm->tm_isdst;
 }
+
+static pthread_mutex_t os_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t os_thread_cond = PTHREAD_COND_INITIALIZER;
+
+struct os_thread {
+	pthread_t thread;
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static void *os_thread_start(void *data)
+{
+	struct os_thread *thread = data;
+
+	thread->func(thread->arg);
+
+	return NULL;
+}
+
+int os_thread_create(void (*func)(void *arg), void *arg, void **threadp)
+{
+	struct os_thread *thread;
+	int ret;
+
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	thread->func = func;
+	thread->arg = arg;
+	ret = pthread_create(&thread->thread, NULL, os_thread_start, thread);
+	if (ret) {
+		os_free(thread);
+		return -ret;
+	}
+	*threadp = thread;
+
+	return 0;
+}
+
+void os_thread_join(void *data)
+{
+	struct os_thread *thread = data;
+
+	pthread_join(thread->thread, NULL);
+	os_free(thread);
+}
+
+void os_thread_wait(unsigned long usec)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += usec * 1000;
+	ts.tv_sec += ts.tv_nsec / 1000000000;
+	ts.tv_nsec %= 1000000000;
+	pthread_mutex_lock(&os_thread_mutex);
+	pthread_cond_timedwait(&os_thread_cond, &os_thread_mutex, &ts);
+	pthread_mutex_unlock(&os_thread_mutex);
+}
+
+void os_thread_wake(void)
+{
+	pthread_mutex_lock(&os_thread_mutex);
+	pthread_cond_broadcast(&os_thread_cond);
+	pthread_mutex_unlock(&os_thread_mutex);
+}
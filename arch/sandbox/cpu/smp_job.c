@@ -0,0 +1,50 @@
+/*
+ * Emulate secondary CPUs with host threads
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <os.h>
+#include <smp_job.h>
+
+/* Emulate a quad-core SoC */
+#define SANDBOX_SMP_JOB_CPUS	3
+
+static void sandbox_smp_job_entry(void *arg)
+{
+	smp_job_worker(arg);
+}
+
+int smp_job_arch_start(struct smp_job_cpu *cpus, int max)
+{
+	int count = min(max, SANDBOX_SMP_JOB_CPUS);
+	int i;
+
+	for (i = 0; i < count; i++) {
+		cpus[i].id = i + 1;
+		if (os_thread_create(sandbox_smp_job_entry, &cpus[i],
+				     &cpus[i].priv))
+			break;
+	}
+
+	return i;
+}
+
+void smp_job_arch_stop(struct smp_job_cpu *cpus, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		os_thread_join(cpus[i].priv);
+}
+
+void smp_job_arch_idle(void)
+{
+	os_thread_wait(1000);
+}
+
+void smp_job_arch_kick(void)
+{
+	os_thread_wake();
+}
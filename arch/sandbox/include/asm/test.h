@@ -79,4 +79,20 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_serial_set_tx_busy() - Make a serial device refuse output
+ *
+ * @dev:	Serial device
+ * @count:	Number of calls to its putc() method which find the TX FIFO full
+ */
+void sandbox_serial_set_tx_busy(struct udevice *dev, int count);
+
+/**
+ * sandbox_serial_get_tx_count() - Get the number of characters written
+ *
+ * @dev:	Serial device
+ * @return number of characters the device has written since it was probed
+ */
+ulong sandbox_serial_get_tx_count(struct udevice *dev);
+
 #endif
@@ -11,6 +11,7 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <smp_job.h>
 #include <asm/io.h>
 #include <asm/arch/boot_mode.h>
 
@@ -36,6 +37,9 @@ static int do_go(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	printf ("## Starting application at 0x%08lX ...\n", addr);
 
+	/* The application may be an OS which starts the other CPUs */
+	smp_job_exit();
+
 	/*
 	 * pass address parameter as argv[0] (aka command name),
 	 * and all remaining args
@@ -17,6 +17,7 @@
 #include <command.h>
 #include <elf.h>
 #include <net.h>
+#include <smp_job.h>
 #include <vxworks.h>
 #ifdef CONFIG_X86
 #include <asm/e820.h>
@@ -109,6 +110,9 @@ static unsigned long do_bootelf_exec(ulong (*entry)(int, char * const[]),
 {
 	unsigned long ret;
 
+	/* The image may be an OS which starts the other CPUs */
+	smp_job_exit();
+
 	/*
 	 * pass address parameter as argv[0] (aka command name),
 	 * and all remaining args
@@ -371,6 +375,7 @@ int do_bootvx(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	printf("## Starting vxWorks at 0x%08lx ...\n", addr);
 
+	smp_job_exit();
 	dcache_disable();
 #ifdef CONFIG_X86
 	/* VxWorks on x86 uses stack to pass parameters */
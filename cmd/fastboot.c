@@ -11,6 +11,7 @@
 #include <command.h>
 #include <console.h>
 #include <g_dnl.h>
+#include <mmc.h>
 #include <net.h>
 #include <usb.h>
 
@@ -62,6 +63,7 @@ static int do_fastboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		goto exit;
 	}
 
+	mmc_write_cache_begin();
 	while (1) {
 		if (g_dnl_detach())
 			break;
@@ -69,6 +71,7 @@ static int do_fastboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 			break;
 		usb_gadget_handle_interrupts(controller_index);
 	}
+	mmc_write_cache_end();
 
 	ret = CMD_RET_SUCCESS;
 
@@ -72,7 +72,7 @@ static int do_host_info(cmd_tbl_t *cmdtp, int flag, int argc,
 		max_dev = dev;
 	}
 	int dev;
-	printf("%3s %12s %s\n", "dev", "blocks", "path");
+	printf("%3s %12s %8s %s\n", "dev", "blocks", "reads", "path");
 	for (dev = min_dev; dev <= max_dev; dev++) {
 		struct blk_desc *blk_dev;
 		int ret;
@@ -94,8 +94,8 @@ static int do_host_info(cmd_tbl_t *cmdtp, int flag, int argc,
 #else
 		host_dev = blk_dev->priv;
 #endif
-		printf("%12lu %s\n", (unsigned long)blk_dev->lba,
-		       host_dev->filename);
+		printf("%12lu %8lu %s\n", (unsigned long)blk_dev->lba,
+		       host_dev->reads, host_dev->filename);
 	}
 	return 0;
 }
@@ -13,6 +13,22 @@
 
 static int curr_device = -1;
 
+#if CONFIG_IS_ENABLED(MMC_CMD_STATS)
+static void print_mmc_cmd_stats(struct mmc *mmc)
+{
+	int i, n = 0;
+
+	puts("Commands Sent:");
+	for (i = 0; i < MMC_CMD_COUNT; i++) {
+		if (!mmc->cmd_count[i])
+			continue;
+		printf("%s CMD%d: %lu", n++ % 4 ? "," : "\n ", i,
+		       mmc->cmd_count[i]);
+	}
+	putc('\n');
+}
+#endif
+
 static void print_mmcinfo(struct mmc *mmc)
 {
 	int i;
@@ -87,6 +103,9 @@ static void print_mmcinfo(struct mmc *mmc)
 			}
 		}
 	}
+#if CONFIG_IS_ENABLED(MMC_CMD_STATS)
+	print_mmc_cmd_stats(mmc);
+#endif
 }
 static struct mmc *init_mmc_device(int dev, bool force_init)
 {
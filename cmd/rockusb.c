@@ -10,6 +10,7 @@
 #include <command.h>
 #include <console.h>
 #include <g_dnl.h>
+#include <mmc.h>
 #include <part.h>
 #include <usb.h>
 #include <usb_mass_storage.h>
@@ -200,6 +201,7 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		puts("\r\n");
 	}
 
+	mmc_write_cache_begin();
 	while (1) {
 		usb_gadget_handle_interrupts(controller_index);
 
@@ -219,6 +221,7 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	}
 
 cleanup_register:
+	mmc_write_cache_end();
 	g_dnl_unregister();
 cleanup_board:
 	board_usb_cleanup(controller_index, USB_INIT_DEVICE);
@@ -0,0 +1,104 @@
+/*
+ * LZ4 frame decompression command
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static int do_unlz4_bench(int argc, char *const argv[])
+{
+	ulong src, src_len, dst, dst_len, count = 10;
+	ulong start, us, copy, best = ~0UL;
+	size_t size = 0;
+	void *in, *out;
+	int i, ret;
+
+	if (argc < 5)
+		return CMD_RET_USAGE;
+	src = simple_strtoul(argv[1], NULL, 16);
+	src_len = simple_strtoul(argv[2], NULL, 16);
+	dst = simple_strtoul(argv[3], NULL, 16);
+	dst_len = simple_strtoul(argv[4], NULL, 16);
+	if (argc > 5)
+		count = max(simple_strtoul(argv[5], NULL, 10), 1UL);
+
+	in = map_sysmem(src, src_len);
+	out = map_sysmem(dst, dst_len);
+	for (i = 0; i < count; i++) {
+		size = dst_len;
+		start = timer_get_us();
+		ret = ulz4fn(in, src_len, out, &size);
+		us = timer_get_us() - start;
+		if (ret) {
+			printf("Decompression failed: %d\n", ret);
+			return CMD_RET_FAILURE;
+		}
+		best = min(best, max(us, 1UL));
+	}
+	printf("%zu bytes from %lu (%lu%%): %lu us, %lu MB/s\n", size, src_len,
+	       size ? (ulong)(src_len * 100ULL / size) : 0UL, best,
+	       (ulong)(size / best));
+
+	/* For reference, the time taken to copy the input */
+	copy = min(src_len, dst_len);
+	start = timer_get_us();
+	memcpy(out, in, copy);
+	us = max(timer_get_us() - start, 1UL);
+	printf("memcpy of %lu bytes: %lu us, %lu MB/s\n", copy, us, copy / us);
+	unmap_sysmem(out);
+	unmap_sysmem(in);
+
+	return 0;
+}
+
+static int do_unlz4(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
+{
+	ulong src, dst, src_len = 0, dst_len = 0;
+	size_t size;
+	int ret;
+
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return do_unlz4_bench(argc - 1, argv + 1);
+
+	switch (argc) {
+	case 4:
+		dst_len = simple_strtoul(argv[3], NULL, 16);
+		/* fall through */
+	case 3:
+		src = simple_strtoul(argv[1], NULL, 16);
+		dst = simple_strtoul(argv[2], NULL, 16);
+		break;
+	default:
+		return CMD_RET_USAGE;
+	}
+
+	/* The frame, and the output unless limited, may run to the end of RAM */
+	if (src < gd->ram_top)
+		src_len = gd->ram_top - src;
+	if (!dst_len && dst < gd->ram_top)
+		dst_len = gd->ram_top - dst;
+	size = dst_len;
+	ret = ulz4fn(map_sysmem(src, src_len), src_len, map_sysmem(dst, dst_len),
+		     &size);
+	if (ret) {
+		printf("Decompression failed: %d\n", ret);
+		return CMD_RET_FAILURE;
+	}
+	printf("Uncompressed size: %zu = %#zX\n", size, size);
+	env_set_hex("filesize", size);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	unlz4,	7,	1,	do_unlz4,
+	"lz4 uncompress a memory region",
+	"srcaddr dstaddr [dstsize]\n"
+	"unlz4 bench srcaddr srcsize dstaddr dstsize [count]\n"
+	"    - decompress 'count' times and report the best throughput"
+);
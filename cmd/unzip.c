@@ -7,6 +7,10 @@
 
 #include <common.h>
 #include <command.h>
+#include <gzip.h>
+#include <mapmem.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 static int do_unzip(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -86,3 +90,54 @@ U_BOOT_CMD(
 	"\t\tand is required for files with uncompressed lengths\n"
 	"\t\t4 GiB or larger\n"
 );
+
+#ifdef CONFIG_CMD_GZLOAD
+static int do_gzload(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct gunzip_src src;
+	ulong addr, len, dst_len = 0;
+	int ret;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+	addr = simple_strtoul(argv[3], NULL, 16);
+	if (argc > 5)
+		dst_len = simple_strtoul(argv[5], NULL, 16);
+	if (!dst_len && addr < gd->ram_top)
+		dst_len = gd->ram_top - addr;
+
+	if (argc > 4 && strcmp(argv[4], "-")) {
+		ret = gunzip_src_fs(&src, argv[1], argv[2], argv[4]);
+		if (ret) {
+			printf("** Cannot read %s: %d **\n", argv[4], ret);
+			return CMD_RET_FAILURE;
+		}
+	} else {
+		struct blk_desc *desc;
+		disk_partition_t info;
+
+		if (blk_get_device_part_str(argv[1], argv[2], &desc, &info,
+					    1) < 0)
+			return CMD_RET_FAILURE;
+		gunzip_src_blk(&src, desc, info.start,
+			       (u64)info.size * info.blksz);
+	}
+
+	ret = gunzip_stream(&src, map_sysmem(addr, dst_len), dst_len, &len);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	printf("Uncompressed size: %ld = 0x%lX\n", len, len);
+	env_set_hex("filesize", len);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	gzload,	6,	0,	do_gzload,
+	"decompress a gzip file or partition to memory",
+	"<interface> <dev[:part]> <addr> [<filename> [maxsize]]\n"
+	"\tfilename may be - or omitted to read the partition itself\n"
+	"\tmaxsize is the size in bytes (hex) of the output buffer\n"
+);
+#endif
@@ -282,6 +282,28 @@ static int setup_dest_addr(void)
 	gd->ram_top = board_get_usable_ram_top(gd->mon_len);
 	gd->relocaddr = gd->ram_top;
 	debug("Ram top: %08lX\n", (ulong)gd->ram_top);
+#ifdef CONFIG_SKIP_RELOCATE
+	/* The malloc() area is at a fixed address, with the rest below it */
+	if (CONFIG_SKIP_RELOCATE_TOP > gd->ram_top) {
+		printf("Run-in-place top %08lx is above RAM top %08lx\n",
+		       (ulong)CONFIG_SKIP_RELOCATE_TOP, (ulong)gd->ram_top);
+		return -ENOMEM;
+	}
+	/*
+	 * The area must not cover the stack and global data used so far, which
+	 * lie below CONFIG_SYS_INIT_SP_ADDR and are still in use while it is
+	 * filled in
+	 */
+	if (CONFIG_SYS_INIT_SP_ADDR > CONFIG_SYS_TEXT_BASE &&
+	    (ulong)gd < CONFIG_SKIP_RELOCATE_TOP) {
+		printf("Initial stack %08lx-%08lx overlaps run-in-place area %08lx-%08lx\n",
+		       (ulong)gd, (ulong)CONFIG_SYS_INIT_SP_ADDR,
+		       (ulong)CONFIG_SYS_TEXT_BASE,
+		       (ulong)CONFIG_SKIP_RELOCATE_TOP);
+		return -EINVAL;
+	}
+	gd->relocaddr = CONFIG_SKIP_RELOCATE_TOP - TOTAL_MALLOC_LEN;
+#endif
 #if defined(CONFIG_MP) && (defined(CONFIG_MPC86xx) || defined(CONFIG_E500))
 	/*
 	 * We need to make sure the location we intend to put secondary core
@@ -389,6 +411,11 @@ static int reserve_trace(void)
 
 static int reserve_uboot(void)
 {
+#ifdef CONFIG_SKIP_RELOCATE
+	/* U-Boot stays where it was loaded, so is not given a copy */
+	gd->start_addr_sp = gd->relocaddr;
+	return 0;
+#endif
 	/*
 	 * reserve memory for U-Boot code, data & bss
 	 * round down to next 4 kB limit
@@ -411,6 +438,10 @@ static int reserve_uboot(void)
 /* reserve memory for malloc() area */
 static int reserve_malloc(void)
 {
+#ifdef CONFIG_SKIP_RELOCATE
+	/* Reserved by setup_dest_addr() above everything else */
+	return 0;
+#endif
 	gd->start_addr_sp = gd->start_addr_sp - TOTAL_MALLOC_LEN;
 	debug("Reserving %dk for malloc() at: %08lx\n",
 			TOTAL_MALLOC_LEN >> 10, gd->start_addr_sp);
@@ -625,10 +656,28 @@ static int setup_reloc(void)
 #else
 	gd->reloc_off = gd->relocaddr - CONFIG_SYS_TEXT_BASE;
 #endif
+#endif
+#ifdef CONFIG_SKIP_RELOCATE
+	/* Keep running at the link address, below what was reserved */
+	gd->relocaddr = (ulong)__image_copy_start;
+	gd->reloc_off = 0;
+	if (gd->relocaddr + gd->mon_len > gd->start_addr_sp) {
+		printf("U-Boot at %08lx-%08lx overlaps its data at %08lx\n",
+		       gd->relocaddr, gd->relocaddr + gd->mon_len,
+		       gd->start_addr_sp);
+		return -ENOSPC;
+	}
 #endif
 	memcpy(gd->new_gd, (char *)gd, sizeof(gd_t));
 
+#ifdef CONFIG_SKIP_RELOCATE
+	printf("Running in place at: %08lx\n", gd->relocaddr);
+	bootstage_mark_name(BOOTSTAGE_ID_RELOCATE, "run_in_place");
+#else
 	printf("Relocation Offset is: %08lx\n", gd->reloc_off);
+	/* The time from here to board_init_r is spent relocating */
+	bootstage_mark_name(BOOTSTAGE_ID_RELOCATE, "relocate");
+#endif
 	debug("Relocating to %08lx, new gd at %08lx, sp at %08lx\n",
 	      gd->relocaddr, (ulong)map_to_sysmem(gd->new_gd),
 	      gd->start_addr_sp);
@@ -243,8 +243,13 @@ static int initr_malloc(void)
 	debug("Pre-reloc malloc() used %#lx bytes (%ld KB)\n", gd->malloc_ptr,
 	      gd->malloc_ptr / 1024);
 #endif
+#ifdef CONFIG_SKIP_RELOCATE
+	/* The malloc area is at the top of what board_init_f() reserved */
+	malloc_start = CONFIG_SKIP_RELOCATE_TOP - TOTAL_MALLOC_LEN;
+#else
 	/* The malloc area is immediately below the monitor copy in DRAM */
 	malloc_start = gd->relocaddr - TOTAL_MALLOC_LEN;
+#endif
 	mem_malloc_init((ulong)map_sysmem(malloc_start, TOTAL_MALLOC_LEN),
 			TOTAL_MALLOC_LEN);
 	return 0;
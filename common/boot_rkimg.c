@@ -404,6 +404,7 @@ int boot_rockchip_image(struct blk_desc *dev_desc, disk_partition_t *boot_part)
 		goto out;
 	}
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_RKIMG_LOAD, "rkimg_load");
 	kernel_size = read_rockchip_image(dev_desc, &kernel_part,
 					  (void *)kernel_addr_r);
 	if (kernel_size < 0) {
@@ -428,6 +429,11 @@ int boot_rockchip_image(struct blk_desc *dev_desc, disk_partition_t *boot_part)
 			goto out;
 		}
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_RKIMG_LOAD);
+
+	/* The ramdisk is read to where it is booted from, so leave it there */
+	if (ramdisk_size)
+		boot_ramdisk_placed(ramdisk_addr_r, ramdisk_size);
 
 	printf("kernel   @ 0x%08lx (0x%08x)\n", kernel_addr_r, kernel_size);
 	printf("ramdisk  @ 0x%08lx (0x%08x)\n", ramdisk_addr_r, ramdisk_size);
@@ -277,6 +277,27 @@ struct variables {
 	struct variables *next;
 };
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * A script run with parse_string_outer(), kept parsed so that running the
+ * same text again (bootcmd, a "run" target, a retry loop) does not parse it
+ * again. Scripts are found by their text, so one held in a variable which
+ * has changed since is simply not found.
+ */
+struct hush_script {
+	char *text;
+	uint hash;
+	int flag;			/* FLAG_... it was parsed with */
+	struct pipe **lists;		/* list for each line, in order */
+	int count;
+	int busy;			/* number of runs in progress */
+	int incomplete;			/* not all of the text was parsed */
+	ulong last_used;
+};
+#else
+struct hush_script;
+#endif
+
 /* globals, connect us to the outside world
  * the first three support $?, $#, and $1 */
 #ifndef __U_BOOT__
@@ -308,6 +329,10 @@ struct variables *top_vars = &shell_ver;
 static int flag_repeat = 0;
 static int do_repeat = 0;
 static struct variables *top_vars = NULL ;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+static struct hush_script script_cache[CONFIG_HUSH_PARSE_CACHE_SIZE];
+static ulong script_cache_runs;
+#endif
 #endif /*__U_BOOT__ */
 
 #define B_CHUNK (100)
@@ -479,7 +504,8 @@ static int parse_string(o_string *dest, struct p_context *ctx, const char *src);
 #endif
 static int parse_stream(o_string *dest, struct p_context *ctx, struct in_str *input0, int end_trigger);
 /*   setup: */
-static int parse_stream_outer(struct in_str *inp, int flag);
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct hush_script *keep);
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag);
 static int parse_file_outer(FILE *f);
@@ -1553,6 +1579,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1619,6 +1646,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* Count down a copy, the pipe may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1627,11 +1656,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1764,6 +1793,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *for_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,7 +1833,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					break;
 				}
 #endif
 				flag_restore = 0;
@@ -1833,6 +1864,7 @@ static int run_list_real(struct pipe *pi)
 					pi->progs->argv[0]);
 				save_list = list;
 				save_name = pi->progs->argv[0];
+				for_pipe = pi;
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
 			}
@@ -1903,7 +1935,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			break;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1923,6 +1956,14 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+	if (list) {
+		/* Leave a loop which was cut short as it was parsed */
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
 	return rcode;
 }
 
@@ -3182,7 +3223,125 @@ static void update_ifs_map(void)
 
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
-static int parse_stream_outer(struct in_str *inp, int flag)
+#ifdef CONFIG_HUSH_PARSE_CACHE
+static uint script_hash(const char *s)
+{
+	uint hash = 0;
+
+	while (*s)
+		hash = hash * 31 + (uchar)*s++;
+
+	return hash;
+}
+
+static void script_free(struct hush_script *script)
+{
+	int i;
+
+	for (i = 0; i < script->count; i++)
+		free_pipe_list(script->lists[i], 0);
+	free(script->lists);
+	free(script->text);
+	memset(script, '\0', sizeof(*script));
+}
+
+static struct hush_script *script_find(const char *s, int flag)
+{
+	uint hash = script_hash(s);
+	struct hush_script *script;
+
+	for (script = script_cache;
+	     script < script_cache + ARRAY_SIZE(script_cache); script++) {
+		if (script->text && script->hash == hash &&
+		    script->flag == flag && !strcmp(script->text, s))
+			return script;
+	}
+
+	return NULL;
+}
+
+/* Keep a script which has been parsed, in place of the least used one */
+static void script_store(struct hush_script *new)
+{
+	struct hush_script *script, *slot = NULL;
+
+	if (new->incomplete || !new->text ||
+	    script_find(new->text, new->flag)) {
+		script_free(new);
+		return;
+	}
+	for (script = script_cache;
+	     script < script_cache + ARRAY_SIZE(script_cache); script++) {
+		if (script->busy)
+			continue;
+		if (!slot || (slot->text && (!script->text ||
+		    script->last_used < slot->last_used)))
+			slot = script;
+	}
+	if (!slot) {
+		script_free(new);
+		return;
+	}
+	script_free(slot);
+	*slot = *new;
+	slot->last_used = ++script_cache_runs;
+}
+
+/* Run a list just parsed by parse_stream_outer(), then keep it */
+static int script_keep_list(struct hush_script *script, struct pipe *pi)
+{
+	struct pipe **lists;
+	int code;
+
+	code = run_list_real(pi);
+	lists = realloc(script->lists, (script->count + 1) * sizeof(*lists));
+	if (!lists) {
+		free_pipe_list(pi, 0);
+		script->incomplete = 1;
+		return code;
+	}
+	lists[script->count++] = pi;
+	script->lists = lists;
+
+	return code;
+}
+
+/* Run a kept script, as parse_stream_outer() would have */
+static int script_run(struct hush_script *script)
+{
+	int code = 1;
+	int i;
+
+	script->busy++;
+	script->last_used = ++script_cache_runs;
+	for (i = 0; i < script->count; i++) {
+		code = run_list_real(script->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	script->busy--;
+
+	return (code != 0) ? 1 : 0;
+}
+
+void hush_script_cache_flush(void)
+{
+	struct hush_script *script;
+
+	for (script = script_cache;
+	     script < script_cache + ARRAY_SIZE(script_cache); script++) {
+		if (!script->busy)
+			script_free(script);
+	}
+}
+#endif
+
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct hush_script *keep)
 {
 
 	struct p_context ctx;
@@ -3214,10 +3373,20 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
-			code = run_list(ctx.list_head);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (keep)
+				code = script_keep_list(keep, ctx.list_head);
+			else
+#endif
+				code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
 				code = 0;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+				/* The rest of the text was not parsed */
+				if (keep && b_peek(inp))
+					keep->incomplete = 1;
+#endif
 				/* XXX hackish way to not allow exit from main loop */
 				if (inp->peek == file_peek) {
 					printf("exit not allowed from main input shell.\n");
@@ -3236,6 +3405,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifdef __U_BOOT__
 			if (inp->__promptme == 0) printf("<INTERRUPT>\n");
 			inp->__promptme = 1;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (keep)
+				keep->incomplete = 1;
+#endif
 #endif
 			temp.nonnull = 0;
 			temp.quote = 0;
@@ -3256,7 +3429,8 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
-int parse_string_outer(const char *s, int flag)
+static int parse_string_keep(const char *s, int flag,
+			     struct hush_script *keep)
 #endif	/* __U_BOOT__ */
 {
 	struct in_str input;
@@ -3272,18 +3446,53 @@ int parse_string_outer(const char *s, int flag)
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
+		rcode = parse_stream_outer(&input, flag, keep);
 		free(p);
 		return rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
-	return parse_stream_outer(&input, flag);
+	return parse_stream_outer(&input, flag, keep);
 #ifdef __U_BOOT__
 	}
 #endif
 }
 
+#ifdef __U_BOOT__
+int parse_string_outer(const char *s, int flag)
+{
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct hush_script *script, new;
+	int rcode;
+
+	/* Text made by expanding variables is seldom run twice */
+	if (!s || !*s || (flag & FLAG_REPARSING))
+		return parse_string_keep(s, flag, NULL);
+
+	/*
+	 * A script which is running has its loop variables written into its
+	 * parse tree, so one which runs itself is parsed again
+	 */
+	script = script_find(s, flag);
+	if (script && script->busy)
+		return parse_string_keep(s, flag, NULL);
+	if (script)
+		return script_run(script);
+
+	memset(&new, '\0', sizeof(new));
+	new.text = strdup(s);
+	new.hash = script_hash(s);
+	new.flag = flag;
+	rcode = parse_string_keep(s, flag, &new);
+	script_store(&new);
+
+	return rcode;
+#else
+	return parse_string_keep(s, flag, NULL);
+#endif
+}
+#endif	/* __U_BOOT__ */
+
 #ifndef __U_BOOT__
 static int parse_file_outer(FILE *f)
 #else
@@ -3297,7 +3506,7 @@ int parse_file_outer(void)
 #else
 	setup_file_in_str(&input);
 #endif
-	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON);
+	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON, NULL);
 	return rcode;
 }
 
@@ -18,6 +18,11 @@
 #include <hw_sha.h>
 #include <asm/io.h>
 #include <linux/errno.h>
+#if CONFIG_IS_ENABLED(DM_HASH)
+#include <dm.h>
+#include <u-boot/hash.h>
+#define USE_DM_HASH
+#endif
 #else
 #include "mkimage.h"
 #include <time.h>
@@ -28,9 +33,74 @@
 #include <u-boot/crc.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
 #include <u-boot/md5.h>
 
-#if defined(CONFIG_SHA1) && !defined(CONFIG_SHA_PROG_HW_ACCEL)
+#ifdef USE_DM_HASH
+/*
+ * Progressive hashing through the hash uclass. The context records the
+ * engine chosen at init time so that update/finish go to the same one.
+ */
+struct hash_dm_ctx {
+	struct udevice *dev;
+	void *ctx;
+};
+
+static int hash_init_dm(struct hash_algo *algo, void **ctxp)
+{
+	enum HASH_ALGO id = hash_algo_lookup_by_name(algo->name);
+	struct hash_dm_ctx *dctx;
+	struct udevice *dev;
+
+	if (hash_get_device(id, &dev))
+		return -1;
+
+	dctx = malloc(sizeof(*dctx));
+	if (!dctx)
+		return -1;
+	dctx->dev = dev;
+	if (hash_init(dev, id, &dctx->ctx)) {
+		free(dctx);
+		return -1;
+	}
+	*ctxp = dctx;
+
+	return 0;
+}
+
+static int hash_update_dm(struct hash_algo *algo, void *ctx, const void *buf,
+			  unsigned int size, int is_last)
+{
+	struct hash_dm_ctx *dctx = ctx;
+
+	if (hash_update(dctx->dev, dctx->ctx, buf, size)) {
+		free(dctx);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int hash_finish_dm(struct hash_algo *algo, void *ctx, void *dest_buf,
+			  int size)
+{
+	struct hash_dm_ctx *dctx = ctx;
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+	int ret;
+
+	/* Still finish the hash, so that the engine frees its context */
+	ret = hash_finish(dctx->dev, dctx->ctx,
+			  size < algo->digest_size ? digest : dest_buf);
+	free(dctx);
+	if (size < algo->digest_size)
+		return -1;
+
+	return ret ? -1 : 0;
+}
+#endif
+
+#if defined(CONFIG_SHA1) && !defined(CONFIG_SHA_PROG_HW_ACCEL) && \
+	!defined(USE_DM_HASH)
 static int hash_init_sha1(struct hash_algo *algo, void **ctxp)
 {
 	sha1_context *ctx = malloc(sizeof(sha1_context));
@@ -58,7 +128,8 @@ static int hash_finish_sha1(struct hash_algo *algo, void *ctx, void *dest_buf,
 }
 #endif
 
-#if defined(CONFIG_SHA256) && !defined(CONFIG_SHA_PROG_HW_ACCEL)
+#if defined(CONFIG_SHA256) && !defined(CONFIG_SHA_PROG_HW_ACCEL) && \
+	!defined(USE_DM_HASH)
 static int hash_init_sha256(struct hash_algo *algo, void **ctxp)
 {
 	sha256_context *ctx = malloc(sizeof(sha256_context));
@@ -86,6 +157,34 @@ static int hash_finish_sha256(struct hash_algo *algo, void *ctx, void
 }
 #endif
 
+#if defined(CONFIG_SHA512) && !defined(USE_DM_HASH)
+static int hash_init_sha512(struct hash_algo *algo, void **ctxp)
+{
+	sha512_context *ctx = malloc(sizeof(sha512_context));
+	sha512_starts(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_sha512(struct hash_algo *algo, void *ctx,
+			      const void *buf, unsigned int size, int is_last)
+{
+	sha512_update((sha512_context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_sha512(struct hash_algo *algo, void *ctx, void
+			      *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	sha512_finish((sha512_context *)ctx, dest_buf);
+	free(ctx);
+	return 0;
+}
+#endif
+
 static int hash_init_crc32(struct hash_algo *algo, void **ctxp)
 {
 	uint32_t *ctx = malloc(sizeof(uint32_t));
@@ -128,10 +227,14 @@ static struct hash_algo hash_algo[] = {
 #else
 		.hash_func_ws	= sha1_csum_wd,
 #endif
-#ifdef CONFIG_SHA_PROG_HW_ACCEL
+#if defined(CONFIG_SHA_PROG_HW_ACCEL)
 		.hash_init	= hw_sha_init,
 		.hash_update	= hw_sha_update,
 		.hash_finish	= hw_sha_finish,
+#elif defined(USE_DM_HASH)
+		.hash_init	= hash_init_dm,
+		.hash_update	= hash_update_dm,
+		.hash_finish	= hash_finish_dm,
 #else
 		.hash_init	= hash_init_sha1,
 		.hash_update	= hash_update_sha1,
@@ -149,16 +252,37 @@ static struct hash_algo hash_algo[] = {
 #else
 		.hash_func_ws	= sha256_csum_wd,
 #endif
-#ifdef CONFIG_SHA_PROG_HW_ACCEL
+#if defined(CONFIG_SHA_PROG_HW_ACCEL)
 		.hash_init	= hw_sha_init,
 		.hash_update	= hw_sha_update,
 		.hash_finish	= hw_sha_finish,
+#elif defined(USE_DM_HASH)
+		.hash_init	= hash_init_dm,
+		.hash_update	= hash_update_dm,
+		.hash_finish	= hash_finish_dm,
 #else
 		.hash_init	= hash_init_sha256,
 		.hash_update	= hash_update_sha256,
 		.hash_finish	= hash_finish_sha256,
 #endif
 	},
+#endif
+#ifdef CONFIG_SHA512
+	{
+		.name		= "sha512",
+		.digest_size	= SHA512_SUM_LEN,
+		.chunk_size	= CHUNKSZ_SHA512,
+		.hash_func_ws	= sha512_csum_wd,
+#ifdef USE_DM_HASH
+		.hash_init	= hash_init_dm,
+		.hash_update	= hash_update_dm,
+		.hash_finish	= hash_finish_dm,
+#else
+		.hash_init	= hash_init_sha512,
+		.hash_update	= hash_update_sha512,
+		.hash_finish	= hash_finish_sha512,
+#endif
+	},
 #endif
 	{
 		.name		= "crc32",
@@ -233,6 +357,19 @@ int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 	return 0;
 }
 
+/* Hash a buffer in one go, preferring the hash uclass if it is enabled */
+static void hash_algo_digest(struct hash_algo *algo, const void *buf,
+			     unsigned int len, uint8_t *output)
+{
+#ifdef USE_DM_HASH
+	int size = algo->digest_size;
+
+	if (!hash_digest_by_name(algo->name, buf, len, output, &size))
+		return;
+#endif
+	algo->hash_func_ws(buf, len, output, algo->chunk_size);
+}
+
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size)
 {
@@ -250,7 +387,7 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	}
 	if (output_size)
 		*output_size = algo->digest_size;
-	algo->hash_func_ws(data, len, output, algo->chunk_size);
+	hash_algo_digest(algo, data, len, output);
 
 	return 0;
 }
@@ -406,7 +543,7 @@ int hash_command(const char *algo_name, int flags, cmd_tbl_t *cmdtp, int flag,
 		}
 
 		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+		hash_algo_digest(algo, buf, len, output);
 		unmap_sysmem(buf);
 
 		/* Try to avoid code bloat when verify is not needed */
@@ -7,9 +7,12 @@
 #include <common.h>
 #include <image.h>
 #include <android_image.h>
+#include <lmb.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <errno.h>
+#include <gzip.h>
+#include <memalign.h>
 #ifdef CONFIG_RKIMG_BOOTLOADER
 #include <asm/arch/resource_img.h>
 #endif
@@ -17,8 +20,32 @@
 #define ANDROID_IMAGE_DEFAULT_KERNEL_ADDR	0x10008000
 #define ANDROID_ARG_FDT_FILENAME "rk-kernel.dtb"
 
+#define LZ4F_MAGIC				0x184d2204
+#define LZ4_LEGACY_MAGIC			0x184c2102
+
+DECLARE_GLOBAL_DATA_PTR;
+
 static char andr_tmp_str[ANDR_BOOT_ARGS_SIZE + 1];
 
+/*
+ * Where android_image_load() put the parts of the image it last loaded, which
+ * are not all at their offset from the header
+ */
+static struct {
+	struct andr_img_hdr hdr;	/* Copy of the header, to spot a new image */
+	ulong addr;			/* Address of the header, 0 if none */
+	ulong kernel;
+	ulong ramdisk;
+	ulong ramdisk_size;		/* Size once decompressed */
+	ulong second;
+} android_layout;
+
+static bool android_image_is_loaded(const struct andr_img_hdr *hdr)
+{
+	return android_layout.addr && map_to_sysmem(hdr) == android_layout.addr &&
+	       !memcmp(hdr, &android_layout.hdr, sizeof(*hdr));
+}
+
 static ulong android_image_get_kernel_addr(const struct andr_img_hdr *hdr)
 {
 	/*
@@ -97,7 +124,9 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 
 	env_set("bootargs", newbootargs);
 
-	if (os_data) {
+	if (os_data && android_image_is_loaded(hdr)) {
+		*os_data = android_layout.kernel;
+	} else if (os_data) {
 		*os_data = (ulong)hdr;
 		*os_data += hdr->page_size;
 	}
@@ -143,11 +172,17 @@ int android_image_get_ramdisk(const struct andr_img_hdr *hdr,
 	printf("RAM disk load addr 0x%08x size %u KiB\n",
 	       hdr->ramdisk_addr, DIV_ROUND_UP(hdr->ramdisk_size, 1024));
 
-	*rd_data = (unsigned long)hdr;
-	*rd_data += hdr->page_size;
-	*rd_data += ALIGN(hdr->kernel_size, hdr->page_size);
+	if (android_image_is_loaded(hdr)) {
+		*rd_data = android_layout.ramdisk;
+	} else {
+		*rd_data = (unsigned long)hdr;
+		*rd_data += hdr->page_size;
+		*rd_data += ALIGN(hdr->kernel_size, hdr->page_size);
+	}
 
 	*rd_len = hdr->ramdisk_size;
+	if (android_image_is_loaded(hdr))
+		*rd_len = android_layout.ramdisk_size;
 	return 0;
 }
 
@@ -175,10 +210,14 @@ int android_image_get_fdt(const struct andr_img_hdr *hdr,
 	printf("FDT load addr 0x%08x size %u KiB\n",
 	       hdr->second_addr, DIV_ROUND_UP(hdr->second_size, 1024));
 
-	*rd_data = (unsigned long)hdr;
-	*rd_data += hdr->page_size;
-	*rd_data += ALIGN(hdr->kernel_size, hdr->page_size);
-	*rd_data += ALIGN(hdr->ramdisk_size, hdr->page_size);
+	if (android_image_is_loaded(hdr)) {
+		*rd_data = android_layout.second;
+	} else {
+		*rd_data = (unsigned long)hdr;
+		*rd_data += hdr->page_size;
+		*rd_data += ALIGN(hdr->kernel_size, hdr->page_size);
+		*rd_data += ALIGN(hdr->ramdisk_size, hdr->page_size);
+	}
 #ifdef CONFIG_RKIMG_BOOTLOADER
 	*rd_data += (rockchip_get_resource_file((void *)*rd_data,
 		     ANDROID_ARG_FDT_FILENAME))
@@ -189,54 +228,317 @@ int android_image_get_fdt(const struct andr_img_hdr *hdr,
 	return 0;
 }
 
+static void android_image_lmb_init(struct lmb *lmb)
+{
+	lmb_init(lmb);
+#ifdef CONFIG_NR_DRAM_BANKS
+	int i;
+
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		lmb_add(lmb, gd->bd->bi_dram[i].start,
+			gd->bd->bi_dram[i].size);
+	}
+#else
+	lmb_add(lmb, env_get_bootm_low(), env_get_bootm_size());
+#endif
+	arch_lmb_reserve(lmb);
+	board_lmb_reserve(lmb);
+}
+
+/*
+ * Pick where to read a part of the image: @dest, its final address, if that
+ * memory is free, else @blob, its place in a contiguous image, from where
+ * bootm copies it as before. Returns 0 if neither is free.
+ */
+static ulong android_image_place(struct lmb *lmb, ulong dest, ulong blob,
+				 ulong size)
+{
+#ifdef CONFIG_LMB
+	if (lmb_alloc_addr(lmb, dest, size) == dest)
+		return dest;
+	if (dest != blob && lmb_alloc_addr(lmb, blob, size) == blob)
+		return blob;
+
+	return 0;
+#else
+	return blob;
+#endif
+}
+
+/*
+ * Read @size bytes from @offset in the partition to @addr. Whole blocks are
+ * read straight to @addr, and only a partial last block is bounced so that
+ * nothing past the end of the part is written.
+ */
+static int android_image_read(struct blk_desc *dev_desc,
+			      const disk_partition_t *part_info, ulong offset,
+			      ulong size, ulong addr)
+{
+	ulong blksz = part_info->blksz;
+	lbaint_t start = part_info->start + offset / blksz;
+	lbaint_t blk_cnt = size / blksz;
+	ulong tail = size % blksz;
+	void *buf;
+	int ret = 0;
+
+	buf = map_sysmem(addr, size);
+	if (blk_cnt && blk_dread(dev_desc, start, blk_cnt, buf) != blk_cnt)
+		ret = -EIO;
+	if (!ret && tail) {
+		ALLOC_CACHE_ALIGN_BUFFER(u8, bounce, blksz);
+
+		if (blk_dread(dev_desc, start + blk_cnt, 1, bounce) != 1)
+			ret = -EIO;
+		else
+			memcpy(buf + blk_cnt * blksz, bounce, tail);
+	}
+	unmap_sysmem(buf);
+
+	return ret;
+}
+
+#ifdef CONFIG_ANDROID_RAMDISK_DECOMPRESS
+/*
+ * Decompress a gzip or LZ4 ramdisk at @offset in the image to @dest. An LZ4
+ * ramdisk is read to @blob first. Returns 1 if the ramdisk was decompressed,
+ * 0 if it is to be loaded as it is, including when it does not fit or could
+ * not be decompressed, or -ve on error.
+ */
+static int android_image_unpack_ramdisk(struct blk_desc *dev_desc,
+					const disk_partition_t *part_info,
+					struct lmb *lmb, ulong offset,
+					ulong rd_size, ulong blob, ulong dest)
+{
+	ulong size = CONFIG_ANDROID_RAMDISK_DECOMPRESS_SIZE;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, magic, part_info->blksz);
+	bool gzip = false, lz4 = false;
+	size_t len = 0;
+	int ret = 0;
+
+	if (!dest || rd_size < sizeof(u32))
+		return 0;
+	if (blk_dread(dev_desc, part_info->start + offset / part_info->blksz,
+		      1, magic) != 1)
+		return -EIO;
+#if CONFIG_IS_ENABLED(GZIP_STREAM)
+	gzip = magic[0] == 0x1f && magic[1] == 0x8b;
+#endif
+#ifdef CONFIG_LZ4
+	lz4 = le32_to_cpu(*(u32 *)magic) == LZ4F_MAGIC ||
+	      le32_to_cpu(*(u32 *)magic) == LZ4_LEGACY_MAGIC;
+#endif
+	if (!gzip && !lz4)
+		return 0;
+	if (lmb_alloc_addr(lmb, dest, size) != dest) {
+		debug("No room to decompress Android ramdisk at 0x%lx\n", dest);
+		return 0;
+	}
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+#if CONFIG_IS_ENABLED(GZIP_STREAM)
+	if (gzip) {
+		struct gunzip_src src;
+		ulong out;
+
+		gunzip_src_blk(&src, dev_desc,
+			       part_info->start + offset / part_info->blksz,
+			       rd_size);
+		ret = gunzip_stream(&src, map_sysmem(dest, size), size, &out);
+		len = out;
+	}
+#endif
+#ifdef CONFIG_LZ4
+	if (lz4) {
+		if (lmb_alloc_addr(lmb, blob, rd_size) != blob) {
+			ret = -ENOSPC;
+		} else {
+			ret = android_image_read(dev_desc, part_info, offset,
+						 rd_size, blob);
+			len = size;
+			if (!ret)
+				ret = ulz4fn(map_sysmem(blob, rd_size),
+					     rd_size, map_sysmem(dest, size),
+					     &len);
+			lmb_free(lmb, blob, rd_size);
+		}
+	}
+#endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+	if (ret) {
+		/* The kernel can still decompress it */
+		printf("Android ramdisk decompression failed: err=%d, loading it compressed\n",
+		       ret);
+		lmb_free(lmb, dest, size);
+		return 0;
+	}
+	printf("Android ramdisk decompressed to 0x%lx, %lu KiB\n", dest,
+	       (ulong)DIV_ROUND_UP(len, 1024));
+	/* Give back the rest, keeping later reads cache-line aligned */
+	if (ALIGN(len, ARCH_DMA_MINALIGN) < size)
+		lmb_free(lmb, dest + ALIGN(len, ARCH_DMA_MINALIGN),
+			 size - ALIGN(len, ARCH_DMA_MINALIGN));
+	android_layout.ramdisk = dest;
+	android_layout.ramdisk_size = len;
+
+	return 1;
+}
+#else
+static inline int android_image_unpack_ramdisk(struct blk_desc *dev_desc,
+					const disk_partition_t *part_info,
+					struct lmb *lmb, ulong offset,
+					ulong rd_size, ulong blob, ulong dest)
+{
+	return 0;
+}
+#endif
+
+/*
+ * Read the kernel, ramdisk and second stage of the image whose header is at
+ * @load_address, each straight to where it is booted from if possible
+ */
+static int android_image_load_parts(struct blk_desc *dev_desc,
+				    const disk_partition_t *part_info,
+				    ulong load_address,
+				    const struct andr_img_hdr *hdr)
+{
+	ulong page_size = hdr->page_size;
+	ulong kernel_dest, ramdisk_dest;
+	struct lmb lmb;
+	int i, ret;
+	struct {
+		const char *name;
+		ulong size;
+		ulong dest;
+		ulong *addr;
+	} parts[] = {
+		{ "kernel", hdr->kernel_size, 0, &android_layout.kernel },
+		{ "ramdisk", hdr->ramdisk_size, 0, &android_layout.ramdisk },
+		{ "second", hdr->second_size, 0, &android_layout.second },
+	};
+	ulong offset = page_size;
+
+	/* The header stays at the load address for bootm to find */
+	android_image_lmb_init(&lmb);
+	lmb_reserve(&lmb, load_address, page_size);
+
+	/* See android_image_get_kernel_addr() */
+	if (hdr->kernel_addr == ANDROID_IMAGE_DEFAULT_KERNEL_ADDR)
+		kernel_dest = load_address + page_size;
+	else
+		kernel_dest = hdr->kernel_addr;
+	ramdisk_dest = env_get_ulong("ramdisk_addr_r", 16, 0);
+	parts[0].dest = kernel_dest;
+	parts[1].dest = ramdisk_dest;
+
+	for (i = 0; i < ARRAY_SIZE(parts); i++) {
+		ulong blob = load_address + offset;
+
+		offset += ALIGN(parts[i].size, page_size);
+		*parts[i].addr = blob;
+		if (!parts[i].size)
+			continue;
+		if (parts[i].addr == &android_layout.ramdisk) {
+			android_layout.ramdisk_size = parts[i].size;
+			ret = android_image_unpack_ramdisk(dev_desc, part_info,
+						&lmb, blob - load_address,
+						parts[i].size, blob,
+						ramdisk_dest);
+			if (ret < 0)
+				return ret;
+			else if (ret)
+				continue;
+		}
+		if (!parts[i].dest)
+			parts[i].dest = blob;
+		*parts[i].addr = android_image_place(&lmb, parts[i].dest, blob,
+						     parts[i].size);
+		if (!*parts[i].addr) {
+			printf("Android image %s overlaps reserved memory\n",
+			       parts[i].name);
+			return -ENOSPC;
+		}
+		debug("Loading Android %s (%lu bytes) to 0x%lx\n",
+		      parts[i].name, parts[i].size, *parts[i].addr);
+		ret = android_image_read(dev_desc, part_info,
+					 blob - load_address, parts[i].size,
+					 *parts[i].addr);
+		if (ret)
+			return ret;
+	}
+
+	/* bootm need not move a ramdisk which is already where it belongs */
+	if (hdr->ramdisk_size && ramdisk_dest &&
+	    android_layout.ramdisk == ramdisk_dest)
+		boot_ramdisk_placed(ramdisk_dest, android_layout.ramdisk_size);
+
+	return 0;
+}
+
 long android_image_load(struct blk_desc *dev_desc,
 			const disk_partition_t *part_info,
 			unsigned long load_address,
 			unsigned long max_size) {
-	void *buf;
-	long blk_cnt, blk_read = 0;
+	struct andr_img_hdr *hdr;
+	ulong blksz = part_info->blksz;
+	long blk_cnt = 0;
+	ulong size;
+	int ret;
 
-	if (max_size < part_info->blksz)
+	if (max_size < blksz)
 		return -1;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_ANDROID_LOAD, "android_load");
+	android_layout.addr = 0;
+
 	/* We don't know the size of the Android image before reading the header
 	 * so we don't limit the size of the mapped memory.
 	 */
-	buf = map_sysmem(load_address, 0 /* size */);
+	hdr = map_sysmem(load_address, 0 /* size */);
 
-	/* Read the Android header first and then read the rest. */
-	if (blk_dread(dev_desc, part_info->start, 1, buf) != 1)
-		blk_read = -1;
-
-	if (!blk_read && android_image_check_header(buf) != 0) {
+	/* Read the first block of the header, which has the sizes */
+	ret = android_image_read(dev_desc, part_info, 0, blksz, load_address);
+	if (!ret && android_image_check_header(hdr) != 0) {
 		printf("** Invalid Android Image header **\n");
-		blk_read = -1;
+		ret = -EINVAL;
 	}
-	if (!blk_read) {
-		blk_cnt = (android_image_get_end(buf) - (ulong)buf +
-			   part_info->blksz - 1) / part_info->blksz;
-		if (blk_cnt * part_info->blksz > max_size) {
-			debug("Android Image too big (%lu bytes, max %lu)\n",
-			      android_image_get_end(buf) - (ulong)buf,
-			      max_size);
-			blk_read = -1;
-		} else {
-			debug("Loading Android Image (%lu blocks) to 0x%lx... ",
-			      blk_cnt, load_address);
-			blk_read = blk_dread(dev_desc, part_info->start,
-					     blk_cnt, buf);
+	if (ret)
+		goto out;
+
+	size = android_image_get_end(hdr) - (ulong)hdr;
+	blk_cnt = DIV_ROUND_UP(size, blksz);
+	if (blk_cnt * blksz > max_size) {
+		debug("Android Image too big (%lu bytes, max %lu)\n",
+		      size, max_size);
+		ret = -EFBIG;
+	} else if (!hdr->page_size || hdr->page_size % blksz) {
+		/* Parts do not start on a block, so read the image as is */
+		debug("Loading Android Image (%lu blocks) to 0x%lx... ",
+		      blk_cnt, load_address);
+		ret = android_image_read(dev_desc, part_info, 0, size,
+					 load_address);
+	} else {
+		/* The rest of the header page, then the parts */
+		ret = android_image_read(dev_desc, part_info, blksz,
+					 hdr->page_size - blksz,
+					 load_address + blksz);
+		if (!ret)
+			ret = android_image_load_parts(dev_desc, part_info,
+						       load_address, hdr);
+		if (!ret) {
+			memcpy(&android_layout.hdr, hdr, sizeof(*hdr));
+			android_layout.addr = load_address;
 		}
 	}
 
-	unmap_sysmem(buf);
-	if (blk_read < 0)
-		return blk_read;
-
-	debug("%lu blocks read: %s\n",
-	      blk_read, (blk_read == blk_cnt) ? "OK" : "ERROR");
-	if (blk_read != blk_cnt)
+out:
+	unmap_sysmem(hdr);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_ANDROID_LOAD);
+	if (ret) {
+		debug("Android Image load failed: err=%d\n", ret);
 		return -1;
-	return blk_read;
+	}
+
+	return blk_cnt;
 }
 
 #if !defined(CONFIG_SPL_BUILD)
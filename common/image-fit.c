@@ -20,6 +20,17 @@
 #include <mapmem.h>
 #include <asm/io.h>
 #include <malloc.h>
+#if CONFIG_IS_ENABLED(DM_HASH)
+#include <dm.h>
+#include <u-boot/hash.h>
+#define USE_DM_HASH
+#endif
+#if CONFIG_IS_ENABLED(SMP_JOB)
+#include <smp_job.h>
+#include <u-boot/hash.h>
+#include <watchdog.h>
+#define USE_SMP_JOB
+#endif
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
@@ -972,6 +983,15 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
+#ifdef USE_DM_HASH
+	/* The engines store crc32 big-endian, as cpu_to_uimage() does */
+	*value_len = FIT_MAX_HASH_LEN;
+	if (hash_digest_by_name(algo, data, data_len, value, value_len)) {
+		debug("Unsupported hash alogrithm\n");
+		return -1;
+	}
+	return 0;
+#else
 	if (IMAGE_ENABLE_CRC32 && strcmp(algo, "crc32") == 0) {
 		*((uint32_t *)value) = crc32_wd(0, data, data_len,
 							CHUNKSZ_CRC32);
@@ -993,8 +1013,276 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		return -1;
 	}
 	return 0;
+#endif
+}
+
+#ifdef USE_SMP_JOB
+/**
+ * struct fit_hash_job - A hash calculated ahead of fit_image_check_hash()
+ *
+ * The hash context is set up on the boot CPU, so that the job itself only
+ * runs the software update and finish functions, which do not allocate
+ * memory. Like the other hash paths it resets the watchdog between chunks.
+ *
+ * @job:	Job calculating the hash, possibly on another CPU
+ * @noffset:	Hash node offset
+ * @data:	Image data to hash
+ * @size:	Size of image data
+ * @algo:	Hash algorithm
+ * @ctx:	Hash context, set up by fit_hash_job_init()
+ * @value:	Calculated hash
+ * @value_len:	Length of calculated hash
+ */
+struct fit_hash_job {
+	struct smp_job job;
+	int noffset;
+	const void *data;
+	size_t size;
+	enum HASH_ALGO algo;
+	union {
+		uint32_t crc32;
+		struct MD5Context md5;
+		sha1_context sha1;
+		sha256_context sha256;
+	} ctx;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+/* Hashes queued by fit_hash_jobs_start(), NULL if none */
+static struct fit_hash_job *fit_hash_jobs;
+static const void *fit_hash_jobs_fit;
+static int fit_hash_jobs_count;
+
+/* Get the algorithm of a hash which a job can calculate in software */
+static enum HASH_ALGO fit_hash_job_algo(const char *algo)
+{
+	if (IMAGE_ENABLE_CRC32 && !strcmp(algo, "crc32"))
+		return HASH_ALGO_CRC32;
+	if (IMAGE_ENABLE_MD5 && !strcmp(algo, "md5"))
+		return HASH_ALGO_MD5;
+	if (IMAGE_ENABLE_SHA1 && !strcmp(algo, "sha1"))
+		return HASH_ALGO_SHA1;
+	if (IMAGE_ENABLE_SHA256 && !strcmp(algo, "sha256"))
+		return HASH_ALGO_SHA256;
+
+	return HASH_ALGO_INVALID;
+}
+
+/* Set up the hash context, on the boot CPU */
+static void fit_hash_job_init(struct fit_hash_job *hj)
+{
+	if (IMAGE_ENABLE_CRC32 && hj->algo == HASH_ALGO_CRC32)
+		hj->ctx.crc32 = 0;
+	else if (IMAGE_ENABLE_MD5 && hj->algo == HASH_ALGO_MD5)
+		MD5Init(&hj->ctx.md5);
+	else if (IMAGE_ENABLE_SHA1 && hj->algo == HASH_ALGO_SHA1)
+		sha1_starts(&hj->ctx.sha1);
+	else if (IMAGE_ENABLE_SHA256 && hj->algo == HASH_ALGO_SHA256)
+		sha256_starts(&hj->ctx.sha256);
+}
+
+/* Calculate the hash, on any CPU */
+static int fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *hj = arg;
+	const uint8_t *data = hj->data;
+	const uint8_t *end = data + hj->size;
+	size_t chunk;
+
+	/* Hash in chunks, resetting the watchdog as calculate_hash() does */
+	while (data < end) {
+		chunk = min_t(size_t, end - data, CHUNKSZ);
+		if (IMAGE_ENABLE_CRC32 && hj->algo == HASH_ALGO_CRC32)
+			hj->ctx.crc32 = crc32(hj->ctx.crc32, data, chunk);
+		else if (IMAGE_ENABLE_MD5 && hj->algo == HASH_ALGO_MD5)
+			MD5Update(&hj->ctx.md5, data, chunk);
+		else if (IMAGE_ENABLE_SHA1 && hj->algo == HASH_ALGO_SHA1)
+			sha1_update(&hj->ctx.sha1, data, chunk);
+		else if (IMAGE_ENABLE_SHA256 && hj->algo == HASH_ALGO_SHA256)
+			sha256_update(&hj->ctx.sha256, data, chunk);
+		else
+			return -1;
+		data += chunk;
+		WATCHDOG_RESET();
+	}
+
+	if (IMAGE_ENABLE_CRC32 && hj->algo == HASH_ALGO_CRC32) {
+		*((uint32_t *)hj->value) = cpu_to_uimage(hj->ctx.crc32);
+		hj->value_len = 4;
+	} else if (IMAGE_ENABLE_MD5 && hj->algo == HASH_ALGO_MD5) {
+		MD5Final(hj->value, &hj->ctx.md5);
+		hj->value_len = 16;
+	} else if (IMAGE_ENABLE_SHA1 && hj->algo == HASH_ALGO_SHA1) {
+		sha1_finish(&hj->ctx.sha1, hj->value);
+		hj->value_len = 20;
+	} else if (IMAGE_ENABLE_SHA256 && hj->algo == HASH_ALGO_SHA256) {
+		sha256_finish(&hj->ctx.sha256, hj->value);
+		hj->value_len = SHA256_SUM_LEN;
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Check whether a hash can be calculated from a job on any CPU */
+static bool fit_hash_job_allowed(const void *fit, int noffset,
+				 enum HASH_ALGO *algop)
+{
+	int ignore = 0;
+	char *algo;
+#ifdef USE_DM_HASH
+	const struct hash_ops *ops;
+	struct udevice *dev;
+#endif
+
+	if (fit_image_hash_get_algo(fit, noffset, &algo))
+		return false;
+	if (IMAGE_ENABLE_IGNORE)
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+	if (ignore)
+		return false;
+	*algop = fit_hash_job_algo(algo);
+	if (*algop == HASH_ALGO_INVALID)
+		return false;
+#ifdef USE_DM_HASH
+	/*
+	 * A hardware engine cannot be used by several CPUs at once, so
+	 * leave the hash to fit_image_check_hash() if one is preferred
+	 */
+	if (hash_get_device(*algop, &dev))
+		return false;
+	ops = device_get_ops(dev);
+	if (ops->priority > 0)
+		return false;
+#endif
+
+	return true;
+}
+
+/*
+ * Add the hashes of an image to fit_hash_jobs[], or just count them if
+ * fit_hash_jobs is NULL
+ */
+static int fit_hash_jobs_add_image(const void *fit, int image_noffset,
+				   int count)
+{
+	struct fit_hash_job *hj;
+	enum HASH_ALGO algo;
+	const void *data;
+	size_t size;
+	int noffset;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return count;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (!fit_hash_job_allowed(fit, noffset, &algo))
+			continue;
+		if (fit_hash_jobs) {
+			hj = &fit_hash_jobs[count];
+			hj->noffset = noffset;
+			hj->data = data;
+			hj->size = size;
+			hj->algo = algo;
+			fit_hash_job_init(hj);
+		}
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * fit_hash_jobs_start() - Start calculating image hashes in parallel
+ *
+ * The results are picked up by fit_image_check_hash(), which waits for the
+ * job if needed. Nothing is done if there are fewer than two hashes, or a
+ * previous call has not been finished yet.
+ *
+ * @fit:		FIT image
+ * @parent_noffset:	Node offset of an image, or of the images node to
+ *			hash all images
+ * @all:		true if @parent_noffset is the images node
+ * @return true if jobs were started, and fit_hash_jobs_finish() must be
+ *	called
+ */
+static bool fit_hash_jobs_start(const void *fit, int parent_noffset, bool all)
+{
+	int noffset, count, pass, i;
+
+	if (fit_hash_jobs)
+		return false;
+
+	for (pass = 0, count = 0; pass < 2; pass++) {
+		if (pass) {
+			if (count < 2)
+				return false;
+			fit_hash_jobs = calloc(count, sizeof(*fit_hash_jobs));
+			if (!fit_hash_jobs)
+				return false;
+		}
+		count = 0;
+		if (!all) {
+			count = fit_hash_jobs_add_image(fit, parent_noffset,
+							count);
+			continue;
+		}
+		fdt_for_each_subnode(noffset, fit, parent_noffset)
+			count = fit_hash_jobs_add_image(fit, noffset, count);
+	}
+
+	fit_hash_jobs_fit = fit;
+	fit_hash_jobs_count = count;
+	for (i = 0; i < count; i++)
+		smp_job_queue(&fit_hash_jobs[i].job, fit_hash_job_run,
+			      &fit_hash_jobs[i]);
+
+	return true;
+}
+
+/* Wait for all jobs from fit_hash_jobs_start(), then free them */
+static void fit_hash_jobs_finish(void)
+{
+	int i;
+
+	for (i = 0; i < fit_hash_jobs_count; i++)
+		smp_job_wait(&fit_hash_jobs[i].job);
+	free(fit_hash_jobs);
+	fit_hash_jobs = NULL;
+	fit_hash_jobs_count = 0;
 }
 
+static struct fit_hash_job *fit_hash_job_find(const void *fit, int noffset)
+{
+	int i;
+
+	if (fit != fit_hash_jobs_fit)
+		return NULL;
+	for (i = 0; i < fit_hash_jobs_count; i++) {
+		if (fit_hash_jobs[i].noffset == noffset)
+			return &fit_hash_jobs[i];
+	}
+
+	return NULL;
+}
+#else
+static inline bool fit_hash_jobs_start(const void *fit, int parent_noffset,
+				       bool all)
+{
+	return false;
+}
+
+static inline void fit_hash_jobs_finish(void)
+{
+}
+#endif /* USE_SMP_JOB */
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
@@ -1004,6 +1292,10 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+	int ret;
+#ifdef USE_SMP_JOB
+	struct fit_hash_job *hj;
+#endif
 
 	*err_msgp = NULL;
 
@@ -1027,7 +1319,18 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+#ifdef USE_SMP_JOB
+	hj = fit_hash_job_find(fit, noffset);
+	if (hj) {
+		ret = smp_job_wait(&hj->job);
+		if (!ret) {
+			value_len = hj->value_len;
+			memcpy(value, hj->value, value_len);
+		}
+	} else
+#endif
+	ret = calculate_hash(data, size, algo, value, &value_len);
+	if (ret) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
@@ -1064,6 +1367,7 @@ int fit_image_verify(const void *fit, int image_noffset)
 	char		*err_msg = "";
 	int verify_all = 1;
 	int ret;
+	bool jobs = false;
 
 	/* Get image data and data length */
 	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
@@ -1071,6 +1375,9 @@ int fit_image_verify(const void *fit, int image_noffset)
 		goto error;
 	}
 
+	/* Calculate the hashes while any signatures are checked */
+	jobs = fit_hash_jobs_start(fit, image_noffset, false);
+
 	/* Verify all required signatures */
 	if (IMAGE_ENABLE_VERIFY &&
 	    fit_image_verify_required_sigs(fit, image_noffset, data, size,
@@ -1118,9 +1425,13 @@ int fit_image_verify(const void *fit, int image_noffset)
 		goto error;
 	}
 
+	if (jobs)
+		fit_hash_jobs_finish();
 	return 1;
 
 error:
+	if (jobs)
+		fit_hash_jobs_finish();
 	printf(" error!\n%s for '%s' hash node in '%s' image node\n",
 	       err_msg, fit_get_name(fit, noffset, NULL),
 	       fit_get_name(fit, image_noffset, NULL));
@@ -1144,6 +1455,8 @@ int fit_all_image_verify(const void *fit)
 	int noffset;
 	int ndepth;
 	int count;
+	int ret = 1;
+	bool jobs;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1156,6 +1469,7 @@ int fit_all_image_verify(const void *fit)
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
+	jobs = fit_hash_jobs_start(fit, images_noffset, true);
 	for (ndepth = 0, count = 0,
 	     noffset = fdt_next_node(fit, images_noffset, &ndepth);
 			(noffset >= 0) && (ndepth > 0);
@@ -1169,12 +1483,17 @@ int fit_all_image_verify(const void *fit)
 			       fit_get_name(fit, noffset, NULL));
 			count++;
 
-			if (!fit_image_verify(fit, noffset))
-				return 0;
+			if (!fit_image_verify(fit, noffset)) {
+				ret = 0;
+				break;
+			}
 			printf("\n");
 		}
 	}
-	return 1;
+	if (jobs)
+		fit_hash_jobs_finish();
+
+	return ret;
 }
 
 /**
@@ -1110,6 +1110,15 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 	return 0;
 }
 
+/* Ramdisk which a loader put at its final address, see boot_ramdisk_placed() */
+static ulong placed_rd_data, placed_rd_len;
+
+void boot_ramdisk_placed(ulong rd_data, ulong rd_len)
+{
+	placed_rd_data = rd_data;
+	placed_rd_len = rd_len;
+}
+
 #ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
 /**
  * boot_ramdisk_high - relocate init ramdisk
@@ -1155,6 +1164,11 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 	debug("## initrd_high = 0x%08lx, copy_to_ram = %d\n",
 			initrd_high, initrd_copy_to_ram);
 
+	/* A ramdisk loaded to its final address stays there, if low enough */
+	if (rd_data && rd_data == placed_rd_data && rd_len == placed_rd_len &&
+	    (!initrd_high || rd_data + rd_len <= initrd_high))
+		initrd_copy_to_ram = 0;
+
 	if (rd_data) {
 		if (!initrd_copy_to_ram) {	/* zero-copy ramdisk support */
 			debug("   in-place initrd\n");
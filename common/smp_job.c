@@ -0,0 +1,171 @@
+/*
+ * Run independent jobs on secondary CPUs
+ *
+ * The boot CPU queues jobs on a single list which the workers take jobs from.
+ * Jobs are kept in the order they were queued. The boot CPU also runs jobs
+ * while it waits, so the result is the same whether or not any secondary CPU
+ * could be started.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <smp_job.h>
+
+enum {
+	SMP_JOB_STOPPED,
+	SMP_JOB_RUNNING,
+	SMP_JOB_FAILED,		/* no secondary CPU could be started */
+};
+
+static struct smp_job_cpu smp_job_cpus[CONFIG_SMP_JOB_MAX_CPUS];
+static int smp_job_count;
+static int smp_job_state;
+
+static struct smp_job *smp_job_head, *smp_job_tail;
+static volatile int smp_job_lock_val;
+static volatile int smp_job_quit;
+
+static void smp_job_lock(void)
+{
+	while (__sync_lock_test_and_set(&smp_job_lock_val, 1))
+		;
+}
+
+static void smp_job_unlock(void)
+{
+	__sync_lock_release(&smp_job_lock_val);
+}
+
+static struct smp_job *smp_job_pop(void)
+{
+	struct smp_job *job;
+
+	smp_job_lock();
+	job = smp_job_head;
+	if (job) {
+		smp_job_head = job->next;
+		if (!smp_job_head)
+			smp_job_tail = NULL;
+	}
+	smp_job_unlock();
+
+	return job;
+}
+
+static void smp_job_run(struct smp_job *job)
+{
+	job->ret = job->func(job->arg);
+	/* Make the results visible before the job is marked done */
+	__sync_synchronize();
+	job->done = 1;
+}
+
+void smp_job_worker(struct smp_job_cpu *cpu)
+{
+	struct smp_job *job;
+
+	cpu->running = 1;
+	__sync_synchronize();
+	while (!smp_job_quit) {
+		job = smp_job_pop();
+		if (job) {
+			smp_job_run(job);
+			cpu->jobs++;
+		} else {
+			smp_job_arch_idle();
+		}
+	}
+	__sync_synchronize();
+	cpu->running = 0;
+}
+
+int smp_job_init(void)
+{
+	int i;
+
+	if (smp_job_state == SMP_JOB_RUNNING)
+		return smp_job_count;
+	else if (smp_job_state == SMP_JOB_FAILED)
+		return 0;
+
+	smp_job_quit = 0;
+	for (i = 0; i < CONFIG_SMP_JOB_MAX_CPUS; i++) {
+		memset(&smp_job_cpus[i], '\0', sizeof(smp_job_cpus[i]));
+		smp_job_cpus[i].index = i;
+	}
+	__sync_synchronize();
+	smp_job_count = smp_job_arch_start(smp_job_cpus,
+					   CONFIG_SMP_JOB_MAX_CPUS);
+	if (smp_job_count <= 0) {
+		smp_job_count = 0;
+		smp_job_state = SMP_JOB_FAILED;
+		return 0;
+	}
+	smp_job_state = SMP_JOB_RUNNING;
+	debug("%s: %d worker(s)\n", __func__, smp_job_count);
+
+	return smp_job_count;
+}
+
+void smp_job_queue(struct smp_job *job, int (*func)(void *arg), void *arg)
+{
+	job->func = func;
+	job->arg = arg;
+	job->ret = 0;
+	job->done = 0;
+	job->next = NULL;
+
+	if (!smp_job_init()) {
+		smp_job_run(job);
+		return;
+	}
+
+	smp_job_lock();
+	if (smp_job_tail)
+		smp_job_tail->next = job;
+	else
+		smp_job_head = job;
+	smp_job_tail = job;
+	smp_job_unlock();
+	smp_job_arch_kick();
+}
+
+int smp_job_wait(struct smp_job *job)
+{
+	struct smp_job *other;
+
+	while (!job->done) {
+		other = smp_job_pop();
+		if (other)
+			smp_job_run(other);
+	}
+	__sync_synchronize();
+
+	return job->ret;
+}
+
+void smp_job_exit(void)
+{
+	struct smp_job *job;
+
+	if (smp_job_state != SMP_JOB_RUNNING)
+		return;
+
+	while ((job = smp_job_pop()))
+		smp_job_run(job);
+	smp_job_quit = 1;
+	__sync_synchronize();
+	smp_job_arch_kick();
+	smp_job_arch_stop(smp_job_cpus, smp_job_count);
+	smp_job_count = 0;
+	smp_job_state = SMP_JOB_STOPPED;
+}
+
+struct smp_job_cpu *smp_job_get_cpu(int index)
+{
+	if (index < 0 || index >= smp_job_count)
+		return NULL;
+
+	return &smp_job_cpus[index];
+}
@@ -95,7 +95,9 @@ static void bl31_entry(uintptr_t bl31_entry, uintptr_t bl33_entry,
 	bl31_params = bl2_plat_get_bl31_params(bl33_entry);
 
 	raw_write_daif(SPSR_EXCEPTION_MASK);
+	/* ATF was written through the D-cache if SPL had it enabled */
 	dcache_disable();
+	invalidate_icache_all();
 
 	atf_entry((void *)bl31_params, (void *)fdt_addr);
 }
@@ -7,14 +7,79 @@
 
 #include <common.h>
 #include <errno.h>
+#include <hash.h>
 #include <image.h>
 #include <libfdt.h>
+#include <mapmem.h>
 #include <spl.h>
+#include <asm/unaligned.h>
 
 #ifndef CONFIG_SYS_BOOTM_LEN
 #define CONFIG_SYS_BOOTM_LEN	(64 << 20)
 #endif
 
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+/* Most images read in one pass, enough for U-Boot, ATF, OP-TEE and an FDT */
+#define SPL_FIT_PLAN_MAX	16
+
+/**
+ * struct spl_fit_load - an image to read in one pass with the others
+ *
+ * @node:	Offset of the image node in the FIT
+ * @offset:	Offset of the image data from the start of the FIT
+ * @size:	Size of the image data
+ * @load_addr:	Address to copy the image data to
+ * @ret:	-EINPROGRESS until the image is in place, then 0 if its hash
+ *		(if any) matches, -ve on error
+ * @read_us:	Share of the read time spent on this image
+ * @hash_us:	Time spent hashing this image
+ * @algo:	Hash algorithm to check the image with, NULL for none
+ * @ctx:	Context of the hash as it is updated
+ * @hash_node:	Offset of the hash node in the FIT
+ */
+struct spl_fit_load {
+	int node;
+	ulong offset;
+	ulong size;
+	ulong load_addr;
+	int ret;
+	ulong read_us;
+	ulong hash_us;
+#ifdef CONFIG_SPL_LOAD_FIT_HASH
+	struct hash_algo *algo;
+	void *ctx;
+	int hash_node;
+#endif
+};
+
+/**
+ * struct spl_fit_plan - the images spl_load_simple_fit() is going to load
+ *
+ * @planning:	true while only recording the images asked for
+ * @abort:	true if an image cannot be read in one pass with the others,
+ *		in which case they are all read one by one
+ * @count:	Number of images in @load
+ * @load:	The images, in the order they are asked for
+ */
+struct spl_fit_plan {
+	bool planning;
+	bool abort;
+	int count;
+	struct spl_fit_load load[SPL_FIT_PLAN_MAX];
+};
+
+static struct spl_fit_plan fit_plan;
+#endif
+
+static bool spl_fit_planning(void)
+{
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+	return fit_plan.planning;
+#else
+	return false;
+#endif
+}
+
 /**
  * spl_fit_get_image_name(): By using the matching configuration subnode,
  * retrieve the name of an image, specified by a property name and an index
@@ -141,6 +206,327 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+/**
+ * spl_fit_plan_image(): find or add an image read in one pass
+ * @fit:	Pointer to the FDT blob.
+ * @node:	Offset of the image node.
+ * @offset:	Offset of the image data from the start of the FIT.
+ * @size:	Size of the image data.
+ * @load_addr:	Address the data is to be copied to.
+ *
+ * While planning, the image is added to the plan. Afterwards, the image is
+ * looked up, so that spl_load_fit_image() can use the copy already in place.
+ *
+ * Return:	the planned image, or NULL if it is to be read on its own
+ */
+static struct spl_fit_load *spl_fit_plan_image(const void *fit, int node,
+					       ulong offset, ulong size,
+					       ulong load_addr)
+{
+	struct spl_fit_load *load;
+	ulong addr;
+	uint8_t type;
+	int i;
+
+	for (i = 0; i < fit_plan.count; i++) {
+		load = &fit_plan.load[i];
+		if (load->node == node && load->load_addr == load_addr)
+			return fit_plan.abort ? NULL : load;
+	}
+	if (!fit_plan.planning || fit_plan.abort)
+		return NULL;
+
+	/*
+	 * Without a load address the image goes wherever its caller says,
+	 * which is only known ahead of time for the FDT placed after U-Boot.
+	 */
+	if (fit_image_get_load(fit, node, &addr) &&
+	    (fit_image_get_type(fit, node, &type) || type != IH_TYPE_FLATDT)) {
+		fit_plan.abort = true;
+		return NULL;
+	}
+	if (fit_plan.count == SPL_FIT_PLAN_MAX) {
+		fit_plan.abort = true;
+		return NULL;
+	}
+
+	load = &fit_plan.load[fit_plan.count++];
+	memset(load, '\0', sizeof(*load));
+	load->node = node;
+	load->offset = offset;
+	load->size = size;
+	load->load_addr = load_addr;
+	load->ret = -EINPROGRESS;
+
+	return load;
+}
+
+#ifdef CONFIG_SPL_LOAD_FIT_HASH
+/* Start the hash of an image, from the first hash node it has */
+static int spl_fit_hash_init(const void *fit, struct spl_fit_load *load)
+{
+	const char *name;
+	char *algo;
+	int noffset;
+
+	fdt_for_each_subnode(noffset, fit, load->node) {
+		name = fit_get_name(fit, noffset, NULL);
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo))
+			return -EINVAL;
+		if (hash_lookup_algo(algo, &load->algo)) {
+			printf("%s: unsupported hash algorithm '%s'\n",
+			       fit_get_name(fit, load->node, NULL), algo);
+			return -EPROTONOSUPPORT;
+		}
+		load->hash_node = noffset;
+
+		return load->algo->hash_init(load->algo, &load->ctx);
+	}
+
+	return 0;
+}
+
+/* Finish the hash of an image and compare it with the one in the FIT */
+static int spl_fit_hash_check(const void *fit, struct spl_fit_load *load)
+{
+	struct hash_algo *algo = load->algo;
+	uint8_t digest[HASH_MAX_DIGEST_SIZE];
+	uint8_t *value;
+	int value_len;
+
+	if (!algo)
+		return 0;
+	load->algo = NULL;
+	if (algo->hash_finish(algo, load->ctx, digest, sizeof(digest)))
+		return -EINVAL;
+
+	/* FIT stores CRC32 values big-endian */
+	if (!strcmp(algo->name, "crc32"))
+		put_unaligned_be32(get_unaligned((u32 *)digest), digest);
+
+	if (fit_image_hash_get_value(fit, load->hash_node, &value,
+				     &value_len))
+		return -EINVAL;
+	if (value_len != algo->digest_size ||
+	    memcmp(value, digest, value_len)) {
+		printf("%s: %s hash mismatch\n",
+		       fit_get_name(fit, load->node, NULL), algo->name);
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+/* Check the hash of an image read on its own, once it is all in memory */
+static int spl_fit_hash_data(const void *fit, int node, const void *data,
+			     ulong size)
+{
+	struct spl_fit_load load = { .node = node };
+	int ret;
+
+	ret = spl_fit_hash_init(fit, &load);
+	if (ret || !load.algo)
+		return ret;
+	/* The context is freed on error */
+	ret = load.algo->hash_update(load.algo, load.ctx, data, size, 1);
+	if (ret)
+		return ret;
+
+	return spl_fit_hash_check(fit, &load);
+}
+#else
+static inline int spl_fit_hash_init(const void *fit,
+				    struct spl_fit_load *load)
+{
+	return 0;
+}
+
+static inline int spl_fit_hash_check(const void *fit,
+				     struct spl_fit_load *load)
+{
+	return 0;
+}
+#endif /* CONFIG_SPL_LOAD_FIT_HASH */
+
+/* While planning, say where an image goes without reading it */
+static int spl_fit_plan_info(struct spl_image_info *image_info,
+			     uint8_t image_comp, ulong load_addr, ulong size)
+{
+	/* Compressed images are not read in place */
+	if (image_comp == IH_COMP_GZIP)
+		fit_plan.abort = true;
+
+	if (image_info) {
+		image_info->load_addr = load_addr;
+		image_info->size = size;
+	}
+
+	return 0;
+}
+
+/* Read @len bytes from @pos, both a multiple of the block size for raw reads */
+static int spl_fit_read_range(struct spl_load_info *info, ulong sector,
+			      ulong pos, ulong len, void *buf)
+{
+	ulong count;
+
+	if (info->filename)
+		return info->read(info, sector + pos, len, buf) == len ?
+			0 : -EIO;
+
+	count = len / info->bl_len;
+	if (info->read(info, sector + pos / info->bl_len, count, buf) != count)
+		return -EIO;
+
+	return 0;
+}
+
+/* The image is in place: check its hash and mark when it was done */
+static void spl_fit_load_done(const void *fit, struct spl_fit_load *load)
+{
+	const char *name = fit_get_name(fit, load->node, NULL);
+
+	load->ret = spl_fit_hash_check(fit, load);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, name);
+	debug("%s: %lx bytes at %lx, read %lu us, hash %lu us, ret %d\n",
+	      name, load->size, load->load_addr, load->read_us, load->hash_us,
+	      load->ret);
+}
+
+/**
+ * spl_fit_read_plan(): read all planned images in one pass
+ * @info:	points to information about the device to load data from
+ * @sector:	the start sector of the FIT image on the device
+ * @fit:	points to the flattened device tree blob describing the FIT
+ *		image
+ * @fit_size:	size of the FIT header read so far
+ *
+ * The images are sorted by their offset in the FIT. The storage from the
+ * first to the last is then read in pieces of CONFIG_SPL_LOAD_FIT_CHUNK_SIZE
+ * (skipping gaps of whole pieces), into a buffer below the FIT. Each image
+ * takes its part of every piece, so a block shared by two images is read
+ * once, and is hashed while the piece is still in the cache.
+ *
+ * Return:	0 if the images were read, or the plan was abandoned and they
+ *		are to be read one by one; -ve if a read failed
+ */
+static int spl_fit_read_plan(struct spl_load_info *info, ulong sector,
+			     const void *fit, ulong fit_size)
+{
+	struct spl_fit_load *sorted[SPL_FIT_PLAN_MAX], *load;
+	ulong unit, chunk, pos, end, last, from, to, us, fit_addr, buf_addr;
+	int count = fit_plan.count;
+	int i, j, ret;
+	char *buf;
+
+	if (fit_plan.abort || !count)
+		return 0;
+
+	/* Reads start on a block, or for files a DMA-aligned offset */
+	unit = info->filename ? ARCH_DMA_MINALIGN : info->bl_len;
+	chunk = CONFIG_SPL_LOAD_FIT_CHUNK_SIZE - CONFIG_SPL_LOAD_FIT_CHUNK_SIZE %
+		unit;
+	fit_addr = map_to_sysmem(fit);
+	buf_addr = (fit_addr - chunk) & ~(ARCH_DMA_MINALIGN - 1);
+	buf = map_sysmem(buf_addr, chunk);
+
+	/* Sort by offset, keeping the order in which they were asked for */
+	for (i = 0, last = 0; i < count; i++) {
+		load = &fit_plan.load[i];
+		if (load->load_addr < fit_addr + fit_size &&
+		    load->load_addr + load->size > buf_addr) {
+			debug("%s: image at %lx overlaps the read buffer\n",
+			      __func__, load->load_addr);
+			fit_plan.abort = true;
+			return 0;
+		}
+		for (j = i; j > 0 && sorted[j - 1]->offset > load->offset; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = load;
+		last = max(last, load->offset + load->size);
+	}
+	if (!info->filename)
+		last = roundup(last, unit);
+
+	for (i = 0; i < count; i++) {
+		ret = spl_fit_hash_init(fit, sorted[i]);
+		if (ret)
+			sorted[i]->ret = ret;
+	}
+
+	for (i = 0, pos = 0; i < count; pos = end) {
+		/* Skip to the next image still to be read */
+		pos = max(pos, rounddown(sorted[i]->offset, unit));
+		end = min(pos + chunk, last);
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIT_READ, "spl_fit_read");
+		ret = spl_fit_read_range(info, sector, pos, end - pos, buf);
+		us = bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_FIT_READ);
+		if (ret)
+			break;
+
+		for (j = i; j < count && sorted[j]->offset < end; j++) {
+			load = sorted[j];
+			from = max(load->offset, pos);
+			to = min(load->offset + load->size, end);
+			if (from >= to)
+				continue;
+
+			memcpy(map_sysmem(load->load_addr + from - load->offset,
+					  to - from),
+			       buf + from - pos, to - from);
+			/* Share out the read time by KiB, which cannot overflow */
+			load->read_us += us * DIV_ROUND_UP(to - from, 1024) /
+					 DIV_ROUND_UP(end - pos, 1024);
+#ifdef CONFIG_SPL_LOAD_FIT_HASH
+			if (load->algo) {
+				bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIT_HASH,
+						"spl_fit_hash");
+				ret = load->algo->hash_update(load->algo,
+						load->ctx, buf + from - pos,
+						to - from,
+						to == load->offset + load->size);
+				load->hash_us += bootstage_accum(
+						BOOTSTAGE_ID_ACCUM_SPL_FIT_HASH);
+				if (ret) {
+					/* The context is freed on error */
+					load->algo = NULL;
+					load->ret = -EINVAL;
+				}
+			}
+#endif
+			if (to == load->offset + load->size &&
+			    load->ret == -EINPROGRESS)
+				spl_fit_load_done(fit, load);
+		}
+
+		/* Move past the images now read, completing any empty one */
+		for (; i < count; i++) {
+			load = sorted[i];
+			if (load->offset + load->size > end)
+				break;
+			if (load->ret == -EINPROGRESS)
+				spl_fit_load_done(fit, load);
+		}
+	}
+
+	if (i < count) {
+		printf("%s: read failed at offset %lx\n", __func__, pos);
+		for (; i < count; i++) {
+			if (sorted[i]->ret == -EINPROGRESS)
+				sorted[i]->ret = -EIO;
+		}
+		return -EIO;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_SPL_LOAD_FIT_MERGED */
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -173,6 +559,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	int align_len = ARCH_DMA_MINALIGN - 1;
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
+	struct spl_fit_load *load = NULL;
 
 	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
 		if (fit_image_get_comp(fit, node, &image_comp))
@@ -195,20 +582,36 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
 
-		load_ptr = (load_addr + align_len) & ~align_len;
-		length = len;
-
-		overhead = get_aligned_image_overhead(info, offset);
-		nr_sectors = get_aligned_image_size(info, length, offset);
-
-		if (info->read(info,
-			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
-			return -EIO;
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+		load = spl_fit_plan_image(fit, node, offset, len, load_addr);
+		if (fit_plan.planning)
+			return spl_fit_plan_info(image_info, image_comp,
+						 load_addr, len);
+		if (load && load->ret)
+			return load->ret;
+#endif
 
-		debug("External data: dst=%lx, offset=%x, size=%lx\n",
-		      load_ptr, offset, (unsigned long)length);
-		src = (void *)load_ptr + overhead;
+		length = len;
+		if (load) {
+			/* Already copied into place by spl_fit_read_plan() */
+			src = map_sysmem(load_addr, length);
+		} else {
+			load_ptr = (load_addr + align_len) & ~align_len;
+
+			overhead = get_aligned_image_overhead(info, offset);
+			nr_sectors = get_aligned_image_size(info, length,
+							    offset);
+
+			if (info->read(info, sector +
+				       get_aligned_image_offset(info, offset),
+				       nr_sectors, map_sysmem(load_ptr, 0)) !=
+			    nr_sectors)
+				return -EIO;
+
+			debug("External data: dst=%lx, offset=%x, size=%lx\n",
+			      load_ptr, offset, (unsigned long)length);
+			src = map_sysmem(load_ptr + overhead, length);
+		}
 	} else {
 		/* Embedded data */
 		if (fit_image_get_data(fit, node, &data, &length)) {
@@ -218,7 +621,23 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		debug("Embedded data: dst=%lx, size=%lx\n", load_addr,
 		      (unsigned long)length);
 		src = (void *)data;
+
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+		if (fit_plan.planning)
+			return spl_fit_plan_info(image_info, image_comp,
+						 load_addr, length);
+#endif
+	}
+
+#ifdef CONFIG_SPL_LOAD_FIT_HASH
+	/* Images not read in one pass are checked here instead */
+	if (!load) {
+		int ret = spl_fit_hash_data(fit, node, src, length);
+
+		if (ret)
+			return ret;
 	}
+#endif
 
 #ifdef CONFIG_SPL_FIT_IMAGE_POST_PROCESS
 	board_fit_image_post_process(&src, &length);
@@ -229,14 +648,16 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	    image_comp == IH_COMP_GZIP		&&
 	    type == IH_TYPE_KERNEL) {
 		size = length;
-		if (gunzip((void *)load_addr, CONFIG_SYS_BOOTM_LEN,
+		if (gunzip(map_sysmem(load_addr, CONFIG_SYS_BOOTM_LEN),
+			   CONFIG_SYS_BOOTM_LEN,
 			   src, &size)) {
 			puts("Uncompressing error\n");
 			return -EIO;
 		}
 		length = size;
-	} else {
-		memcpy((void *)load_addr, src, length);
+	} else if (src != map_sysmem(load_addr, length)) {
+		/* External data was read a little above, so this may overlap */
+		memmove(map_sysmem(load_addr, length), src, length);
 	}
 
 	if (image_info) {
@@ -270,11 +691,12 @@ static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 	ret = spl_load_fit_image(info, sector, fit, base_offset, node,
 				 &image_info);
 
-	if (ret < 0)
+	/* While planning, nothing has been read yet */
+	if (ret < 0 || spl_fit_planning())
 		return ret;
 
 	/* Make the load-address of the FDT available for the SPL framework */
-	spl_image->fdt_addr = (void *)image_info.load_addr;
+	spl_image->fdt_addr = map_sysmem(image_info.load_addr, 0);
 #if !CONFIG_IS_ENABLED(FIT_IMAGE_TINY)
 	/* Try to make space, so we can inject details on the loadables */
 	ret = fdt_shrink_to_minimum(spl_image->fdt_addr, 8192);
@@ -315,59 +737,27 @@ static int spl_fit_image_get_os(const void *fit, int noffset, uint8_t *os)
 #endif
 }
 
-int spl_load_simple_fit(struct spl_image_info *spl_image,
-			struct spl_load_info *info, ulong sector, void *fit)
+/**
+ * spl_fit_load_images(): load the images a FIT configuration asks for
+ * @spl_image:	filled with information about the U-Boot or OS image
+ * @info:	points to information about the device to load data from
+ * @sector:	the start sector of the FIT image on the device
+ * @fit:	points to the flattened device tree blob describing the FIT
+ *		image
+ * @images:	offset of the /images node in the FIT
+ * @base_offset: the beginning of the data area containing the actual
+ *		image data, relative to the beginning of the FIT
+ *
+ * Return:	0 on success, -ve on error
+ */
+static int spl_fit_load_images(struct spl_image_info *spl_image,
+			       struct spl_load_info *info, ulong sector,
+			       void *fit, int images, int base_offset)
 {
-	int sectors;
-	ulong size;
-	unsigned long count;
 	struct spl_image_info image_info;
 	int node = -1;
-	int images, ret;
-	int base_offset, align_len = ARCH_DMA_MINALIGN - 1;
 	int index = 0;
-
-	/*
-	 * For FIT with external data, figure out where the external images
-	 * start. This is the base for the data-offset properties in each
-	 * image.
-	 */
-	size = fdt_totalsize(fit);
-	size = (size + 3) & ~3;
-	base_offset = (size + 3) & ~3;
-
-	/*
-	 * So far we only have one block of data from the FIT. Read the entire
-	 * thing, including that first block, placing it so it finishes before
-	 * where we will load the image.
-	 *
-	 * Note that we will load the image such that its first byte will be
-	 * at the load address. Since that byte may be part-way through a
-	 * block, we may load the image up to one block before the load
-	 * address. So take account of that here by subtracting an addition
-	 * block length from the FIT start position.
-	 *
-	 * In fact the FIT has its own load address, but we assume it cannot
-	 * be before CONFIG_SYS_TEXT_BASE.
-	 *
-	 * For FIT with data embedded, data is loaded as part of FIT image.
-	 * For FIT with external data, data is not loaded in this step.
-	 */
-	fit = (void *)((CONFIG_SYS_TEXT_BASE - size - info->bl_len -
-			align_len) & ~align_len);
-	sectors = get_aligned_image_size(info, size, 0);
-	count = info->read(info, sector, sectors, fit);
-	debug("fit read sector %lx, sectors=%d, dst=%p, count=%lu\n",
-	      sector, sectors, fit, count);
-	if (count == 0)
-		return -EIO;
-
-	/* find the node holding the images information */
-	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
-	if (images < 0) {
-		debug("%s: Cannot find /images node: %d\n", __func__, images);
-		return -1;
-	}
+	int ret;
 
 	/*
 	 * Find the U-Boot image using the following search order:
@@ -452,7 +842,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 			spl_image->entry_point = image_info.entry_point;
 
 		/* Record our loadables into the FDT */
-		if (spl_image->fdt_addr)
+		if (spl_image->fdt_addr && !spl_fit_planning())
 			spl_fit_record_loadable(fit, images, index,
 						spl_image->fdt_addr,
 						&image_info);
@@ -468,3 +858,77 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 
 	return 0;
 }
+
+int spl_load_simple_fit(struct spl_image_info *spl_image,
+			struct spl_load_info *info, ulong sector, void *fit)
+{
+	int sectors;
+	ulong size;
+	unsigned long count;
+	int images;
+	int base_offset, align_len = ARCH_DMA_MINALIGN - 1;
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+	struct spl_image_info plan_image;
+	int ret;
+#endif
+
+	/*
+	 * For FIT with external data, figure out where the external images
+	 * start. This is the base for the data-offset properties in each
+	 * image.
+	 */
+	size = fdt_totalsize(fit);
+	size = (size + 3) & ~3;
+	base_offset = (size + 3) & ~3;
+
+	/*
+	 * So far we only have one block of data from the FIT. Read the entire
+	 * thing, including that first block, placing it so it finishes before
+	 * where we will load the image.
+	 *
+	 * Note that we will load the image such that its first byte will be
+	 * at the load address. Since that byte may be part-way through a
+	 * block, we may load the image up to one block before the load
+	 * address. So take account of that here by subtracting an addition
+	 * block length from the FIT start position.
+	 *
+	 * In fact the FIT has its own load address, but we assume it cannot
+	 * be before CONFIG_SYS_TEXT_BASE.
+	 *
+	 * For FIT with data embedded, data is loaded as part of FIT image.
+	 * For FIT with external data, data is not loaded in this step.
+	 */
+	fit = map_sysmem((CONFIG_SYS_TEXT_BASE - size - info->bl_len -
+			  align_len) & ~align_len, size);
+	sectors = get_aligned_image_size(info, size, 0);
+	count = info->read(info, sector, sectors, fit);
+	debug("fit read sector %lx, sectors=%d, dst=%p, count=%lu\n",
+	      sector, sectors, fit, count);
+	if (count == 0)
+		return -EIO;
+
+	/* find the node holding the images information */
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images < 0) {
+		debug("%s: Cannot find /images node: %d\n", __func__, images);
+		return -1;
+	}
+
+#ifdef CONFIG_SPL_LOAD_FIT_MERGED
+	/* Work out where every image goes, then read them in one pass */
+	plan_image = *spl_image;
+	fit_plan.count = 0;
+	fit_plan.abort = false;
+	fit_plan.planning = true;
+	spl_fit_load_images(&plan_image, info, sector, fit, images,
+			    base_offset);
+	fit_plan.planning = false;
+
+	ret = spl_fit_read_plan(info, sector, fit, size);
+	if (ret)
+		return ret;
+#endif
+
+	return spl_fit_load_images(spl_image, info, sector, fit, images,
+				   base_offset);
+}
@@ -23,6 +23,8 @@
 #endif
 
 #include <dm/device-internal.h>
+#include <dm/probe.h>
+#include <dm/util.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -333,11 +335,20 @@ int stdio_add_devices(void)
 	if (ret)
 		return ret;
 
-	/* Don't report errors to the caller - assume that they are non-fatal */
-	uclass_foreach_dev(dev, uc) {
-		ret = device_probe(dev);
-		if (ret)
-			printf("Failed to probe keyboard '%s'\n", dev->name);
+	if (!dm_probe_needed(UCLASS_KEYBOARD)) {
+		dm_probe_trace_defer(UCLASS_KEYBOARD,
+				     list_count_items(&uc->dev_head));
+	} else {
+		/*
+		 * Don't report errors to the caller - assume that they are
+		 * non-fatal
+		 */
+		uclass_foreach_dev(dev, uc) {
+			ret = device_probe(dev);
+			if (ret)
+				printf("Failed to probe keyboard '%s'\n",
+				       dev->name);
+		}
 	}
 #endif
 #ifdef CONFIG_SYS_I2C
@@ -355,15 +366,11 @@ int stdio_add_devices(void)
 	 * required will be available.
 	 */
 #ifndef CONFIG_SYS_CONSOLE_IS_IN_ENV
-	struct udevice *vdev;
 # ifndef CONFIG_DM_KEYBOARD
 	int ret;
 # endif
 
-	for (ret = uclass_first_device(UCLASS_VIDEO, &vdev);
-	     vdev;
-	     ret = uclass_next_device(&vdev))
-		;
+	ret = uclass_probe_all(UCLASS_VIDEO);
 	if (ret)
 		printf("%s: Video device failed (ret=%d)\n", __func__, ret);
 #endif /* !CONFIG_SYS_CONSOLE_IS_IN_ENV */
@@ -52,6 +52,216 @@ static struct part_driver *part_driver_lookup_type(struct blk_desc *dev_desc)
 	return NULL;
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+#define PART_CACHE_HASH_SIZE	32
+
+/**
+ * struct part_cache - Partition table read from a block device
+ *
+ * Partitions 1 to @count were read with the driver for @part_type, stopping
+ * at the first one the driver does not return. Any later partition number is
+ * still passed to the driver.
+ *
+ * @node:	Entry in part_cache_head
+ * @dev_desc:	Block device the table was read from
+ * @if_type:	Interface type of @dev_desc when the table was read
+ * @devnum:	Device number of @dev_desc when the table was read
+ * @hwpart:	Hardware partition of @dev_desc when the table was read
+ * @part_type:	Partition table type
+ * @count:	Number of partitions in @info
+ * @info:	Partition information, @info[0] being partition 1
+ * @next:	Index of the next partition with the same name hash, or -1
+ * @hash:	Index of the first partition with each name hash, or -1
+ */
+struct part_cache {
+	struct list_head node;
+	struct blk_desc *dev_desc;
+	int if_type;
+	int devnum;
+	int hwpart;
+	int part_type;
+	int count;
+	disk_partition_t *info;
+	short *next;
+	short hash[PART_CACHE_HASH_SIZE];
+};
+
+static LIST_HEAD(part_cache_head);
+
+static uint part_cache_hash(const char *name)
+{
+	uint hash = 0;
+
+	while (*name)
+		hash = hash * 31 + *name++;
+
+	return hash % PART_CACHE_HASH_SIZE;
+}
+
+static struct part_cache *part_cache_find(struct blk_desc *dev_desc)
+{
+	struct part_cache *cache;
+
+	list_for_each_entry(cache, &part_cache_head, node) {
+		if (cache->dev_desc == dev_desc &&
+		    cache->if_type == dev_desc->if_type &&
+		    cache->devnum == dev_desc->devnum &&
+		    cache->hwpart == dev_desc->hwpart)
+			return cache;
+	}
+
+	return NULL;
+}
+
+static void part_cache_free(struct part_cache *cache)
+{
+	list_del(&cache->node);
+	free(cache->info);
+	free(cache->next);
+	free(cache);
+}
+
+static int part_cache_fill(struct part_cache *cache, struct blk_desc *dev_desc,
+			   struct part_driver *drv)
+{
+	disk_partition_t *info;
+	int size = 0;
+	int i;
+
+	for (i = 0; i < drv->max_entries; i++) {
+		if (i == size) {
+			size = size ? size * 2 : 16;
+			info = realloc(cache->info, size * sizeof(*info));
+			if (!info)
+				return -ENOMEM;
+			cache->info = info;
+		}
+		info = &cache->info[i];
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+		info->uuid[0] = 0;
+#endif
+#ifdef CONFIG_PARTITION_TYPE_GUID
+		info->type_guid[0] = 0;
+#endif
+		if (drv->get_info(dev_desc, i + 1, info))
+			break;
+	}
+	cache->count = i;
+
+	memset(cache->hash, '\xff', sizeof(cache->hash));
+	if (!cache->count)
+		return 0;
+	cache->next = malloc(cache->count * sizeof(*cache->next));
+	if (!cache->next)
+		return -ENOMEM;
+
+	/* Add in reverse so that the lowest-numbered match is found first */
+	for (i = cache->count - 1; i >= 0; i--) {
+		uint hash = part_cache_hash((const char *)cache->info[i].name);
+
+		cache->next[i] = cache->hash[hash];
+		cache->hash[hash] = i;
+	}
+
+	return 0;
+}
+
+/**
+ * part_cache_get() - Get the partition table of a device, reading it if needed
+ *
+ * @dev_desc:	Block device descriptor
+ * @drv:	Partition driver for the device
+ * @return cached table, or NULL if it could not be allocated
+ */
+static struct part_cache *part_cache_get(struct blk_desc *dev_desc,
+					 struct part_driver *drv)
+{
+	struct part_cache *cache;
+
+	cache = part_cache_find(dev_desc);
+	if (cache) {
+		if (cache->part_type == dev_desc->part_type)
+			return cache;
+		part_cache_free(cache);
+	}
+	if (!drv->get_info)
+		return NULL;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+	INIT_LIST_HEAD(&cache->node);
+	cache->dev_desc = dev_desc;
+	cache->if_type = dev_desc->if_type;
+	cache->devnum = dev_desc->devnum;
+	cache->hwpart = dev_desc->hwpart;
+	cache->part_type = dev_desc->part_type;
+	if (part_cache_fill(cache, dev_desc, drv)) {
+		part_cache_free(cache);
+		return NULL;
+	}
+	list_add(&cache->node, &part_cache_head);
+
+	return cache;
+}
+#endif
+
+/* Drop the tables kept by the partition drivers themselves */
+static void part_drivers_invalidate(struct blk_desc *dev_desc)
+{
+	struct part_driver *drv =
+		ll_entry_start(struct part_driver, part_driver);
+	const int n_ents = ll_entry_count(struct part_driver, part_driver);
+	struct part_driver *entry;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		if (entry->invalidate)
+			entry->invalidate(dev_desc);
+	}
+}
+
+void part_cache_invalidate(struct blk_desc *dev_desc)
+{
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *cache, *tmp;
+
+	list_for_each_entry_safe(cache, tmp, &part_cache_head, node) {
+		if (cache->dev_desc == dev_desc)
+			part_cache_free(cache);
+	}
+#endif
+	part_drivers_invalidate(dev_desc);
+	dev_desc->part_type = PART_TYPE_UNKNOWN;
+}
+
+void part_cache_invalidate_range(struct blk_desc *dev_desc, lbaint_t start,
+				 lbaint_t blkcnt)
+{
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *cache;
+	disk_partition_t *info;
+	int i;
+
+	cache = part_cache_find(dev_desc);
+	if (cache) {
+		/* Writes to a partition's own blocks cannot change the table */
+		for (i = 0; i < cache->count; i++) {
+			info = &cache->info[i];
+			if (start >= info->start &&
+			    start + blkcnt <= info->start + info->size)
+				return;
+		}
+		part_cache_invalidate(dev_desc);
+		return;
+	}
+#endif
+	/*
+	 * Without a cached table the partitions are not known, so any write
+	 * may change a table kept by a driver
+	 */
+	part_drivers_invalidate(dev_desc);
+}
+
 static struct blk_desc *get_dev_hwpart(const char *ifname, int dev, int hwpart)
 {
 	struct blk_desc *dev_desc;
@@ -239,7 +449,7 @@ void part_init(struct blk_desc *dev_desc)
 
 	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
 
-	dev_desc->part_type = PART_TYPE_UNKNOWN;
+	part_cache_invalidate(dev_desc);
 	for (entry = drv; entry != drv + n_ents; entry++) {
 		int ret;
 
@@ -327,6 +537,9 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 {
 #ifdef HAVE_BLOCK_DEVICE
 	struct part_driver *drv;
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *cache;
+#endif
 
 #if CONFIG_IS_ENABLED(PARTITION_UUIDS)
 	/* The common case is no UUID support */
@@ -347,6 +560,13 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 		       drv->name);
 		return -ENOSYS;
 	}
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	cache = part_cache_get(dev_desc, drv);
+	if (cache && part >= 1 && part <= cache->count) {
+		memcpy(info, &cache->info[part - 1], sizeof(*info));
+		return 0;
+	}
+#endif
 	if (drv->get_info(dev_desc, part, info) == 0) {
 		PRINTF("## Valid %s partition found ##\n", drv->name);
 		return 0;
@@ -655,12 +875,29 @@ int part_get_info_by_name(struct blk_desc *dev_desc, const char *name,
 	disk_partition_t *info)
 {
 	struct part_driver *part_drv;
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *cache;
+#endif
 	int ret;
 	int i;
 
 	part_drv = part_driver_lookup_type(dev_desc);
 	if (!part_drv)
 		return -1;
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	cache = part_cache_get(dev_desc, part_drv);
+	if (cache) {
+		for (i = cache->hash[part_cache_hash(name)]; i >= 0;
+		     i = cache->next[i]) {
+			if (!strcmp(name, (const char *)cache->info[i].name)) {
+				memcpy(info, &cache->info[i], sizeof(*info));
+				return i + 1;
+			}
+		}
+
+		return -1;
+	}
+#endif
 	for (i = 1; i < part_drv->max_entries; i++) {
 		ret = part_drv->get_info(dev_desc, i, info);
 		if (ret != 0) {
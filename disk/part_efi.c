@@ -266,39 +266,72 @@ void part_print_efi(struct blk_desc *dev_desc)
 	return;
 }
 
-int part_get_info_efi(struct blk_desc *dev_desc, int part,
-		      disk_partition_t *info)
-{
-	static gpt_entry *gpt_pte = NULL;
-	static gpt_header *gpt_head = NULL;
+/*
+ * GPT last read by part_get_info_efi(), so that looking up each partition in
+ * turn validates the table only once. See part_invalidate_efi().
+ */
+static gpt_header *efi_gpt_head;
+static gpt_entry *efi_gpt_pte;
+static struct blk_desc *efi_gpt_desc;
+static int efi_gpt_hwpart;
 
-	if (!gpt_head)
-		gpt_head = memalign(ARCH_DMA_MINALIGN, dev_desc->blksz);
+static void part_invalidate_efi(struct blk_desc *dev_desc)
+{
+	if (dev_desc != efi_gpt_desc)
+		return;
+	free(efi_gpt_pte);
+	efi_gpt_pte = NULL;
+	efi_gpt_desc = NULL;
+}
 
-	/* We suppose different dev have different size, eg. emmc vs sd */
-	if (gpt_head && (gpt_head->last_usable_lba + 0x22) != dev_desc->lba)
-		gpt_pte = NULL;
+static int part_read_efi(struct blk_desc *dev_desc)
+{
+	if (efi_gpt_pte && efi_gpt_desc == dev_desc &&
+	    efi_gpt_hwpart == dev_desc->hwpart)
+		return 0;
 
-	/* "part" argument must be at least 1 */
-	if (part < 1) {
-		printf("%s: Invalid Argument(s)\n", __func__);
-		return -1;
-	}
+	part_invalidate_efi(efi_gpt_desc);
+	free(efi_gpt_head);
+	efi_gpt_head = memalign(ARCH_DMA_MINALIGN, dev_desc->blksz);
+	if (!efi_gpt_head)
+		return -ENOMEM;
 
 	/* This function validates AND fills in the GPT header and PTE */
 	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
+			 efi_gpt_head, &efi_gpt_pte) != 1) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		if (is_gpt_valid(dev_desc, (dev_desc->lba - 1),
-				 gpt_head, &gpt_pte) != 1) {
+				 efi_gpt_head, &efi_gpt_pte) != 1) {
 			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
 			       __func__);
-			return -1;
+			return -EINVAL;
 		} else {
 			printf("%s: ***        Using Backup GPT ***\n",
 			       __func__);
 		}
 	}
+	efi_gpt_desc = dev_desc;
+	efi_gpt_hwpart = dev_desc->hwpart;
+
+	return 0;
+}
+
+int part_get_info_efi(struct blk_desc *dev_desc, int part,
+		      disk_partition_t *info)
+{
+	gpt_header *gpt_head;
+	gpt_entry *gpt_pte;
+
+	/* "part" argument must be at least 1 */
+	if (part < 1) {
+		printf("%s: Invalid Argument(s)\n", __func__);
+		return -1;
+	}
+
+	if (part_read_efi(dev_desc))
+		return -1;
+	gpt_head = efi_gpt_head;
+	gpt_pte = efi_gpt_pte;
 
 	if (part > le32_to_cpu(gpt_head->num_partition_entries) ||
 	    !is_pte_valid(&gpt_pte[part - 1])) {
@@ -424,6 +457,7 @@ int write_gpt_table(struct blk_desc *dev_desc,
 		       gpt_h) != 1)
 		goto err;
 
+	part_cache_invalidate(dev_desc);
 	debug("GPT successfully written to block device!\n");
 	return 0;
 
@@ -878,6 +912,7 @@ int write_mbr_and_gpt_partitions(struct blk_desc *dev_desc, void *buf)
 		       __func__, "Backup GPT Header", cnt, lba);
 		return 1;
 	}
+	part_cache_invalidate(dev_desc);
 
 	return 0;
 }
@@ -1089,5 +1124,6 @@ U_BOOT_PART_TYPE(a_efi) = {
 	.get_info	= part_get_info_ptr(part_get_info_efi),
 	.print		= part_print_ptr(part_print_efi),
 	.test		= part_test_efi,
+	.invalidate	= part_invalidate_efi,
 };
 #endif
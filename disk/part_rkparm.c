@@ -29,6 +29,17 @@ struct rkparm_part {
 static LIST_HEAD(parts_head);
 static int dev_num = -1;
 
+static void rkparm_free_parts(void)
+{
+	struct rkparm_part *part, *tmp;
+
+	list_for_each_entry_safe(part, tmp, &parts_head, node) {
+		list_del(&part->node);
+		free(part);
+	}
+	dev_num = -1;
+}
+
 static int rkparm_param_parse(char *param, struct list_head *parts_head,
 			      struct blk_desc *dev_desc)
 {
@@ -114,14 +125,18 @@ static int rkparm_init_param(struct blk_desc *dev_desc,
 	if (dev_desc->if_type != IF_TYPE_RKNAND)
 		offset = RK_PARAM_OFFSET;
 
+	rkparm_free_parts();
 	ret = blk_dread(dev_desc, offset, MAX_PARAM_SIZE >> 9, (ulong *)param);
 	if (ret != (MAX_PARAM_SIZE >> 9)) {
 		printf("%s param read fail\n", __func__);
+		free(param);
 		return -EINVAL;
 	}
 
-	return rkparm_param_parse(param->params, parts_head, dev_desc);
+	ret = rkparm_param_parse(param->params, parts_head, dev_desc);
+	free(param);
 
+	return ret;
 }
 
 static void part_print_rkparm(struct blk_desc *dev_desc)
@@ -196,6 +211,12 @@ static int part_get_info_rkparm(struct blk_desc *dev_desc, int idx,
 	return 0;
 }
 
+static void part_invalidate_rkparm(struct blk_desc *dev_desc)
+{
+	if (dev_num == ((dev_desc->if_type << 8) + dev_desc->devnum))
+		rkparm_free_parts();
+}
+
 static int part_test_rkparm(struct blk_desc *dev_desc)
 {
 	int ret = 0;
@@ -219,5 +240,6 @@ U_BOOT_PART_TYPE(b_rkparm) = {
 	.get_info	= part_get_info_ptr(part_get_info_rkparm),
 	.print		= part_print_ptr(part_print_rkparm),
 	.test		= part_test_rkparm,
+	.invalidate	= part_invalidate_rkparm,
 };
 #endif
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <blk.h>
 #include <dm.h>
+#include <part.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -437,6 +438,7 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	part_cache_invalidate_range(block_dev, start, blkcnt);
 	return ops->write(dev, start, blkcnt, buffer);
 }
 
@@ -450,6 +452,7 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	part_cache_invalidate_range(block_dev, start, blkcnt);
 	return ops->erase(dev, start, blkcnt);
 }
 
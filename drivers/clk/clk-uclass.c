@@ -371,19 +371,7 @@ int clk_disable(struct clk *clk)
 
 int clks_probe(void)
 {
-	struct udevice *dev;
-	struct uclass *uc;
-	int ret;
-
-	ret = uclass_get(UCLASS_CLK, &uc);
-	if (ret)
-		return ret;
-
-	uclass_foreach_dev(dev, uc) {
-		ret = device_probe(dev);
-		if (ret)
-			printf("%s - probe failed: %d\n", dev->name, ret);
-	}
+	uclass_probe_all(UCLASS_CLK);
 
 	return 0;
 }
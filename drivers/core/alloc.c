@@ -0,0 +1,248 @@
+/*
+ * Size-class allocator for driver model data
+ *
+ * Devices, uclasses and their private and platform data are small objects,
+ * most of which live until the OS is booted. Giving each of them its own
+ * malloc() chunk costs a call into dlmalloc and a chunk header apiece, so
+ * objects up to DM_ALLOC_MAX bytes are instead rounded up to a power of two
+ * and bump-allocated from pages holding a single size class. Freed objects
+ * go on a free list for their class, and a page is given back to malloc()
+ * once all of its objects are freed.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <dm/alloc.h>
+#include <linux/list.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct dm_alloc_page - Header of a page of objects
+ *
+ * @node:	Entry in dm_alloc_pages
+ * @cls:	Size class of the objects, object size is DM_ALLOC_MIN << cls
+ * @top:	Offset of the first object never handed out
+ * @live:	Number of objects allocated from this page
+ */
+struct dm_alloc_page {
+	struct list_head node;
+	uint cls;
+	uint top;
+	uint live;
+};
+
+#define DM_ALLOC_HDR_SIZE	ALIGN(sizeof(struct dm_alloc_page), DM_ALLOC_MIN)
+
+static LIST_HEAD(dm_alloc_pages);
+/* Page each class bump-allocates from */
+static struct dm_alloc_page *dm_alloc_cur[DM_ALLOC_CLASSES];
+/* Freed objects of each class, linked through their first word */
+static void *dm_alloc_free_list[DM_ALLOC_CLASSES];
+static struct dm_alloc_stats dm_alloc_stats;
+static bool dm_alloc_disabled;
+
+static uint dm_alloc_class(size_t size)
+{
+	uint cls = 0;
+
+	while ((DM_ALLOC_MIN << cls) < size)
+		cls++;
+
+	return cls;
+}
+
+/* Keep track of the heap used, for chunks allocated after relocation */
+static void dm_alloc_account(void *ptr, bool alloc)
+{
+	struct dm_alloc_stats *stats = &dm_alloc_stats;
+	ulong size;
+
+	if ((ulong)ptr < mem_malloc_start || (ulong)ptr >= mem_malloc_end)
+		return;
+	size = malloc_usable_size(ptr) + sizeof(size_t);
+	if (alloc) {
+		stats->mallocs++;
+		stats->heap += size;
+		stats->heap_peak = max(stats->heap_peak, stats->heap);
+	} else {
+		stats->heap -= min(stats->heap, size);
+	}
+}
+
+static struct dm_alloc_page *dm_alloc_find_page(void *ptr)
+{
+	struct dm_alloc_page *page;
+
+	list_for_each_entry(page, &dm_alloc_pages, node) {
+		if (ptr > (void *)page && ptr < (void *)page + DM_ALLOC_PAGE_SIZE)
+			return page;
+	}
+
+	return NULL;
+}
+
+static void *dm_alloc_large(size_t size)
+{
+	void *ptr;
+
+	ptr = calloc(1, size);
+	if (ptr) {
+		dm_alloc_stats.large++;
+		dm_alloc_account(ptr, true);
+	}
+
+	return ptr;
+}
+
+void *dm_calloc(size_t size)
+{
+	struct dm_alloc_page *page;
+	uint cls, slot;
+	void *ptr;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return calloc(1, size);
+	if (dm_alloc_disabled || size > DM_ALLOC_MAX)
+		return dm_alloc_large(size);
+
+	cls = dm_alloc_class(size);
+	slot = DM_ALLOC_MIN << cls;
+	if (IS_ENABLED(CONFIG_DM_ALLOC_REUSE) && dm_alloc_free_list[cls]) {
+		ptr = dm_alloc_free_list[cls];
+		dm_alloc_free_list[cls] = *(void **)ptr;
+		page = dm_alloc_find_page(ptr);
+		dm_alloc_stats.reused++;
+	} else {
+		page = dm_alloc_cur[cls];
+		if (!page || page->top + slot > DM_ALLOC_PAGE_SIZE) {
+			page = malloc(DM_ALLOC_PAGE_SIZE);
+			if (!page)
+				return dm_alloc_large(size);
+			page->cls = cls;
+			page->top = DM_ALLOC_HDR_SIZE;
+			page->live = 0;
+			list_add(&page->node, &dm_alloc_pages);
+			dm_alloc_cur[cls] = page;
+			dm_alloc_stats.pages++;
+			dm_alloc_account(page, true);
+		}
+		ptr = (void *)page + page->top;
+		page->top += slot;
+	}
+	page->live++;
+	memset(ptr, '\0', size);
+	dm_alloc_stats.allocs[cls]++;
+	dm_alloc_stats.live[cls]++;
+	dm_alloc_stats.requested += size;
+	dm_alloc_stats.slot_bytes += slot;
+
+	return ptr;
+}
+
+/* Give back an empty page, dropping its objects from the free list */
+static void dm_alloc_free_page(struct dm_alloc_page *page)
+{
+	void **link = &dm_alloc_free_list[page->cls];
+
+	while (*link) {
+		if (dm_alloc_find_page(*link) == page)
+			*link = *(void **)*link;
+		else
+			link = *link;
+	}
+	if (dm_alloc_cur[page->cls] == page)
+		dm_alloc_cur[page->cls] = NULL;
+	list_del(&page->node);
+	dm_alloc_stats.pages_freed++;
+	dm_alloc_account(page, false);
+	free(page);
+}
+
+void dm_free(void *ptr)
+{
+	struct dm_alloc_page *page;
+
+	if (!ptr)
+		return;
+	page = dm_alloc_find_page(ptr);
+	if (!page) {
+		if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+			dm_alloc_stats.large_freed++;
+			dm_alloc_account(ptr, false);
+		}
+		free(ptr);
+		return;
+	}
+
+	dm_alloc_stats.frees[page->cls]++;
+	dm_alloc_stats.live[page->cls]--;
+	if (!--page->live) {
+		dm_alloc_free_page(page);
+	} else if (IS_ENABLED(CONFIG_DM_ALLOC_REUSE)) {
+		*(void **)ptr = dm_alloc_free_list[page->cls];
+		dm_alloc_free_list[page->cls] = ptr;
+	}
+}
+
+void dm_alloc_get_stats(struct dm_alloc_stats *stats)
+{
+	*stats = dm_alloc_stats;
+}
+
+void dm_alloc_clear_stats(void)
+{
+	struct dm_alloc_stats *stats = &dm_alloc_stats;
+	ulong live[DM_ALLOC_CLASSES];
+	ulong heap = stats->heap;
+
+	memcpy(live, stats->live, sizeof(live));
+	memset(stats, '\0', sizeof(*stats));
+	memcpy(stats->live, live, sizeof(live));
+	stats->heap = heap;
+	stats->heap_peak = heap;
+}
+
+void dm_alloc_set_enabled(bool enable)
+{
+	dm_alloc_disabled = !enable;
+}
+
+void dm_dump_alloc(void)
+{
+	struct dm_alloc_stats *stats = &dm_alloc_stats;
+	struct dm_alloc_page *page;
+	ulong pages[DM_ALLOC_CLASSES] = { 0 };
+	ulong free_slots[DM_ALLOC_CLASSES] = { 0 };
+	uint cls, slot;
+
+	list_for_each_entry(page, &dm_alloc_pages, node) {
+		slot = DM_ALLOC_MIN << page->cls;
+		pages[page->cls]++;
+		free_slots[page->cls] += (DM_ALLOC_PAGE_SIZE - DM_ALLOC_HDR_SIZE) /
+					 slot - page->live;
+	}
+
+	printf(" Size  Pages   Live  Allocs   Frees  Unused\n");
+	for (cls = 0; cls < DM_ALLOC_CLASSES; cls++) {
+		printf("%5u  %5lu  %5lu  %6lu  %6lu  %6lu\n",
+		       DM_ALLOC_MIN << cls, pages[cls], stats->live[cls],
+		       stats->allocs[cls], stats->frees[cls], free_slots[cls]);
+	}
+	printf("Reused from free lists: %lu\n", stats->reused);
+	printf("Pages: %lu allocated, %lu given back\n", stats->pages,
+	       stats->pages_freed);
+	printf("Passed to malloc: %lu allocated, %lu freed\n", stats->large,
+	       stats->large_freed);
+	printf("Calls to malloc: %lu\n", stats->mallocs);
+	if (stats->slot_bytes) {
+		printf("Rounding waste: %lu of %lu bytes (%lu%%)\n",
+		       stats->slot_bytes - stats->requested, stats->slot_bytes,
+		       (stats->slot_bytes - stats->requested) * 100 /
+		       stats->slot_bytes);
+	}
+	printf("Heap: %lu bytes, peak %lu bytes\n", stats->heap,
+	       stats->heap_peak);
+}
@@ -12,6 +12,7 @@
 #include <common.h>
 #include <errno.h>
 #include <malloc.h>
+#include <dm/alloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/uclass.h>
@@ -93,15 +94,15 @@ int device_unbind(struct udevice *dev)
 		return ret;
 
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		dm_free(dev->platdata);
 		dev->platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		dm_free(dev->uclass_platdata);
 		dev->uclass_platdata = NULL;
 	}
 	if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-		free(dev->parent_platdata);
+		dm_free(dev->parent_platdata);
 		dev->parent_platdata = NULL;
 	}
 	ret = uclass_unbind_device(dev);
@@ -115,7 +116,7 @@ int device_unbind(struct udevice *dev)
 
 	if (dev->flags & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
-	free(dev);
+	dm_free(dev);
 
 	return 0;
 }
@@ -129,12 +130,12 @@ void device_free(struct udevice *dev)
 	int size;
 
 	if (dev->driver->priv_auto_alloc_size) {
-		free(dev->priv);
+		dm_free(dev->priv);
 		dev->priv = NULL;
 	}
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size) {
-		free(dev->uclass_priv);
+		dm_free(dev->uclass_priv);
 		dev->uclass_priv = NULL;
 	}
 	if (dev->parent) {
@@ -144,7 +145,7 @@ void device_free(struct udevice *dev)
 					per_child_auto_alloc_size;
 		}
 		if (size) {
-			free(dev->parent_priv);
+			dm_free(dev->parent_priv);
 			dev->parent_priv = NULL;
 		}
 	}
@@ -15,12 +15,14 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <dm/alloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/of_access.h>
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
+#include <dm/probe.h>
 #include <dm/read.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
@@ -72,7 +74,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 	}
 #endif
-	dev = calloc(1, sizeof(struct udevice));
+	dev = dm_calloc(sizeof(struct udevice));
 	if (!dev)
 		return -ENOMEM;
 
@@ -120,8 +122,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (alloc) {
 			dev->flags |= DM_FLAG_ALLOC_PDATA;
-			dev->platdata = calloc(1,
-					       drv->platdata_auto_alloc_size);
+			dev->platdata = dm_calloc(drv->platdata_auto_alloc_size);
 			if (!dev->platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
@@ -136,7 +137,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	size = uc->uc_drv->per_device_platdata_auto_alloc_size;
 	if (size) {
 		dev->flags |= DM_FLAG_ALLOC_UCLASS_PDATA;
-		dev->uclass_platdata = calloc(1, size);
+		dev->uclass_platdata = dm_calloc(size);
 		if (!dev->uclass_platdata) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -151,7 +152,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		}
 		if (size) {
 			dev->flags |= DM_FLAG_ALLOC_PARENT_PDATA;
-			dev->parent_platdata = calloc(1, size);
+			dev->parent_platdata = dm_calloc(size);
 			if (!dev->parent_platdata) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -214,24 +215,24 @@ fail_uclass_bind:
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		list_del(&dev->sibling_node);
 		if (dev->flags & DM_FLAG_ALLOC_PARENT_PDATA) {
-			free(dev->parent_platdata);
+			dm_free(dev->parent_platdata);
 			dev->parent_platdata = NULL;
 		}
 	}
 fail_alloc3:
 	if (dev->flags & DM_FLAG_ALLOC_UCLASS_PDATA) {
-		free(dev->uclass_platdata);
+		dm_free(dev->uclass_platdata);
 		dev->uclass_platdata = NULL;
 	}
 fail_alloc2:
 	if (dev->flags & DM_FLAG_ALLOC_PDATA) {
-		free(dev->platdata);
+		dm_free(dev->platdata);
 		dev->platdata = NULL;
 	}
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	dm_free(dev);
 
 	return ret;
 }
@@ -311,25 +312,19 @@ static void *alloc_priv(int size, uint flags)
 #endif
 		}
 	} else {
-		priv = calloc(1, size);
+		priv = dm_calloc(size);
 	}
 
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int size = 0;
 	int ret;
 	int seq;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (dev->flags & DM_FLAG_ACTIVATED)
-		return 0;
-
 	drv = dev->driver;
 	assert(drv);
 
@@ -344,7 +339,7 @@ int device_probe(struct udevice *dev)
 	/* Allocate private data if requested and not reentered */
 	size = dev->uclass->uc_drv->per_device_auto_alloc_size;
 	if (size && !dev->uclass_priv) {
-		dev->uclass_priv = calloc(1, size);
+		dev->uclass_priv = dm_calloc(size);
 		if (!dev->uclass_priv) {
 			ret = -ENOMEM;
 			goto fail;
@@ -449,6 +444,23 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	int trace, ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev->flags & DM_FLAG_ACTIVATED)
+		return 0;
+
+	trace = dm_probe_trace_start(dev);
+	ret = device_do_probe(dev);
+	dm_probe_trace_end(trace, ret);
+
+	return ret;
+}
+
 void *dev_get_platdata(struct udevice *dev)
 {
 	if (!dev) {
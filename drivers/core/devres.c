@@ -12,6 +12,7 @@
 #include <linux/compat.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
+#include <dm/alloc.h>
 #include <dm/device.h>
 #include <dm/root.h>
 #include <dm/util.h>
@@ -65,7 +66,7 @@ void *_devres_alloc(dr_release_t release, size_t size, gfp_t gfp)
 	size_t tot_size = sizeof(struct devres) + size;
 	struct devres *dr;
 
-	dr = kmalloc(tot_size, gfp);
+	dr = dm_calloc(tot_size);
 	if (unlikely(!dr))
 		return NULL;
 
@@ -82,7 +83,7 @@ void devres_free(void *res)
 		struct devres *dr = container_of(res, struct devres, data);
 
 		BUG_ON(!list_empty(&dr->entry));
-		kfree(dr);
+		dm_free(dr);
 	}
 }
 
@@ -183,7 +184,7 @@ static void release_nodes(struct udevice *dev, struct list_head *head,
 		devres_log(dev, dr, "REL");
 		dr->release(dev, dr->data);
 		list_del(&dr->entry);
-		kfree(dr);
+		dm_free(dr);
 	}
 }
 
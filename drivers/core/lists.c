@@ -16,8 +16,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -123,10 +126,205 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+/**
+ * struct lists_compat - Entry in an index of driver compatible strings
+ *
+ * @hash:	Hash of the compatible string
+ * @driver:	Index of the driver in the linker list
+ * @of_id:	Index of the compatible string in the driver's of_match
+ */
+struct lists_compat {
+	u32 hash;
+	u16 driver;
+	u16 of_id;
+};
+
+#if !defined(CONFIG_SPL_BUILD) && defined(CONFIG_DM_COMPAT_TABLE)
+#define LISTS_COMPAT_MAGIC	0x54434d44	/* "DMCT" */
+
+/**
+ * struct lists_compat_table - Index of compatible strings made at build time
+ *
+ * @magic:	LISTS_COMPAT_MAGIC
+ * @count:	Number of entries, 0 if tools/dm-compat-table has not been run
+ * @drivers:	Number of drivers in the linker list when the index was made
+ * @entry:	Entries sorted by hash
+ */
+struct lists_compat_table {
+	u32 magic;
+	u16 count;
+	u16 drivers;
+	struct lists_compat entry[CONFIG_DM_COMPAT_TABLE_SIZE];
+};
+
+/* Filled in after linking, so it is in .data and usable before relocation */
+struct lists_compat_table lists_compat_table = {
+	.magic	= LISTS_COMPAT_MAGIC,
+};
+#endif
+
+#ifndef CONFIG_SPL_BUILD
+/* Index built on the first lookup after relocation, if there is no table */
+static struct lists_compat *lists_compat_index;
+static uint lists_compat_count;
+#endif
+
+static u32 lists_compat_hash(const char *str)
+{
+	u32 hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619;
+	}
+
+	return hash ?: 1;
+}
+
+static const char *lists_compat_str(struct driver *driver,
+				    const struct lists_compat *ent)
+{
+	return driver[ent->driver].of_match[ent->of_id].compatible;
+}
+
+#ifndef CONFIG_SPL_BUILD
+static int lists_compat_cmp(const void *a, const void *b)
+{
+	const struct lists_compat *ca = a, *cb = b;
+
+	if (ca->hash != cb->hash)
+		return ca->hash < cb->hash ? -1 : 1;
+	if (ca->driver != cb->driver)
+		return ca->driver < cb->driver ? -1 : 1;
+
+	return ca->of_id - cb->of_id;
+}
+
+static int lists_compat_build(struct driver *driver, const int n_ents)
+{
+	const struct udevice_id *of_id;
+	struct lists_compat *index;
+	struct driver *entry;
+	uint count = 0, i, out;
+	int j;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++)
+			count++;
+	}
+	index = calloc(count, sizeof(*index));
+	if (!index)
+		return -ENOMEM;
+
+	count = 0;
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			index[count].hash = lists_compat_hash(of_id->compatible);
+			index[count].driver = entry - driver;
+			index[count].of_id = of_id - entry->of_match;
+			count++;
+		}
+	}
+	qsort(index, count, sizeof(*index), lists_compat_cmp);
+
+	/*
+	 * Keep only the first driver in the linker list for each string, as
+	 * a linear search would find
+	 */
+	for (i = 0, out = 0; i < count; i++) {
+		for (j = out - 1; j >= 0 && index[j].hash == index[i].hash;
+		     j--) {
+			if (!strcmp(lists_compat_str(driver, &index[j]),
+				    lists_compat_str(driver, &index[i])))
+				break;
+		}
+		if (j < 0 || index[j].hash != index[i].hash)
+			index[out++] = index[i];
+	}
+	lists_compat_index = index;
+	lists_compat_count = out;
+
+	return 0;
+}
+#endif
+
+/*
+ * Get the index of compatible strings: the one made at build time if the
+ * image has it, else one built now if relocation is done, else NULL
+ */
+static const struct lists_compat *lists_compat_get(struct driver *driver,
+						   const int n_ents,
+						   uint *countp)
+{
+#if !defined(CONFIG_SPL_BUILD) && defined(CONFIG_DM_COMPAT_TABLE)
+	const struct lists_compat_table *table = &lists_compat_table;
+
+	if (table->magic == LISTS_COMPAT_MAGIC && table->count &&
+	    table->drivers == n_ents) {
+		*countp = table->count;
+		return table->entry;
+	}
+#endif
+#ifndef CONFIG_SPL_BUILD
+	/* BSS is not usable before relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+	if (!lists_compat_index && lists_compat_build(driver, n_ents))
+		return NULL;
+	*countp = lists_compat_count;
+
+	return lists_compat_index;
+#else
+	return NULL;
+#endif
+}
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct lists_compat *index, *ent;
+	struct driver *entry;
+	uint count, lo, hi, mid;
+	u32 hash;
+
+	/* Only the linker knows the size of the list, so don't let gcc guess */
+	OPTIMIZER_HIDE_VAR(driver);
+	index = lists_compat_get(driver, n_ents, &count);
+	if (index) {
+		hash = lists_compat_hash(compat);
+		for (lo = 0, hi = count; lo < hi;) {
+			mid = (lo + hi) / 2;
+			if (index[mid].hash < hash)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		for (ent = index + lo; ent < index + count && ent->hash == hash;
+		     ent++) {
+			if (!strcmp(lists_compat_str(driver, ent), compat)) {
+				entry = driver + ent->driver;
+				*of_idp = entry->of_match + ent->of_id;
+				return entry;
+			}
+		}
+
+		return NULL;
+	}
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -163,14 +361,11 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry) {
+			ret = -ENOENT;
 			continue;
+		}
 
 		pr_debug("   - found match at '%s'\n", entry->name);
 		ret = device_bind_with_driver_data(parent, entry, name,
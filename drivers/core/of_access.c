@@ -44,6 +44,14 @@ static struct device_node *of_stdout;
 /* pointer to options given after the alias (separated by :) or NULL if none */
 static const char *of_stdout_options;
 
+/*
+ * Nodes indexed by phandle, for the tree at of_phandle_root. dtc numbers
+ * phandles from 1 upwards so the table is dense.
+ */
+static struct device_node **of_phandles;
+static phandle of_phandle_max;
+static struct device_node *of_phandle_root;
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -384,6 +392,11 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+	if (of_phandles && of_phandle_root == gd->of_root) {
+		np = handle <= of_phandle_max ? of_phandles[handle] : NULL;
+		return of_node_get(np);
+	}
+
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
@@ -392,6 +405,37 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	return np;
 }
 
+int of_phandle_scan(struct device_node *root)
+{
+	struct device_node *np;
+	phandle highest = 0;
+	int nodes = 0;
+
+	free(of_phandles);
+	of_phandles = NULL;
+	of_phandle_root = NULL;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		highest = max(highest, np->phandle);
+		nodes++;
+	}
+	/* Don't bother with a table for odd numbering, just use the walk */
+	if (!highest || highest > 2 * nodes)
+		return 0;
+
+	of_phandles = calloc(highest + 1, sizeof(*of_phandles));
+	if (!of_phandles)
+		return -ENOMEM;
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle && !of_phandles[np->phandle])
+			of_phandles[np->phandle] = np;
+	}
+	of_phandle_max = highest;
+	of_phandle_root = root;
+
+	return 0;
+}
+
 /**
  * of_find_property_value_of_size() - find property of given size
  *
@@ -0,0 +1,189 @@
+/*
+ * Probe tracing and deferral for driver model
+ *
+ * Init code probes whole uclasses with uclass_probe_all() so that their
+ * devices are ready, although a normal boot may never use most of them.
+ * With CONFIG_DM_PROBE_LAZY only the uclasses needed by the boot flow are
+ * probed there, and the rest wait until something asks for a device.
+ *
+ * With CONFIG_DM_PROBE_TRACE each probe after relocation is recorded along
+ * with the probe which needed it, so that 'dm probe-trace' can show where
+ * the time goes and which devices pull in which others.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/probe.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TRACE)
+static struct dm_probe_record dm_probe_records[CONFIG_DM_PROBE_TRACE_SIZE];
+static int dm_probe_count;
+static int dm_probe_dropped;
+/* Record of the probe in progress, -1 if none */
+static int dm_probe_cur = -1;
+
+static struct dm_probe_record *dm_probe_new_record(void)
+{
+	struct dm_probe_record *rec;
+
+	/* The records are in BSS, which is not usable before relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+	if (dm_probe_count == CONFIG_DM_PROBE_TRACE_SIZE) {
+		dm_probe_dropped++;
+		return NULL;
+	}
+	rec = &dm_probe_records[dm_probe_count++];
+	memset(rec, '\0', sizeof(*rec));
+	rec->caller = dm_probe_cur;
+	if (dm_probe_cur != -1)
+		rec->depth = dm_probe_records[dm_probe_cur].depth + 1;
+
+	return rec;
+}
+
+int dm_probe_trace_start(struct udevice *dev)
+{
+	struct dm_probe_record *rec;
+
+	rec = dm_probe_new_record();
+	if (!rec)
+		return -1;
+	strlcpy(rec->name, dev->name, sizeof(rec->name));
+	rec->uclass = dev->uclass->uc_drv->name;
+	rec->start = timer_get_us();
+	dm_probe_cur = rec - dm_probe_records;
+
+	return dm_probe_cur;
+}
+
+void dm_probe_trace_end(int trace, int ret)
+{
+	struct dm_probe_record *rec;
+
+	if (trace == -1)
+		return;
+	rec = &dm_probe_records[trace];
+	rec->time = timer_get_us() - rec->start;
+	rec->ret = ret;
+	dm_probe_cur = rec->caller;
+}
+
+void dm_probe_trace_defer(enum uclass_id id, int count)
+{
+	struct dm_probe_record *rec;
+
+	rec = dm_probe_new_record();
+	if (!rec)
+		return;
+	snprintf(rec->name, sizeof(rec->name), "(%d device%s)", count,
+		 count == 1 ? "" : "s");
+	rec->uclass = uclass_get_name(id);
+	rec->deferred = true;
+}
+
+void dm_probe_trace_clear(void)
+{
+	dm_probe_count = 0;
+	dm_probe_dropped = 0;
+	dm_probe_cur = -1;
+}
+
+const struct dm_probe_record *dm_probe_trace_get(int *countp)
+{
+	*countp = dm_probe_count;
+
+	return dm_probe_records;
+}
+
+void dm_dump_probe_trace(void)
+{
+	struct dm_probe_record *rec;
+	ulong self, total = 0;
+	int i, j;
+
+	printf("  #  Needed by  Time (us)  Self (us)  Ret  %-14s Device\n",
+	       "Uclass");
+	for (i = 0; i < dm_probe_count; i++) {
+		rec = &dm_probe_records[i];
+		if (rec->caller == -1)
+			printf("%3d  %9s  ", i, "-");
+		else
+			printf("%3d  %9d  ", i, rec->caller);
+		if (rec->deferred) {
+			printf("%9s  %9s  %3s  ", "deferred", "", "");
+		} else {
+			self = rec->time;
+			for (j = i + 1; j < dm_probe_count; j++) {
+				if (dm_probe_records[j].caller == i)
+					self -= dm_probe_records[j].time;
+			}
+			printf("%9lu  %9lu  %3d  ", rec->time, self, rec->ret);
+			if (rec->caller == -1)
+				total += rec->time;
+		}
+		printf("%-14s %*s%s\n", rec->uclass ? rec->uclass : "?",
+		       rec->depth * 2, "", rec->name);
+	}
+	printf("%d records, %lu us probing", dm_probe_count, total);
+	if (dm_probe_dropped)
+		printf(", %d not recorded", dm_probe_dropped);
+	printf("\n");
+}
+#endif
+
+#if CONFIG_IS_ENABLED(DM_PROBE_LAZY)
+static bool dm_probe_needed_map[UCLASS_COUNT];
+static bool dm_probe_needed_valid;
+
+/* Check for @name as a word in the space-separated @list */
+static bool dm_probe_name_in_list(const char *list, const char *name)
+{
+	int len = strlen(name);
+	const char *end;
+
+	while (*list) {
+		end = strchrnul(list, ' ');
+		if (end - list == len && !strncmp(list, name, len))
+			return true;
+		list = *end ? end + 1 : end;
+	}
+
+	return false;
+}
+
+static void dm_probe_init_needed(void)
+{
+	const char *name;
+	int id;
+
+	for (id = 0; id < UCLASS_COUNT; id++) {
+		name = uclass_get_name(id);
+		if (name && dm_probe_name_in_list(CONFIG_DM_PROBE_BOOT_UCLASSES,
+						  name))
+			dm_probe_needed_map[id] = true;
+	}
+	dm_probe_needed_valid = true;
+}
+
+bool dm_probe_needed(enum uclass_id id)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return true;
+	if (!dm_probe_needed_valid)
+		dm_probe_init_needed();
+
+	return dm_probe_needed_map[id];
+}
+
+void dm_probe_set_needed(enum uclass_id id, bool needed)
+{
+	if (!dm_probe_needed_valid)
+		dm_probe_init_needed();
+	dm_probe_needed_map[id] = needed;
+}
+#endif
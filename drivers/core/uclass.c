@@ -11,9 +11,11 @@
 #include <dm.h>
 #include <errno.h>
 #include <malloc.h>
+#include <dm/alloc.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/probe.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -69,11 +71,11 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 		 */
 		return -EPFNOSUPPORT;
 	}
-	uc = calloc(1, sizeof(*uc));
+	uc = dm_calloc(sizeof(*uc));
 	if (!uc)
 		return -ENOMEM;
 	if (uc_drv->priv_auto_alloc_size) {
-		uc->priv = calloc(1, uc_drv->priv_auto_alloc_size);
+		uc->priv = dm_calloc(uc_drv->priv_auto_alloc_size);
 		if (!uc->priv) {
 			ret = -ENOMEM;
 			goto fail_mem;
@@ -95,12 +97,12 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 	return 0;
 fail:
 	if (uc_drv->priv_auto_alloc_size) {
-		free(uc->priv);
+		dm_free(uc->priv);
 		uc->priv = NULL;
 	}
 	list_del(&uc->sibling_node);
 fail_mem:
-	free(uc);
+	dm_free(uc);
 
 	return ret;
 }
@@ -133,8 +135,8 @@ int uclass_destroy(struct uclass *uc)
 		uc_drv->destroy(uc);
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
-		free(uc->priv);
-	free(uc);
+		dm_free(uc->priv);
+	dm_free(uc);
 
 	return 0;
 }
@@ -564,6 +566,33 @@ int uclass_next_device_check(struct udevice **devp)
 	return device_probe(*devp);
 }
 
+int uclass_probe_all(enum uclass_id id)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret, err = 0;
+
+	ret = uclass_get(id, &uc);
+	if (ret)
+		return ret;
+
+	if (!dm_probe_needed(id)) {
+		dm_probe_trace_defer(id, list_count_items(&uc->dev_head));
+		return 0;
+	}
+
+	uclass_foreach_dev(dev, uc) {
+		ret = device_probe(dev);
+		if (ret) {
+			printf("%s - probe failed: %d\n", dev->name, ret);
+			if (!err)
+				err = ret;
+		}
+	}
+
+	return err;
+}
+
 int uclass_bind_device(struct udevice *dev)
 {
 	struct uclass *uc;
@@ -0,0 +1,178 @@
+/*
+ * Hash engine uclass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <watchdog.h>
+#include <u-boot/hash.h>
+
+struct hash_algo_info {
+	const char *name;
+	int digest_size;
+	uint32_t chunk_size;
+};
+
+static const struct hash_algo_info hash_algo_info[HASH_ALGO_NUM] = {
+	[HASH_ALGO_CRC32]	= { "crc32", 4, 64 * 1024 },
+	[HASH_ALGO_MD5]		= { "md5", 16, 64 * 1024 },
+	[HASH_ALGO_SHA1]	= { "sha1", 20, 64 * 1024 },
+	[HASH_ALGO_SHA256]	= { "sha256", 32, 64 * 1024 },
+	[HASH_ALGO_SHA512]	= { "sha512", 64, 64 * 1024 },
+};
+
+enum HASH_ALGO hash_algo_lookup_by_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < HASH_ALGO_NUM; i++) {
+		if (!strcmp(name, hash_algo_info[i].name))
+			return i;
+	}
+
+	return HASH_ALGO_INVALID;
+}
+
+int hash_algo_digest_size(enum HASH_ALGO algo)
+{
+	if (algo >= HASH_ALGO_NUM)
+		return -EINVAL;
+
+	return hash_algo_info[algo].digest_size;
+}
+
+const char *hash_algo_name(enum HASH_ALGO algo)
+{
+	if (algo >= HASH_ALGO_NUM)
+		return "unknown";
+
+	return hash_algo_info[algo].name;
+}
+
+int hash_get_device(enum HASH_ALGO algo, struct udevice **devp)
+{
+	struct udevice *dev, *best = NULL;
+	const struct hash_ops *ops;
+	int best_prio = 0;
+	int ret;
+
+	for (ret = uclass_first_device_check(UCLASS_HASH, &dev);
+	     dev;
+	     ret = uclass_next_device_check(&dev)) {
+		if (ret)
+			continue;
+		ops = device_get_ops(dev);
+		if (!ops->supported || !ops->supported(dev, algo))
+			continue;
+		if (!best || ops->priority > best_prio) {
+			best = dev;
+			best_prio = ops->priority;
+		}
+	}
+
+	if (!best) {
+		debug("%s: no engine for %s\n", __func__, hash_algo_name(algo));
+		return -ENODEV;
+	}
+	*devp = best;
+
+	return 0;
+}
+
+int hash_init(struct udevice *dev, enum HASH_ALGO algo, void **ctxp)
+{
+	const struct hash_ops *ops = device_get_ops(dev);
+
+	if (!ops->hash_init)
+		return -ENOSYS;
+
+	return ops->hash_init(dev, algo, ctxp);
+}
+
+int hash_update(struct udevice *dev, void *ctx, const void *ibuf,
+		uint32_t ilen)
+{
+	const struct hash_ops *ops = device_get_ops(dev);
+
+	if (!ops->hash_update)
+		return -ENOSYS;
+
+	return ops->hash_update(dev, ctx, ibuf, ilen);
+}
+
+int hash_finish(struct udevice *dev, void *ctx, void *obuf)
+{
+	const struct hash_ops *ops = device_get_ops(dev);
+
+	if (!ops->hash_finish)
+		return -ENOSYS;
+
+	return ops->hash_finish(dev, ctx, obuf);
+}
+
+int hash_digest_wd(struct udevice *dev, enum HASH_ALGO algo,
+		   const void *ibuf, uint32_t ilen, void *obuf,
+		   uint32_t chunk_sz)
+{
+	const struct hash_ops *ops = device_get_ops(dev);
+	const uint8_t *end = ibuf + ilen;
+	const uint8_t *curr = ibuf;
+	uint32_t chunk;
+	void *ctx;
+	int ret;
+
+	if (ops->hash_digest_wd)
+		return ops->hash_digest_wd(dev, algo, ibuf, ilen, obuf,
+					   chunk_sz);
+
+	ret = hash_init(dev, algo, &ctx);
+	if (ret)
+		return ret;
+
+	while (curr < end) {
+		chunk = min_t(uint32_t, end - curr, chunk_sz);
+		ret = hash_update(dev, ctx, curr, chunk);
+		if (ret)
+			return ret;
+		curr += chunk;
+		WATCHDOG_RESET();
+	}
+
+	return hash_finish(dev, ctx, obuf);
+}
+
+int hash_digest_by_name(const char *name, const void *ibuf, uint32_t ilen,
+			void *obuf, int *olen)
+{
+	enum HASH_ALGO algo;
+	struct udevice *dev;
+	int size, ret;
+
+	algo = hash_algo_lookup_by_name(name);
+	if (algo == HASH_ALGO_INVALID)
+		return -EPROTONOSUPPORT;
+
+	size = hash_algo_digest_size(algo);
+	if (*olen < size)
+		return -ENOSPC;
+
+	ret = hash_get_device(algo, &dev);
+	if (ret)
+		return ret;
+
+	ret = hash_digest_wd(dev, algo, ibuf, ilen, obuf,
+			     hash_algo_info[algo].chunk_size);
+	if (ret)
+		return ret;
+	*olen = size;
+
+	return 0;
+}
+
+UCLASS_DRIVER(hash) = {
+	.id	= UCLASS_HASH,
+	.name	= "hash",
+};
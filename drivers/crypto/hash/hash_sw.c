@@ -0,0 +1,195 @@
+/*
+ * Software hash engine, backed by the lib/ implementations
+ *
+ * The SHA-1/SHA-256 block functions pick up the ARMv8 Crypto Extensions at
+ * run time when CONFIG_ARMV8_CE_SHA1/SHA256 are enabled.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+#include <u-boot/hash.h>
+#include <u-boot/md5.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+
+struct sw_hash_ctx {
+	enum HASH_ALGO algo;
+	union {
+		uint32_t crc32;
+#ifdef CONFIG_MD5
+		struct MD5Context md5;
+#endif
+#ifdef CONFIG_SHA1
+		sha1_context sha1;
+#endif
+#ifdef CONFIG_SHA256
+		sha256_context sha256;
+#endif
+#ifdef CONFIG_SHA512
+		sha512_context sha512;
+#endif
+	};
+};
+
+static bool sw_hash_supported(struct udevice *dev, enum HASH_ALGO algo)
+{
+	switch (algo) {
+	case HASH_ALGO_CRC32:
+		return true;
+	case HASH_ALGO_MD5:
+		return IS_ENABLED(CONFIG_MD5);
+	case HASH_ALGO_SHA1:
+		return IS_ENABLED(CONFIG_SHA1);
+	case HASH_ALGO_SHA256:
+		return IS_ENABLED(CONFIG_SHA256);
+	case HASH_ALGO_SHA512:
+		return IS_ENABLED(CONFIG_SHA512);
+	default:
+		return false;
+	}
+}
+
+static int sw_hash_init(struct udevice *dev, enum HASH_ALGO algo, void **ctxp)
+{
+	struct sw_hash_ctx *ctx;
+
+	if (!sw_hash_supported(dev, algo))
+		return -EPROTONOSUPPORT;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+	ctx->algo = algo;
+
+	switch (algo) {
+	case HASH_ALGO_CRC32:
+		ctx->crc32 = 0;
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Init(&ctx->md5);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_starts(&ctx->sha1);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_starts(&ctx->sha256);
+		break;
+#endif
+#ifdef CONFIG_SHA512
+	case HASH_ALGO_SHA512:
+		sha512_starts(&ctx->sha512);
+		break;
+#endif
+	default:
+		break;
+	}
+	*ctxp = ctx;
+
+	return 0;
+}
+
+static int sw_hash_update(struct udevice *dev, void *vctx, const void *ibuf,
+			  uint32_t ilen)
+{
+	struct sw_hash_ctx *ctx = vctx;
+
+	switch (ctx->algo) {
+	case HASH_ALGO_CRC32:
+		ctx->crc32 = crc32(ctx->crc32, ibuf, ilen);
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Update(&ctx->md5, ibuf, ilen);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_update(&ctx->sha1, ibuf, ilen);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_update(&ctx->sha256, ibuf, ilen);
+		break;
+#endif
+#ifdef CONFIG_SHA512
+	case HASH_ALGO_SHA512:
+		sha512_update(&ctx->sha512, ibuf, ilen);
+		break;
+#endif
+	default:
+		free(ctx);
+		return -EPROTONOSUPPORT;
+	}
+
+	return 0;
+}
+
+static int sw_hash_finish(struct udevice *dev, void *vctx, void *obuf)
+{
+	struct sw_hash_ctx *ctx = vctx;
+	int ret = 0;
+
+	switch (ctx->algo) {
+	case HASH_ALGO_CRC32:
+		/* Same byte order as crc32_wd_buf() */
+		*(uint32_t *)obuf = cpu_to_be32(ctx->crc32);
+		break;
+#ifdef CONFIG_MD5
+	case HASH_ALGO_MD5:
+		MD5Final(obuf, &ctx->md5);
+		break;
+#endif
+#ifdef CONFIG_SHA1
+	case HASH_ALGO_SHA1:
+		sha1_finish(&ctx->sha1, obuf);
+		break;
+#endif
+#ifdef CONFIG_SHA256
+	case HASH_ALGO_SHA256:
+		sha256_finish(&ctx->sha256, obuf);
+		break;
+#endif
+#ifdef CONFIG_SHA512
+	case HASH_ALGO_SHA512:
+		sha512_finish(&ctx->sha512, obuf);
+		break;
+#endif
+	default:
+		ret = -EPROTONOSUPPORT;
+		break;
+	}
+	free(ctx);
+
+	return ret;
+}
+
+static const struct hash_ops hash_ops_sw = {
+	.priority	= 0,
+	.supported	= sw_hash_supported,
+	.hash_init	= sw_hash_init,
+	.hash_update	= sw_hash_update,
+	.hash_finish	= sw_hash_finish,
+};
+
+U_BOOT_DRIVER(hash_sw) = {
+	.name	= "hash_sw",
+	.id	= UCLASS_HASH,
+	.ops	= &hash_ops_sw,
+	.flags	= DM_FLAG_PRE_RELOC,
+};
+
+U_BOOT_DEVICE(hash_sw) = {
+	.name = "hash_sw",
+};
@@ -23,6 +23,7 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	int ret;
 
 	mmmc_trace_before_send(mmc, cmd);
+	mmc_count_cmd(mmc, cmd);
 	if (ops->send_cmd)
 		ret = ops->send_cmd(dev, cmd, data);
 	else
@@ -17,9 +17,11 @@
 #include <part.h>
 #include <power/regulator.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <memalign.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <u-boot/crc.h>
 #include "mmc_private.h"
 
 static const unsigned int sd_au_size[] = {
@@ -155,6 +157,7 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	int ret;
 
 	mmmc_trace_before_send(mmc, cmd);
+	mmc_count_cmd(mmc, cmd);
 	ret = mmc->cfg->ops->send_cmd(mmc, cmd, data);
 	mmmc_trace_after_send(mmc, cmd, ret);
 
@@ -209,14 +212,33 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc_card_ddr(mmc))
 		return 0;
 
+	/* The card keeps the block length until it is reset */
+	if (mmc->blocklen == len)
+		return 0;
+
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
 
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->blocklen = err ? 0 : len;
+
+	return err;
+}
+
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = blkcnt & 0xffff;
+
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
@@ -225,11 +247,17 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool stop = false;
 
-	if (blkcnt > 1)
+	if (blkcnt > 1) {
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
-	else
+		if (!mmc_can_cmd23(mmc, blkcnt))
+			stop = true;
+		else if (mmc_set_block_count(mmc, blkcnt))
+			return 0;
+	} else {
 		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+	}
 
 	if (mmc->high_capacity)
 		cmd.cmdarg = start;
@@ -246,7 +274,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (stop) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -282,12 +310,18 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (!mmc)
 		return 0;
 
-	if (CONFIG_IS_ENABLED(MMC_TINY))
-		err = mmc_switch_part(mmc, block_dev->hwpart);
-	else
-		err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+	if (block_dev->hwpart != mmc->part_num) {
+		if (CONFIG_IS_ENABLED(MMC_TINY))
+			err = mmc_switch_part(mmc, block_dev->hwpart);
+		else
+			err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+
+		if (err < 0)
+			return 0;
+	}
 
-	if (err < 0)
+	/* Reads must see any writes gathered by a write session */
+	if (mmc_write_cache_sync(mmc))
 		return 0;
 
 	if ((start + blkcnt) > block_dev->lba) {
@@ -351,6 +385,7 @@ static int mmc_go_idle(struct mmc *mmc)
 
 	udelay(1000);
 
+	mmc->blocklen = 0;
 	cmd.cmdidx = MMC_CMD_GO_IDLE_STATE;
 	cmd.cmdarg = 0;
 	cmd.resp_type = MMC_RSP_NONE;
@@ -543,6 +578,73 @@ static int mmc_send_ext_csd(struct mmc *mmc, u8 *ext_csd)
 	return err;
 }
 
+#ifdef CONFIG_MMC_FAST_RESUME
+#define MMC_RESUME_MAGIC	0x4d435344	/* "MCSD" */
+
+/**
+ * struct mmc_resume - EXT_CSD handed over from SPL to U-Boot proper
+ *
+ * @magic:	MMC_RESUME_MAGIC if the rest is valid
+ * @crc:	CRC32 of @cid and @ext_csd
+ * @cid:	CID of the card which @ext_csd was read from
+ * @ext_csd:	EXT_CSD as read by mmc_startup()
+ */
+struct mmc_resume {
+	u32 magic;
+	u32 crc;
+	u32 cid[4];
+	u8 ext_csd[MMC_MAX_BLOCK_LEN];
+};
+
+static u32 mmc_resume_crc(struct mmc_resume *resume)
+{
+	return crc32(0, (u8 *)resume->cid,
+		     sizeof(*resume) - offsetof(struct mmc_resume, cid));
+}
+#endif
+
+/*
+ * Read the EXT_CSD for mmc_startup(). With CONFIG_MMC_FAST_RESUME, SPL leaves
+ * a copy in memory and U-Boot proper uses it for the first init of the same
+ * card rather than reading it again. Later inits read it from the card, since
+ * the card may have been reconfigured in between.
+ */
+static int mmc_read_ext_csd(struct mmc *mmc, u8 *ext_csd)
+{
+#ifdef CONFIG_MMC_FAST_RESUME
+	struct mmc_resume *resume;
+#endif
+	int err;
+
+#if defined(CONFIG_MMC_FAST_RESUME) && !defined(CONFIG_SPL_BUILD)
+	resume = map_sysmem(CONFIG_MMC_FAST_RESUME_ADDR, sizeof(*resume));
+	if (resume->magic == MMC_RESUME_MAGIC &&
+	    !memcmp(resume->cid, mmc->cid, sizeof(resume->cid)) &&
+	    resume->crc == mmc_resume_crc(resume)) {
+		memcpy(ext_csd, resume->ext_csd, MMC_MAX_BLOCK_LEN);
+		resume->magic = 0;
+		unmap_sysmem(resume);
+		return 0;
+	}
+	unmap_sysmem(resume);
+#endif
+
+	err = mmc_send_ext_csd(mmc, ext_csd);
+	if (err)
+		return err;
+
+#if defined(CONFIG_MMC_FAST_RESUME) && defined(CONFIG_SPL_BUILD)
+	resume = map_sysmem(CONFIG_MMC_FAST_RESUME_ADDR, sizeof(*resume));
+	memcpy(resume->cid, mmc->cid, sizeof(resume->cid));
+	memcpy(resume->ext_csd, ext_csd, MMC_MAX_BLOCK_LEN);
+	resume->crc = mmc_resume_crc(resume);
+	resume->magic = MMC_RESUME_MAGIC;
+	unmap_sysmem(resume);
+#endif
+
+	return 0;
+}
+
 static int mmc_poll_for_busy(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -607,7 +709,11 @@ int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value)
 	return __mmc_switch(mmc, set, index, value, true);
 }
 
-static int mmc_select_bus_width(struct mmc *mmc)
+/*
+ * @ext_csd is the EXT_CSD read by mmc_startup(), which the EXT_CSD read at the
+ * new bus width is checked against
+ */
+static int mmc_select_bus_width(struct mmc *mmc, const u8 *ext_csd)
 {
 	u32 ext_csd_bits[] = {
 		EXT_CSD_BUS_WIDTH_8,
@@ -617,7 +723,6 @@ static int mmc_select_bus_width(struct mmc *mmc)
 		MMC_BUS_WIDTH_8BIT,
 		MMC_BUS_WIDTH_4BIT,
 	};
-	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
 	ALLOC_CACHE_ALIGN_BUFFER(u8, test_csd, MMC_MAX_BLOCK_LEN);
 	u32 idx, bus_width = 0;
 	int err = 0;
@@ -626,11 +731,6 @@ static int mmc_select_bus_width(struct mmc *mmc)
 	    !(mmc->cfg->host_caps & (MMC_MODE_4BIT | MMC_MODE_8BIT)))
 		return 0;
 
-	err = mmc_send_ext_csd(mmc, ext_csd);
-
-	if (err)
-		return err;
-
 	idx = (mmc->cfg->host_caps & MMC_MODE_8BIT) ? 0 : 1;
 
 	/*
@@ -817,7 +917,7 @@ static int mmc_select_hs_ddr(struct mmc *mmc)
 }
 
 #ifndef CONFIG_SPL_BUILD
-static int mmc_select_hs200(struct mmc *mmc)
+static int mmc_select_hs200(struct mmc *mmc, const u8 *ext_csd)
 {
 	int ret;
 	struct mmc_cmd cmd;
@@ -826,7 +926,7 @@ static int mmc_select_hs200(struct mmc *mmc)
 	 * Set the bus width(4 or 8) with host's support and
 	 * switch to HS200 mode if bus width is set successfully.
 	 */
-	ret = mmc_select_bus_width(mmc);
+	ret = mmc_select_bus_width(mmc, ext_csd);
 
 	if (ret > 0) {
 		ret = __mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
@@ -894,7 +994,7 @@ static int mmc_select_hs400(struct mmc *mmc)
 	return ret;
 }
 
-static u32 mmc_select_card_type(struct mmc *mmc, u8 *ext_csd)
+static u32 mmc_select_card_type(struct mmc *mmc, const u8 *ext_csd)
 {
 	u8 card_type;
 	u32 host_caps, avail_type = 0;
@@ -960,9 +1060,8 @@ static void mmc_set_bus_speed(struct mmc *mmc, u8 avail_type)
 	mmc_set_clock(mmc, clock);
 }
 
-static int mmc_change_freq(struct mmc *mmc)
+static int mmc_change_freq(struct mmc *mmc, const u8 *ext_csd)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
 	u32 avail_type;
 	int err;
 
@@ -977,16 +1076,11 @@ static int mmc_change_freq(struct mmc *mmc)
 
 	mmc->card_caps |= MMC_MODE_4BIT | MMC_MODE_8BIT;
 
-	err = mmc_send_ext_csd(mmc, ext_csd);
-
-	if (err)
-		return err;
-
 	avail_type = mmc_select_card_type(mmc, ext_csd);
 
 #ifndef CONFIG_SPL_BUILD
 	if (avail_type & EXT_CSD_CARD_TYPE_HS200)
-		err = mmc_select_hs200(mmc);
+		err = mmc_select_hs200(mmc, ext_csd);
 	else
 #endif
 	if (avail_type & EXT_CSD_CARD_TYPE_HS)
@@ -1007,7 +1101,7 @@ static int mmc_change_freq(struct mmc *mmc)
 			mmc_set_bus_speed(mmc, avail_type);
 		}
 	} else if (!mmc_card_hs400es(mmc)) {
-		err = mmc_select_bus_width(mmc) > 0 ? 0 : err;
+		err = mmc_select_bus_width(mmc, ext_csd) > 0 ? 0 : err;
 		if (!err && avail_type & EXT_CSD_CARD_TYPE_DDR_52)
 			err = mmc_select_hs_ddr(mmc);
 	}
@@ -1047,6 +1141,10 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num)
 {
 	int ret;
 
+	ret = mmc_write_cache_sync(mmc);
+	if (ret)
+		return ret;
+
 	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_PART_CONF,
 			 (mmc->part_config & ~PART_ACCESS_MASK)
 			 | (part_num & PART_ACCESS_MASK));
@@ -1055,6 +1153,8 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num)
 	 * Set the capacity if the switch succeeded or was intended
 	 * to return to representing the raw device.
 	 */
+	if (ret == 0)
+		mmc->part_num = part_num;
 	if ((ret == 0) || ((ret == -ENODEV) && (part_num == 0))) {
 		ret = mmc_set_capacity(mmc, part_num);
 		mmc_get_blk_desc(mmc)->hwpart = part_num;
@@ -1670,9 +1770,10 @@ static int mmc_startup(struct mmc *mmc)
 	 */
 	mmc->erase_grp_size = 1;
 	mmc->part_config = MMCPART_NOAVAILABLE;
+	mmc->part_num = 0;
 	if (!IS_SD(mmc) && (mmc->version >= MMC_VERSION_4)) {
 		/* check  ext_csd version and capacity */
-		err = mmc_send_ext_csd(mmc, ext_csd);
+		err = mmc_read_ext_csd(mmc, ext_csd);
 		if (err)
 			return err;
 		if (ext_csd[EXT_CSD_REV] >= 2) {
@@ -1725,13 +1826,23 @@ static int mmc_startup(struct mmc *mmc)
 		/* store the partition info of emmc */
 		mmc->part_support = ext_csd[EXT_CSD_PARTITIONING_SUPPORT];
 		if ((ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT) ||
-		    ext_csd[EXT_CSD_BOOT_MULT])
+		    ext_csd[EXT_CSD_BOOT_MULT]) {
 			mmc->part_config = ext_csd[EXT_CSD_PART_CONF];
+			mmc->part_num = mmc->part_config & PART_ACCESS_MASK;
+		}
 		if (part_completed &&
 		    (ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & ENHNCD_SUPPORT))
 			mmc->part_attr = ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE];
 		if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
 			mmc->esr.mmc_can_trim = 1;
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+		if (ext_csd[EXT_CSD_REV] >= 6)
+			mmc->cache_size =
+				((u32)ext_csd[EXT_CSD_CACHE_SIZE + 3] << 24) +
+				((u32)ext_csd[EXT_CSD_CACHE_SIZE + 2] << 16) +
+				((u32)ext_csd[EXT_CSD_CACHE_SIZE + 1] << 8) +
+				(u32)ext_csd[EXT_CSD_CACHE_SIZE];
+#endif
 
 		mmc->capacity_boot = ext_csd[EXT_CSD_BOOT_MULT] << 17;
 
@@ -1829,7 +1940,7 @@ static int mmc_startup(struct mmc *mmc)
 	if (IS_SD(mmc))
 		err = sd_change_freq(mmc);
 	else
-		err = mmc_change_freq(mmc);
+		err = mmc_change_freq(mmc, ext_csd);
 
 	if (err)
 		return err;
@@ -2131,11 +2242,7 @@ static int mmc_probe(bd_t *bis)
 		if (ret == -ENODEV)
 			break;
 	}
-	uclass_foreach_dev(dev, uc) {
-		ret = device_probe(dev);
-		if (ret)
-			printf("%s - probe failed: %d\n", dev->name, ret);
-	}
+	uclass_probe_all(UCLASS_MMC);
 
 	return 0;
 }
@@ -16,6 +16,32 @@ extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
+/*
+ * Multi-block transfers of up to 65535 blocks are started with CMD23 rather
+ * than ended with CMD12, when both the host and the card support it
+ */
+static inline bool mmc_can_cmd23(struct mmc *mmc, lbaint_t blkcnt)
+{
+	if (!IS_ENABLED(CONFIG_MMC_CMD23) ||
+	    !(mmc->cfg->host_caps & MMC_MODE_CMD23) ||
+	    mmc_host_is_spi(mmc) || blkcnt > 0xffff)
+		return false;
+	if (IS_SD(mmc))
+		return mmc->scr[0] & SD_SCR_CMD23;
+
+	return mmc->version >= MMC_VERSION_3;
+}
+
+static inline void mmc_count_cmd(struct mmc *mmc, struct mmc_cmd *cmd)
+{
+#if CONFIG_IS_ENABLED(MMC_CMD_STATS)
+	if (cmd->cmdidx < MMC_CMD_COUNT)
+		mmc->cmd_count[cmd->cmdidx]++;
+#endif
+}
+
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -72,6 +98,16 @@ static inline ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start,
 
 #endif /* CONFIG_SPL_BUILD */
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+/* Write out the data gathered by a write session, see mmc_write_cache_begin() */
+int mmc_write_cache_sync(struct mmc *mmc);
+#else
+static inline int mmc_write_cache_sync(struct mmc *mmc)
+{
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_MMC_TRACE
 void mmmc_trace_before_send(struct mmc *mmc, struct mmc_cmd *cmd);
 void mmmc_trace_after_send(struct mmc *mmc, struct mmc_cmd *cmd, int ret);
@@ -12,6 +12,9 @@
 #include <dm.h>
 #include <part.h>
 #include <div64.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <linux/list.h>
 #include <linux/math64.h>
 #include "mmc_private.h"
 
@@ -108,6 +111,9 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	if (err < 0)
 		return -1;
 
+	if (mmc_write_cache_sync(mmc))
+		return -1;
+
 	if (!IS_SD(mmc)) {
 		if (mmc->esr.mmc_can_trim)
 			mode = 1;
@@ -165,6 +171,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout = 1000;
+	bool stop = false;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -172,12 +179,21 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		return 0;
 	}
 
-	if (blkcnt == 0)
+	if (blkcnt == 0) {
 		return 0;
-	else if (blkcnt == 1)
+	} else if (blkcnt == 1) {
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
-	else
+	} else {
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
+		/*
+		 * SPI multiblock writes terminate using a special
+		 * token, not a STOP_TRANSMISSION request.
+		 */
+		if (!mmc_can_cmd23(mmc, blkcnt))
+			stop = !mmc_host_is_spi(mmc);
+		else if (mmc_set_block_count(mmc, blkcnt))
+			return 0;
+	}
 
 	if (mmc->high_capacity)
 		cmd.cmdarg = start;
@@ -196,10 +212,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		return 0;
 	}
 
-	/* SPI multiblock writes terminate using a special
-	 * token, not a STOP_TRANSMISSION request.
-	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (stop) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -216,6 +229,226 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+#define MMC_WRITE_CACHE_BLKS	(CONFIG_MMC_WRITE_CACHE_BATCH_KB * 2)
+
+/* Time allowed for the card to flush its cache, in ms */
+#define MMC_CACHE_FLUSH_TIMEOUT	30000
+
+/**
+ * struct mmc_write_cache - State of a card written during a write session
+ *
+ * @node:	Entry in mmc_write_cache_list
+ * @mmc:	Card being written
+ * @buf:	Small writes gathered to be sent as one transfer
+ * @start:	First block of the data in @buf
+ * @blkcnt:	Number of blocks in @buf
+ * @cache_on:	true if the card's volatile cache has been turned on
+ * @writes:	Number of writes made to the card
+ * @xfers:	Number of write transfers sent to the card
+ */
+struct mmc_write_cache {
+	struct list_head node;
+	struct mmc *mmc;
+	void *buf;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	bool cache_on;
+	ulong writes;
+	ulong xfers;
+};
+#endif
+
+/* Write @blkcnt blocks in transfers of at most b_max blocks */
+static ulong mmc_write_run(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+			   const void *src)
+{
+	lbaint_t cur, blocks_todo = blkcnt;
+
+	do {
+		cur = (blocks_todo > mmc->cfg->b_max) ?
+			mmc->cfg->b_max : blocks_todo;
+		if (mmc_write_blocks(mmc, start, cur, src) != cur)
+			return 0;
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+		if (mmc->wcache)
+			mmc->wcache->xfers++;
+#endif
+		blocks_todo -= cur;
+		start += cur;
+		src += cur * mmc->write_bl_len;
+	} while (blocks_todo > 0);
+
+	return blkcnt;
+}
+
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+static LIST_HEAD(mmc_write_cache_list);
+static bool mmc_write_cache_active;
+
+/* Set up a card for the write session the first time it is written */
+static struct mmc_write_cache *mmc_write_cache_get(struct mmc *mmc)
+{
+	struct mmc_write_cache *wc;
+
+	if (!mmc_write_cache_active || mmc->wcache)
+		return mmc->wcache;
+
+	wc = calloc(1, sizeof(*wc));
+	if (!wc)
+		return NULL;
+	wc->buf = malloc_cache_aligned(MMC_WRITE_CACHE_BLKS * MMC_MAX_BLOCK_LEN);
+	if (!wc->buf) {
+		free(wc);
+		return NULL;
+	}
+	wc->mmc = mmc;
+
+	if (!IS_SD(mmc) && mmc->cache_size) {
+		if (mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+			       EXT_CSD_CACHE_CTRL, 1))
+			printf("MMC: Cannot turn on the cache\n");
+		else
+			wc->cache_on = true;
+	}
+	list_add_tail(&wc->node, &mmc_write_cache_list);
+	mmc->wcache = wc;
+
+	return wc;
+}
+
+int mmc_write_cache_sync(struct mmc *mmc)
+{
+	struct mmc_write_cache *wc = mmc->wcache;
+	lbaint_t blkcnt;
+
+	if (!wc || !wc->blkcnt)
+		return 0;
+
+	blkcnt = wc->blkcnt;
+	wc->blkcnt = 0;
+	if (mmc_set_blocklen(mmc, mmc->write_bl_len) ||
+	    mmc_write_run(mmc, wc->start, blkcnt, wc->buf) != blkcnt)
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * Gather a small write into the card's buffer. Returns true if it was
+ * gathered, false if it must be written now, with anything already gathered
+ * written out first.
+ */
+static bool mmc_write_cache_add(struct mmc *mmc, lbaint_t start,
+				lbaint_t blkcnt, const void *src, int *errp)
+{
+	struct mmc_write_cache *wc = mmc_write_cache_get(mmc);
+	bool fits;
+
+	*errp = 0;
+	if (!wc)
+		return false;
+
+	wc->writes++;
+	fits = blkcnt < MMC_WRITE_CACHE_BLKS &&
+		start + blkcnt <= mmc_get_blk_desc(mmc)->lba;
+	if (wc->blkcnt && (!fits || start != wc->start + wc->blkcnt ||
+			   wc->blkcnt + blkcnt > MMC_WRITE_CACHE_BLKS))
+		*errp = mmc_write_cache_sync(mmc);
+	if (*errp || !fits)
+		return false;
+
+	if (!wc->blkcnt)
+		wc->start = start;
+	memcpy(wc->buf + wc->blkcnt * mmc->write_bl_len, src,
+	       blkcnt * mmc->write_bl_len);
+	wc->blkcnt += blkcnt;
+
+	return true;
+}
+
+/* Write out the gathered data and flush the card's cache, if turned on */
+static int mmc_write_cache_flush_card(struct mmc_write_cache *wc)
+{
+	struct mmc *mmc = wc->mmc;
+	int err;
+
+	err = mmc_write_cache_sync(mmc);
+	if (!err && wc->cache_on) {
+		err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+				 EXT_CSD_FLUSH_CACHE, 1);
+		/* A large cache may take longer than a switch */
+		if (err == -ETIMEDOUT)
+			err = mmc_send_status(mmc, MMC_CACHE_FLUSH_TIMEOUT);
+	}
+
+	return err;
+}
+
+void mmc_write_cache_begin(void)
+{
+	mmc_write_cache_active = true;
+}
+
+int mmc_write_cache_flush(void)
+{
+	struct mmc_write_cache *wc;
+	int ret = 0;
+	int err;
+
+	list_for_each_entry(wc, &mmc_write_cache_list, node) {
+		err = mmc_write_cache_flush_card(wc);
+		if (err) {
+			printf("MMC%d: write session flush failed (err=%d)\n",
+			       mmc_get_blk_desc(wc->mmc)->devnum, err);
+			if (!ret)
+				ret = err;
+		}
+	}
+
+	return ret;
+}
+
+int mmc_write_cache_end(void)
+{
+	struct mmc_write_cache *wc, *next;
+	struct mmc *mmc;
+	int ret = 0;
+	int err;
+
+	list_for_each_entry_safe(wc, next, &mmc_write_cache_list, node) {
+		mmc = wc->mmc;
+		err = mmc_write_cache_flush_card(wc);
+		if (!err && wc->cache_on)
+			err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+					 EXT_CSD_CACHE_CTRL, 0);
+		printf("MMC%d: %lu writes in %lu transfers (%lu saved)%s%s\n",
+		       mmc_get_blk_desc(mmc)->devnum, wc->writes, wc->xfers,
+		       wc->writes > wc->xfers ? wc->writes - wc->xfers : 0,
+		       wc->cache_on ? ", cache flushed" : "",
+		       err ? ", failed" : "");
+		if (err && !ret)
+			ret = err;
+		list_del(&wc->node);
+		mmc->wcache = NULL;
+		free(wc->buf);
+		free(wc);
+	}
+	mmc_write_cache_active = false;
+
+	return ret;
+}
+#else
+static inline bool mmc_write_cache_add(struct mmc *mmc, lbaint_t start,
+				       lbaint_t blkcnt, const void *src,
+				       int *errp)
+{
+	*errp = 0;
+
+	return false;
+}
+#endif
+
 #ifdef CONFIG_BLK
 ulong mmc_bwrite(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		 const void *src)
@@ -228,29 +461,26 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
 #endif
 	int dev_num = block_dev->devnum;
-	lbaint_t cur, blocks_todo = blkcnt;
 	int err;
 
 	struct mmc *mmc = find_mmc_device(dev_num);
 	if (!mmc)
 		return 0;
 
-	err = blk_select_hwpart_devnum(IF_TYPE_MMC, dev_num, block_dev->hwpart);
-	if (err < 0)
+	if (block_dev->hwpart != mmc->part_num) {
+		err = blk_select_hwpart_devnum(IF_TYPE_MMC, dev_num,
+					       block_dev->hwpart);
+		if (err < 0)
+			return 0;
+	}
+
+	if (mmc_write_cache_add(mmc, start, blkcnt, src, &err))
+		return blkcnt;
+	if (err)
 		return 0;
 
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
-	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
-		if (mmc_write_blocks(mmc, start, cur, src) != cur)
-			return 0;
-		blocks_todo -= cur;
-		start += cur;
-		src += cur * mmc->write_bl_len;
-	} while (blocks_todo > 0);
-
-	return blkcnt;
+	return mmc_write_run(mmc, start, blkcnt, src);
 }
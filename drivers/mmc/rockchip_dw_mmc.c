@@ -16,7 +16,9 @@
 #include <asm/gpio.h>
 #include <asm/arch/clock.h>
 #include <asm/arch/periph.h>
+#include <asm/arch/vendor.h>
 #include <linux/err.h>
+#include "mmc_private.h"
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -35,6 +37,9 @@ struct rockchip_dwmmc_priv {
 	int fifo_depth;
 	bool fifo_mode;
 	u32 minmax[2];
+#if CONFIG_IS_ENABLED(MMC_DW_ROCKCHIP_TUNING_CACHE)
+	bool tuning_loaded;
+#endif
 };
 
 static uint rockchip_dwmmc_get_mmc_clk(struct dwmci_host *host, uint freq)
@@ -106,6 +111,170 @@ static int rockchip_dwmmc_ofdata_to_platdata(struct udevice *dev)
 #define NUM_PHASES			270
 #define TUNING_ITERATION_TO_PHASE(i)	(DIV_ROUND_UP((i) * 270, NUM_PHASES))
 
+#if CONFIG_IS_ENABLED(MMC_DW_ROCKCHIP_TUNING_CACHE)
+#define TUNING_SAVED_MAX		4
+
+/**
+ * struct rockchip_dwmmc_tuning - Sample phase found by tuning a card
+ *
+ * @cid:	CID of the card
+ * @clock:	Card clock in Hz, 0 if the entry is unused
+ * @mode:	Timing in the upper 16 bits, bus width in the lower 16 bits
+ * @phase:	Sample clock phase in degrees
+ */
+struct rockchip_dwmmc_tuning {
+	u32 cid[4];
+	u32 clock;
+	u32 mode;
+	u32 phase;
+};
+
+/* Saved phases, most recently tuned first, stored as VENDOR_MMC_TUNING_ID */
+static struct rockchip_dwmmc_tuning tuning_saved[TUNING_SAVED_MAX];
+/* Card whose vendor storage holds tuning_saved, NULL if none */
+static struct mmc *tuning_mmc;
+static bool tuning_dirty;
+
+/* Read @n_sec blocks with as few commands as the host allows */
+static int rockchip_dwmmc_read_raw(void *priv, u32 sec, u32 n_sec,
+				   void *buffer)
+{
+	struct mmc *mmc = priv;
+	struct mmc_data data;
+	struct mmc_cmd cmd;
+	u32 done, cnt;
+
+	for (done = 0; done < n_sec; done += cnt) {
+		cnt = min(n_sec - done, mmc->cfg->b_max);
+		cmd.cmdidx = cnt > 1 ? MMC_CMD_READ_MULTIPLE_BLOCK :
+				       MMC_CMD_READ_SINGLE_BLOCK;
+		cmd.cmdarg = mmc->high_capacity ? sec + done :
+						  (sec + done) * 512;
+		cmd.resp_type = MMC_RSP_R1;
+		data.dest = buffer + done * 512;
+		data.blocks = cnt;
+		data.blocksize = 512;
+		data.flags = MMC_DATA_READ;
+		if (mmc_send_cmd(mmc, &cmd, &data))
+			break;
+		if (cnt > 1) {
+			cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+			cmd.cmdarg = 0;
+			cmd.resp_type = MMC_RSP_R1b;
+			if (mmc_send_cmd(mmc, &cmd, NULL))
+				break;
+		}
+	}
+
+	return done;
+}
+
+/*
+ * Check whether the vendor storage is on @mmc. Until rkimg_bootdev has set
+ * devtype, it is on the eMMC, as get_bootdev_type() assumes.
+ */
+static bool rockchip_dwmmc_vendor_mmc(struct mmc *mmc)
+{
+	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	const char *devtype = env_get("devtype");
+
+	if (IS_SD(mmc) || !desc)
+		return false;
+	if (!devtype)
+		return true;
+
+	return !strcmp(devtype, "mmc") &&
+	       desc->devnum == env_get_ulong("devnum", 10, 0);
+}
+
+/*
+ * The vendor storage is normally on the eMMC being tuned, which cannot do
+ * block reads yet, so read the saved phases from it directly at a clock which
+ * does not need tuning. Other cards are always tuned in full.
+ */
+static void rockchip_dwmmc_load_tuning(struct rockchip_dwmmc_priv *priv,
+				       struct mmc *mmc)
+{
+	uint clock = mmc->clock;
+	int ret;
+
+	priv->tuning_loaded = true;
+	if (tuning_mmc || !rockchip_dwmmc_vendor_mmc(mmc))
+		return;
+
+	tuning_mmc = mmc;
+	mmc_set_clock(mmc, min_t(uint, clock, MMC_HIGH_52_MAX_DTR));
+	ret = emmc_vendor_storage_peek(rockchip_dwmmc_read_raw, mmc,
+				       VENDOR_MMC_TUNING_ID, tuning_saved,
+				       sizeof(tuning_saved));
+	mmc_set_clock(mmc, clock);
+	if (ret != sizeof(tuning_saved)) {
+		debug("%s: no saved phases (err=%d)\n", __func__, ret);
+		memset(tuning_saved, '\0', sizeof(tuning_saved));
+	}
+}
+
+static struct rockchip_dwmmc_tuning *rockchip_dwmmc_find_tuning(
+							struct mmc *mmc)
+{
+	u32 mode = mmc->timing << 16 | mmc->bus_width;
+	struct rockchip_dwmmc_tuning *saved;
+
+	for (saved = tuning_saved; saved < tuning_saved + TUNING_SAVED_MAX;
+	     saved++) {
+		if (saved->clock == mmc->clock && saved->mode == mode &&
+		    !memcmp(saved->cid, mmc->cid, sizeof(saved->cid)))
+			return saved;
+	}
+
+	return NULL;
+}
+
+static void rockchip_dwmmc_save_phase(struct mmc *mmc, int phase)
+{
+	struct rockchip_dwmmc_tuning *saved;
+
+	if (mmc != tuning_mmc)
+		return;
+	saved = rockchip_dwmmc_find_tuning(mmc);
+	if (saved && saved->phase == phase)
+		return;
+	if (!saved)
+		saved = &tuning_saved[TUNING_SAVED_MAX - 1];
+
+	/* Drop this card's old entry, or the oldest one, and put it first */
+	memmove(&tuning_saved[1], &tuning_saved[0],
+		(saved - tuning_saved) * sizeof(*saved));
+	saved = &tuning_saved[0];
+	memcpy(saved->cid, mmc->cid, sizeof(saved->cid));
+	saved->clock = mmc->clock;
+	saved->mode = mmc->timing << 16 | mmc->bus_width;
+	saved->phase = phase;
+	tuning_dirty = true;
+}
+
+int rockchip_dwmmc_save_tuning(void)
+{
+	int ret;
+
+	if (!tuning_dirty)
+		return 0;
+
+	/* The boot device may have turned out not to be the tuned eMMC */
+	if (!rockchip_dwmmc_vendor_mmc(tuning_mmc)) {
+		tuning_dirty = false;
+		return 0;
+	}
+	ret = vendor_storage_write(VENDOR_MMC_TUNING_ID, tuning_saved,
+				   sizeof(tuning_saved));
+	if (ret < 0)
+		return ret;
+	tuning_dirty = false;
+
+	return 0;
+}
+#endif
+
 static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 {
 	int ret = 0;
@@ -120,13 +289,31 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 	int longest_range_len = -1;
 	int longest_range = -1;
 	int middle_phase;
+	int phase = 0;
 	struct udevice *dev = host->priv;
 	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
 	struct mmc *mmc = host->mmc;
+#if CONFIG_IS_ENABLED(MMC_DW_ROCKCHIP_TUNING_CACHE)
+	struct rockchip_dwmmc_tuning *saved;
+#endif
 
 	if (IS_ERR(&priv->sample_clk))
 		return -EIO;
 
+#if CONFIG_IS_ENABLED(MMC_DW_ROCKCHIP_TUNING_CACHE)
+	if (!priv->tuning_loaded)
+		rockchip_dwmmc_load_tuning(priv, mmc);
+	saved = mmc == tuning_mmc ? rockchip_dwmmc_find_tuning(mmc) : NULL;
+	if (saved) {
+		clk_set_phase(&priv->sample_clk, saved->phase);
+		if (!mmc_send_tuning(mmc, opcode)) {
+			debug("Using saved phase %d\n", saved->phase);
+			return 0;
+		}
+		debug("Saved phase %d failed, tuning again\n", saved->phase);
+	}
+#endif
+
 	ranges = calloc(sizeof(*ranges), NUM_PHASES / 2 + 1);
 	if (!ranges)
 		return -ENOMEM;
@@ -179,8 +366,8 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 	}
 
 	if (ranges[0].start == 0 && ranges[0].end == NUM_PHASES - 1) {
-		clk_set_phase(&priv->sample_clk,
-			      TUNING_ITERATION_TO_PHASE(NUM_PHASES / 2));
+		phase = TUNING_ITERATION_TO_PHASE(NUM_PHASES / 2);
+		clk_set_phase(&priv->sample_clk, phase);
 		debug("All phases work, using middle phase.\n");
 		goto free;
 	}
@@ -212,11 +399,15 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 	debug("Successfully tuned phase to %d\n",
 	      TUNING_ITERATION_TO_PHASE(middle_phase));
 
-	clk_set_phase(&priv->sample_clk,
-		      TUNING_ITERATION_TO_PHASE(middle_phase));
+	phase = TUNING_ITERATION_TO_PHASE(middle_phase);
+	clk_set_phase(&priv->sample_clk, phase);
 
 free:
 	free(ranges);
+#if CONFIG_IS_ENABLED(MMC_DW_ROCKCHIP_TUNING_CACHE)
+	if (!ret)
+		rockchip_dwmmc_save_phase(mmc, phase);
+#endif
 	return ret;
 }
 
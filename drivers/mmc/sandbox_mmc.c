@@ -14,16 +14,38 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Size of the card described by the CSD below: 1024 blocks of 1KiB */
+#define SANDBOX_MMC_SIZE	(1 << 20)
+
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	char buf[SANDBOX_MMC_SIZE];
 };
 
+/* Copy blocks to or from the card's memory */
+static int sandbox_mmc_xfer(struct udevice *dev, struct mmc_cmd *cmd,
+			    struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+	ulong offset = (ulong)cmd->cmdarg * data->blocksize;
+	ulong size = data->blocks * data->blocksize;
+
+	if (offset + size > SANDBOX_MMC_SIZE)
+		return -EINVAL;
+	if (data->flags & MMC_DATA_READ)
+		memcpy(data->dest, plat->buf + offset, size);
+	else
+		memcpy(plat->buf + offset, data->src, size);
+
+	return 0;
+}
+
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
- * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * This emulate a high-capacity SD card. Reads and writes go to a buffer in
+ * memory, which starts with a test string.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
@@ -54,12 +76,12 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
-		memset(data->dest, '\0', data->blocksize);
-		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
-		strcpy(data->dest, "this is a test");
-		break;
+	case MMC_CMD_WRITE_SINGLE_BLOCK:
+	case MMC_CMD_WRITE_MULTIPLE_BLOCK:
+		return sandbox_mmc_xfer(dev, cmd, data);
 	case MMC_CMD_STOP_TRANSMISSION:
+	case MMC_CMD_SET_BLOCK_COUNT:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
 		cmd->response[0] = OCR_BUSY | OCR_HCS;
@@ -74,7 +96,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, with CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_SCR_CMD23);
 		break;
 	}
 	default:
@@ -105,6 +128,8 @@ int sandbox_mmc_probe(struct udevice *dev)
 {
 	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
 
+	strcpy(plat->buf, "this is a test");
+
 	return mmc_init(&plat->mmc);
 }
 
@@ -114,7 +139,8 @@ int sandbox_mmc_bind(struct udevice *dev)
 	struct mmc_config *cfg = &plat->cfg;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_MODE_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
@@ -41,8 +41,24 @@ struct sandbox_serial_platdata {
 
 struct sandbox_serial_priv {
 	bool start_of_line;
+	int tx_busy;		/* Number of putc() calls to refuse */
+	ulong tx_count;		/* Number of characters written */
 };
 
+void sandbox_serial_set_tx_busy(struct udevice *dev, int count)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	priv->tx_busy = count;
+}
+
+ulong sandbox_serial_get_tx_count(struct udevice *dev)
+{
+	struct sandbox_serial_priv *priv = dev_get_priv(dev);
+
+	return priv->tx_count;
+}
+
 /**
  * output_ansi_colour() - Output an ANSI colour code
  *
@@ -88,12 +104,19 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	struct sandbox_serial_platdata *plat = dev->platdata;
 
+	/* Act as a UART whose TX FIFO is full */
+	if (priv->tx_busy > 0) {
+		priv->tx_busy--;
+		return -EAGAIN;
+	}
+
 	if (priv->start_of_line && plat->colour != -1) {
 		priv->start_of_line = false;
 		output_ansi_colour(plat->colour);
 	}
 
 	os_write(1, &ch, 1);
+	priv->tx_count++;
 	if (ch == '\n')
 		priv->start_of_line = true;
 
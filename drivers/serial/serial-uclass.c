@@ -141,6 +141,93 @@ void serial_initialize(void)
 	serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+static bool serial_tx_full(struct serial_dev_priv *upriv)
+{
+	return (upriv->tx_wr + 1) % CONFIG_SERIAL_TX_BUFFER_SIZE ==
+		upriv->tx_rd;
+}
+
+/* Send buffered output for as long as the UART takes it without waiting */
+static void serial_tx_drain(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+
+	while (upriv->tx_rd != upriv->tx_wr) {
+		if (ops->putc(dev, upriv->tx_buf[upriv->tx_rd]) == -EAGAIN)
+			break;
+		upriv->tx_rd++;
+		upriv->tx_rd %= CONFIG_SERIAL_TX_BUFFER_SIZE;
+	}
+}
+
+/* Send all buffered output, counting the time spent waiting for the UART */
+static void serial_tx_flush(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	serial_tx_drain(dev);
+	if (upriv->tx_rd == upriv->tx_wr)
+		return;
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SERIAL_TX, "serial_tx");
+	do {
+		serial_tx_drain(dev);
+	} while (upriv->tx_rd != upriv->tx_wr);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SERIAL_TX);
+}
+
+/* Add a character to the TX buffer, returning false if it is not in use */
+static bool serial_tx_put(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (!upriv->tx_buf)
+		return false;
+
+#ifdef GD_FLG_OS_RUN
+	/* Output from the OS handover on is not left behind in the buffer */
+	if (gd->flags & GD_FLG_OS_RUN) {
+		serial_tx_flush(dev);
+		return false;
+	}
+#endif
+
+	if (serial_tx_full(upriv)) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SERIAL_TX, "serial_tx");
+		do {
+			serial_tx_drain(dev);
+		} while (serial_tx_full(upriv));
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SERIAL_TX);
+	}
+	upriv->tx_buf[upriv->tx_wr++] = ch;
+	upriv->tx_wr %= CONFIG_SERIAL_TX_BUFFER_SIZE;
+	serial_tx_drain(dev);
+
+	return true;
+}
+
+void serial_flush(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_SERIAL, &uc))
+		return;
+	uclass_foreach_dev(dev, uc) {
+		if (device_active(dev))
+			serial_tx_flush(dev);
+	}
+}
+#else
+static inline bool serial_tx_put(struct udevice *dev, char ch)
+{
+	return false;
+}
+
+static inline void serial_tx_drain(struct udevice *dev) {}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
 static void _serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
@@ -149,6 +236,9 @@ static void _serial_putc(struct udevice *dev, char ch)
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
+	if (serial_tx_put(dev, ch))
+		return;
+
 	do {
 		err = ops->putc(dev, ch);
 	} while (err == -EAGAIN);
@@ -167,8 +257,11 @@ static int __serial_getc(struct udevice *dev)
 
 	do {
 		err = ops->getc(dev);
-		if (err == -EAGAIN)
+		if (err == -EAGAIN) {
 			WATCHDOG_RESET();
+			/* Send buffered output while waiting for input */
+			serial_tx_drain(dev);
+		}
 	} while (err == -EAGAIN);
 
 	return err >= 0 ? err : 0;
@@ -178,6 +271,8 @@ static int __serial_tstc(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	/* Input is polled from idle loops, which can send buffered output */
+	serial_tx_drain(dev);
 	if (ops->pending)
 		return ops->pending(dev, true);
 
@@ -402,6 +497,10 @@ static int serial_post_probe(struct udevice *dev)
 	/* Allocate the RX buffer */
 	upriv->buf = malloc(CONFIG_SERIAL_RX_BUFFER_SIZE);
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Allocate the TX buffer, output is sent directly without it */
+	upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+#endif
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
@@ -417,6 +516,10 @@ static int serial_pre_remove(struct udevice *dev)
 		return -EPERM;
 #endif
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	serial_tx_flush(dev);
+#endif
+
 	return 0;
 }
 
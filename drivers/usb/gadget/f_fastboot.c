@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <fastboot.h>
 #include <malloc.h>
+#include <mmc.h>
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
@@ -446,6 +447,7 @@ static int fastboot_tx_write_str(const char *buffer)
 
 static void compl_do_reset(struct usb_ep *ep, struct usb_request *req)
 {
+	mmc_write_cache_end();
 	do_reset(NULL, 0, 0, NULL);
 }
 
@@ -914,6 +916,7 @@ static void do_bootm_on_complete(struct usb_ep *ep, struct usb_request *req)
 	char boot_addr_start[12];
 	char *bootm_args[] = { "bootm", boot_addr_start, NULL };
 
+	mmc_write_cache_end();
 	puts("Booting kernel..\n");
 
 	sprintf(boot_addr_start, "0x%lx", (long)CONFIG_FASTBOOT_BUF_ADDR);
@@ -974,6 +977,18 @@ static void cb_set_active(struct usb_ep *ep, struct usb_request *req)
 }
 
 #ifdef CONFIG_FASTBOOT_FLASH
+#ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
+/*
+ * Write out what the write session still holds before replying, so that
+ * OKAY means the data is on the card
+ */
+static void fb_flush_write_cache(char *response)
+{
+	if (mmc_write_cache_flush() && !strncmp(response, "OKAY", 4))
+		fastboot_fail("cannot flush the write cache", response);
+}
+#endif
+
 static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
@@ -1010,6 +1025,7 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
 	fb_mmc_flash_write(cmd, (void *)CONFIG_FASTBOOT_BUF_ADDR,
 				download_bytes, response);
+	fb_flush_write_cache(response);
 #endif
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
 	fb_nand_flash_write(cmd, (void *)CONFIG_FASTBOOT_BUF_ADDR,
@@ -1447,6 +1463,7 @@ static void cb_erase(struct usb_ep *ep, struct usb_request *req)
 	fastboot_fail("no flash device defined", response);
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
 	fb_mmc_erase(cmd, response);
+	fb_flush_write_cache(response);
 #endif
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
 	fb_nand_erase(cmd, response);
@@ -245,6 +245,7 @@
 #include <common.h>
 #include <console.h>
 #include <g_dnl.h>
+#include <mmc.h>
 
 #include <linux/err.h>
 #include <linux/usb/ch9.h>
@@ -952,8 +953,11 @@ static int do_write(struct fsg_common *common)
 					       file_offset / SECTOR_SIZE,
 					       amount / SECTOR_SIZE,
 					       (char __user *)bh->buf);
-			if (!rc)
+			if (!rc) {
+				curlun->sense_data = SS_WRITE_ERROR;
+				curlun->info_valid = 1;
 				return -EIO;
+			}
 			nwritten = rc * SECTOR_SIZE;
 
 			VLDBG(curlun, "file write %u @ %llu -> %d\n", amount,
@@ -997,6 +1001,15 @@ static int do_write(struct fsg_common *common)
 			return rc;
 	}
 
+	/*
+	 * A write session, as rockusb runs, may still hold the data. Write it
+	 * out so that an error is reported in this command's status.
+	 */
+	if (!amount_left_to_write && mmc_write_cache_flush()) {
+		curlun->sense_data = SS_WRITE_ERROR;
+		curlun->info_valid = 1;
+	}
+
 	return -EIO;		/* No default reply */
 }
 
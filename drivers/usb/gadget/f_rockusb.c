@@ -13,6 +13,7 @@
 #include <asm/arch/vendor.h>
 #endif
 
+#include <mmc.h>
 #include <rockusb.h>
 
 #define ROCKUSB_INTERFACE_CLASS	0xff
@@ -130,6 +131,7 @@ static void __do_reset(struct usb_ep *ep, struct usb_request *req)
 
 	rkusb_rst_code = 0; /* restore to default */
 	writel(boot_flag, (void *)CONFIG_ROCKCHIP_BOOT_MODE_REG);
+	mmc_write_cache_end();
 
 	do_reset(NULL, 0, 0, NULL);
 }
@@ -344,12 +346,23 @@ static int rkusb_do_vs_write(struct fsg_common *common)
 			data  = bh->buf + sizeof(struct vendor_item);
 
 			if (!type) {
-				/* Vendor storage */
+				/* Vendor storage, the item must fit the data */
+				if (common->data_size < sizeof(*vhead) ||
+				    vhead->size > common->data_size -
+						  sizeof(*vhead)) {
+					curlun->sense_data =
+						SS_INVALID_FIELD_IN_CDB;
+					return -EINVAL;
+				}
 				rc = vendor_storage_write(vhead->id,
 							  (char __user *)data,
 							  vhead->size);
-				if (rc < 0)
+				if (rc >= 0)
+					rc = mmc_write_cache_flush();
+				if (rc < 0) {
+					curlun->sense_data = SS_WRITE_ERROR;
 					return -EIO;
+				}
 			} else {
 				/* RPMB */
 			}
@@ -177,8 +177,14 @@ int env_import(const char *buf, int check)
 		return ret;
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
-			0, NULL)) {
+	if (IS_ENABLED(CONFIG_ENV_BINARY) &&
+	    hsnapshot_check((char *)ep->data, ENV_SIZE))
+		ret = himport_snapshot_r(&env_htab, (char *)ep->data, ENV_SIZE,
+					 0);
+	else
+		ret = himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0',
+				0, 0, 0, NULL);
+	if (ret) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 1;
 	}
@@ -245,7 +251,14 @@ int env_export(env_t *env_out)
 	int ret;
 
 	res = (char *)env_out->data;
-	len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
+	len = -1;
+	if (IS_ENABLED(CONFIG_ENV_BINARY)) {
+		len = hexport_snapshot_r(&env_htab, res, ENV_SIZE);
+		if (len < 0)
+			debug("No room for environment snapshot, saving text\n");
+	}
+	if (len < 0)
+		len = hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL);
 	if (len < 0) {
 		pr_err("Cannot export environment: errno = %d\n", errno);
 		return 1;
@@ -183,15 +183,63 @@ static void fini_mmc_for_env(struct mmc *mmc)
 }
 
 #if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_SPL_BUILD)
+#ifdef CONFIG_ENV_BINARY
+/*
+ * Variables which have not changed keep their place in a snapshot, so only
+ * write the runs of blocks which differ from what is stored. Returns 1 if
+ * the stored blocks could not be read to compare.
+ */
+static int write_env_changed(struct blk_desc *desc, uint blk_start,
+			     uint blk_cnt, uint blksz, const u_char *buffer)
+{
+	u_char *old;
+	uint blk, run;
+
+	old = malloc_cache_aligned(blk_cnt * blksz);
+	if (!old)
+		return 1;
+	if (blk_dread(desc, blk_start, blk_cnt, old) != blk_cnt) {
+		free(old);
+		return 1;
+	}
+
+	for (blk = 0; blk < blk_cnt; blk += run) {
+		for (run = 0; blk + run < blk_cnt; run++) {
+			if (!memcmp(old + (blk + run) * blksz,
+				    buffer + (blk + run) * blksz, blksz))
+				break;
+		}
+		if (!run) {
+			run = 1;
+			continue;
+		}
+		if (blk_dwrite(desc, blk_start + blk, run,
+			       buffer + blk * blksz) != run)
+			break;
+	}
+	free(old);
+
+	return blk < blk_cnt ? -1 : 0;
+}
+#endif
+
 static inline int write_env(struct mmc *mmc, unsigned long size,
 			    unsigned long offset, const void *buffer)
 {
 	uint blk_start, blk_cnt, n;
 	struct blk_desc *desc = mmc_get_blk_desc(mmc);
+	__maybe_unused int ret;
 
 	blk_start	= ALIGN(offset, mmc->write_bl_len) / mmc->write_bl_len;
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
+#ifdef CONFIG_ENV_BINARY
+	ret = write_env_changed(desc, blk_start, blk_cnt, mmc->write_bl_len,
+				buffer);
+	if (ret <= 0)
+		return ret;
+#endif
+
 	n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
 
 	return (n == blk_cnt) ? 0 : -1;
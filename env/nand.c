@@ -36,6 +36,12 @@
 #error CONFIG_ENV_SIZE_REDUND should be the same as CONFIG_ENV_SIZE
 #endif
 
+/* env_get_f() reads the copy at env_ptr as text before relocation */
+#if defined(CONFIG_ENV_BINARY) && \
+	(defined(ENV_IS_EMBEDDED) || defined(CONFIG_NAND_ENV_DST))
+#error CONFIG_ENV_BINARY cannot be used with CONFIG_NAND_ENV_DST or an embedded environment
+#endif
+
 #ifndef CONFIG_ENV_RANGE
 #define CONFIG_ENV_RANGE	CONFIG_ENV_SIZE
 #endif
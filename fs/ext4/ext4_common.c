@@ -1523,43 +1523,230 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
-static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, char *buf,
-		struct ext4_extent_header *ext_block,
-		uint32_t fileblock, int log2_blksz)
+/**
+ * struct ext4_extent_cache - Extent runs of the last file looked up
+ *
+ * @root:	Copy of the inode's block array, which holds the root of the
+ *		extent tree, to tell whether a lookup is for the same file
+ * @runs:	Runs of blocks, in order of logical block
+ * @count:	Number of runs
+ * @size:	Number of runs there is space for
+ * @last:	Run found by the last lookup, where the next one starts
+ * @valid:	true if @runs holds the extents of the file at @root
+ */
+struct ext4_extent_cache {
+	char root[sizeof(((struct ext2_inode *)0)->b)];
+	struct ext4_extent_run *runs;
+	int count;
+	int size;
+	int last;
+	bool valid;
+};
+
+static struct ext4_extent_cache ext4fs_extents;
+
+void ext4fs_extent_cache_invalidate(void)
 {
-	struct ext4_extent_idx *index;
-	unsigned long long block;
-	int blksz = EXT2_BLOCK_SIZE(data);
-	int i;
+	struct ext4_extent_cache *cache = &ext4fs_extents;
 
-	while (1) {
-		index = (struct ext4_extent_idx *)(ext_block + 1);
+	free(cache->runs);
+	memset(cache, '\0', sizeof(*cache));
+}
 
-		if (le16_to_cpu(ext_block->eh_magic) != EXT4_EXT_MAGIC)
-			return NULL;
+/* Add an extent, joining it to the previous run if it follows on */
+static int ext4fs_add_extent_run(struct ext4_extent_cache *cache,
+				 uint32_t block, uint32_t len, uint64_t start)
+{
+	struct ext4_extent_run *run, *runs;
 
-		if (ext_block->eh_depth == 0)
-			return ext_block;
-		i = -1;
-		do {
-			i++;
-			if (i >= le16_to_cpu(ext_block->eh_entries))
-				break;
-		} while (fileblock >= le32_to_cpu(index[i].ei_block));
+	if (cache->count) {
+		run = &cache->runs[cache->count - 1];
+		if (block < run->block + run->len) {
+			printf("extent at block %u overlaps\n", block);
+			return -EINVAL;
+		}
+		if (run->block + run->len == block &&
+		    (start ? run->start && run->start + run->len == start :
+		     !run->start)) {
+			run->len += len;
+			return 0;
+		}
+	}
+	if (cache->count == cache->size) {
+		runs = realloc(cache->runs, (cache->size * 2 + 8) *
+			       sizeof(*runs));
+		if (!runs)
+			return -ENOMEM;
+		cache->runs = runs;
+		cache->size = cache->size * 2 + 8;
+	}
+	run = &cache->runs[cache->count++];
+	run->block = block;
+	run->len = len;
+	run->start = start;
 
-		if (--i < 0)
-			return NULL;
+	return 0;
+}
 
+/*
+ * Add the extents under @eh to the cache, reading each index block once.
+ * The tree is walked in order so the runs come out sorted.
+ */
+static int ext4fs_walk_extents(struct ext4_extent_cache *cache,
+			       struct ext4_extent_header *eh, int depth,
+			       int log2_blksz)
+{
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	struct ext4_extent_idx *index;
+	struct ext4_extent *extent;
+	uint64_t block;
+	uint32_t len;
+	char *buf;
+	int i, ret;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC ||
+	    le16_to_cpu(eh->eh_depth) != depth ||
+	    le16_to_cpu(eh->eh_entries) > le16_to_cpu(eh->eh_max)) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	if (!depth) {
+		extent = (struct ext4_extent *)(eh + 1);
+		for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
+			len = le16_to_cpu(extent[i].ee_len);
+			block = le16_to_cpu(extent[i].ee_start_hi);
+			block = (block << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			/* Uninitialised extents read as zeroes */
+			if (len > EXT4_EXT_INIT_MAX_LEN) {
+				len -= EXT4_EXT_INIT_MAX_LEN;
+				block = 0;
+			}
+			ret = ext4fs_add_extent_run(cache,
+					le32_to_cpu(extent[i].ee_block), len,
+					block);
+			if (ret)
+				return ret;
+		}
+
+		return 0;
+	}
+
+	buf = zalloc(blksz);
+	if (!buf)
+		return -ENOMEM;
+	index = (struct ext4_extent_idx *)(eh + 1);
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
+		if (!ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
+				    buf)) {
+			ret = -EIO;
+			break;
+		}
+		ret = ext4fs_walk_extents(cache,
+					  (struct ext4_extent_header *)buf,
+					  depth - 1, log2_blksz);
+		if (ret)
+			break;
+	}
+	free(buf);
 
-		if (ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
-				   buf))
-			ext_block = (struct ext4_extent_header *)buf;
+	return ret;
+}
+
+/* Make sure the cache holds the extents of @inode */
+static int ext4fs_load_extents(struct ext2_inode *inode, int log2_blksz)
+{
+	struct ext4_extent_cache *cache = &ext4fs_extents;
+	struct ext4_extent_header *eh;
+	int ret;
+
+	if (cache->valid && !memcmp(cache->root, &inode->b, sizeof(inode->b)))
+		return 0;
+
+	cache->valid = false;
+	cache->count = 0;
+	cache->last = 0;
+	eh = (struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+	if (le16_to_cpu(eh->eh_depth) > EXT4_EXT_MAX_DEPTH) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+	ret = ext4fs_walk_extents(cache, eh, le16_to_cpu(eh->eh_depth),
+				  log2_blksz);
+	if (ret)
+		return ret;
+	memcpy(cache->root, &inode->b, sizeof(inode->b));
+	cache->valid = true;
+
+	return 0;
+}
+
+/*
+ * Find @fileblock in a file with extents. Returns the physical block, or 0
+ * for a hole, and the number of blocks from there which follow on in the
+ * same way
+ */
+static long int ext4fs_extent_lookup(struct ext2_inode *inode,
+				     uint32_t fileblock, int log2_blksz,
+				     uint32_t *countp)
+{
+	struct ext4_extent_cache *cache = &ext4fs_extents;
+	struct ext4_extent_run *run;
+	int lo, hi, mid, ret;
+
+	ret = ext4fs_load_extents(inode, log2_blksz);
+	if (ret)
+		return ret;
+
+	/* Files are mostly read in order, so try where the last lookup was */
+	lo = 0;
+	hi = cache->count;
+	if (cache->last < cache->count &&
+	    fileblock >= cache->runs[cache->last].block)
+		lo = cache->last;
+	if (lo + 1 < hi && fileblock < cache->runs[lo + 1].block)
+		hi = lo + 1;
+
+	/* Find the first run starting after @fileblock */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (cache->runs[mid].block <= fileblock)
+			lo = mid + 1;
 		else
-			return NULL;
+			hi = mid;
 	}
+
+	if (lo && fileblock < cache->runs[lo - 1].block +
+			      cache->runs[lo - 1].len) {
+		run = &cache->runs[lo - 1];
+		cache->last = lo - 1;
+		*countp = run->len - (fileblock - run->block);
+
+		return run->start ? run->start + (fileblock - run->block) : 0;
+	}
+
+	/* A hole, up to the next run or the end of the file */
+	*countp = lo < cache->count ? cache->runs[lo].block - fileblock :
+		  UINT_MAX - fileblock;
+
+	return 0;
+}
+
+long int ext4fs_read_block_run(struct ext2_inode *inode, uint32_t fileblock,
+			       uint32_t *countp)
+{
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+			 get_fs()->dev_desc->log2blksz;
+
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_extent_lookup(inode, fileblock, log2_blksz,
+					    countp);
+	*countp = 1;
+
+	return read_allocated_block(inode, fileblock);
 }
 
 static int ext4fs_blockgroup
@@ -1624,53 +1811,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			free(buf);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
+		uint32_t count;
 
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				free(buf);
-				return 0;
-
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				free(buf);
-				return (fileblock - startblock) + start;
-			}
-		}
-
-		free(buf);
-		return 0;
+		return ext4fs_extent_lookup(inode, fileblock, log2_blksz,
+					    &count);
 	}
 
 	/* Direct blocks. */
@@ -2003,6 +2153,7 @@ void ext4fs_close(void)
 	}
 
 	ext4fs_reinit_global();
+	ext4fs_extent_cache_invalidate();
 }
 
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
@@ -2304,6 +2455,9 @@ int ext4fs_open(const char *filename, loff_t *len)
 	if (ext4fs_root == NULL)
 		return -1;
 
+	/* A file may be read several times before ext4fs_close() */
+	if (ext4fs_file)
+		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
 	ext4fs_file = NULL;
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
@@ -2331,6 +2485,8 @@ int ext4fs_mount(unsigned part_length)
 	struct ext2_data *data;
 	int status;
 	struct ext_filesystem *fs = get_fs();
+
+	ext4fs_extent_cache_invalidate();
 	data = zalloc(SUPERBLOCK_SIZE);
 	if (!data)
 		return 0;
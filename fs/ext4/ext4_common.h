@@ -57,6 +57,39 @@ int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
 
+/**
+ * struct ext4_extent_run - Run of file blocks which are contiguous on disk
+ *
+ * @block:	First logical block of the run
+ * @len:	Number of blocks
+ * @start:	First physical block, 0 if the blocks read as zeroes
+ */
+struct ext4_extent_run {
+	uint32_t block;
+	uint32_t len;
+	uint64_t start;
+};
+
+/**
+ * ext4fs_read_block_run() - Find where a run of file blocks is on disk
+ *
+ * For a file with extents, the extent tree is walked once and kept until
+ * another file is looked up or the filesystem is closed, so reading a file
+ * in order reads each index block only once.
+ *
+ * @inode:	Inode of the file
+ * @fileblock:	Logical block to look up
+ * @countp:	Returns the number of blocks from @fileblock which follow on
+ *		contiguously on disk, or are all holes. This is 1 for a file
+ *		without extents.
+ * @return physical block, 0 for a hole, -ve on error
+ */
+long int ext4fs_read_block_run(struct ext2_inode *inode, uint32_t fileblock,
+			       uint32_t *countp);
+
+/* Drop the cached extents, e.g. when the filesystem is closed */
+void ext4fs_extent_cache_invalidate(void);
+
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
 uint16_t ext4fs_checksum_update(unsigned int i);
@@ -45,23 +45,25 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are looked up a run at a time, so with extents a file which is
+ * contiguous on disk is read with a single request.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
-	lbaint_t blockcnt;
+	lbaint_t blockcnt, i;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
 	unsigned int filesize = le32_to_cpu(node->inode.size);
-	lbaint_t previous_block_number = -1;
 	lbaint_t delayed_start = 0;
 	lbaint_t delayed_extent = 0;
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
+	bool delayed = false;
 	short status;
 
 	if (blocksize <= 0)
@@ -73,65 +75,47 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	for (i = lldiv(pos, blocksize); i < blockcnt; ) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
-		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+		uint32_t count;
+		loff_t start, end;
+		int skipfirst;
+		lbaint_t bytes;
+
+		blknr = ext4fs_read_block_run(&node->inode, i, &count);
 		if (blknr < 0)
 			return -1;
+		if (count > blockcnt - i)
+			count = blockcnt - i;
 
-		blknr = blknr << log2_fs_blocksize;
-
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		/* The part of the run which was asked for */
+		start = max_t(loff_t, pos, (loff_t)i * blocksize);
+		end = min_t(loff_t, len + pos, (loff_t)(i + count) * blocksize);
+		skipfirst = start - (loff_t)i * blocksize;
+		bytes = end - start;
 
-		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
-		}
 		if (blknr) {
-			int status;
-
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
+			blknr = blknr << log2_fs_blocksize;
+			if (delayed && !skipfirst && delayed_next == blknr) {
+				delayed_extent += bytes;
+			} else {
+				if (delayed) {	/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
 					if (status == 0)
 						return -1;
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
 				}
-			} else {
-				previous_block_number = blknr;
+				delayed = true;
 				delayed_start = blknr;
-				delayed_extent = blockend;
+				delayed_extent = bytes;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
 			}
+			delayed_next = blknr + (count << log2_fs_blocksize);
 		} else {
-			int n;
-			if (previous_block_number != -1) {
+			if (delayed) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
@@ -139,24 +123,20 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 							delayed_buf);
 				if (status == 0)
 					return -1;
-				previous_block_number = -1;
+				delayed = false;
 			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			if (n > len)
-				n = len;
-			memset(buf, 0, n);
+			memset(buf, 0, bytes);
 		}
-		buf += blocksize - skipfirst;
+		buf += bytes;
+		i += count;
 	}
-	if (previous_block_number != -1) {
+	if (delayed) {
 		/* spill */
 		status = ext4fs_devread(delayed_start,
 					delayed_skipfirst, delayed_extent,
 					delayed_buf);
 		if (status == 0)
 			return -1;
-		previous_block_number = -1;
 	}
 
 	*actread  = len;
@@ -44,6 +44,45 @@ static void downcase(char *str, size_t len)
 static struct blk_desc *cur_dev;
 static disk_partition_t cur_part_info;
 
+/* Number of looked-up paths remembered while the filesystem is mounted */
+#define FAT_DIR_CACHE_SIZE	8
+/* Longest path remembered, including the terminator */
+#define FAT_DIR_CACHE_PATH	64
+
+/**
+ * struct fat_dir_cache - A path which has been looked up
+ *
+ * @path:	Path with no leading or repeated '/', in lower case
+ * @dent:	Directory entry the path resolved to
+ */
+struct fat_dir_cache {
+	char path[FAT_DIR_CACHE_PATH];
+	dir_entry dent;
+};
+
+/*
+ * Each lookup or read starts again from the boot sector, so keep what has
+ * been read from fat_set_blk_dev() until the next one, fat_close() or a
+ * write: the filesystem parameters, a window of the FAT which holds all of
+ * it on most FAT16 volumes, and the paths looked up so far.
+ */
+static struct {
+	bool valid;		/* fsdata is set up for the current device */
+	bool busy;		/* fsdata.fatbuf is in use by a caller */
+	fsdata fsdata;
+	struct fat_dir_cache dirs[FAT_DIR_CACHE_SIZE];
+	int dir_count;
+	int dir_next;		/* Entry to replace once all are in use */
+} fat_mount;
+
+static void fat_mount_invalidate(void)
+{
+	/* A caller still using the FAT window frees it when done */
+	if (fat_mount.valid && !fat_mount.busy)
+		free(fat_mount.fsdata.fatbuf);
+	memset(&fat_mount, '\0', sizeof(fat_mount));
+}
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -67,6 +106,7 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
 
+	fat_mount_invalidate();
 	cur_dev = dev_desc;
 	cur_part_info = *info;
 
@@ -200,12 +240,12 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 
 	/* Read a new block of FAT entries into the cache. */
 	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
+		__u32 getsize = mydata->fatbufblocks;
 		__u8 *bufptr = mydata->fatbuf;
 		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
+		__u32 startblock = bufnum * mydata->fatbufblocks;
 
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+		/* Cap length if fatlength is not a multiple of fatbufblocks */
 		if (startblock + getsize > fatlength)
 			getsize = fatlength - startblock;
 
@@ -245,6 +285,10 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	return ret;
 }
 
+/* Aligned buffer for partial clusters and reads into misaligned buffers */
+__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
 /*
  * Read at most 'size' bytes from the specified cluster into 'buffer'.
  * Return 0 on success, -1 otherwise.
@@ -265,20 +309,25 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		__u8 *tmpbuf = get_contents_vfatname_block;
 
 		printf("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* read through an aligned buffer, as much as it holds at once */
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min_t(unsigned long, size, MAX_CLUSTSIZE) /
+				mydata->sect_size;
+			ret = disk_read(startsect, idx, tmpbuf);
+			if (ret != idx) {
 				debug("Error reading data (got %d)\n", ret);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			memcpy(buffer, tmpbuf, idx);
+			buffer += idx;
+			size -= idx;
 		}
 	} else {
 		idx = size / mydata->sect_size;
@@ -307,21 +356,41 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Count the clusters from 'clust' onwards which follow each other on the
+ * disk, up to 'max'. The cluster after the run is returned in *nextp, which
+ * fails CHECK_CLUST() at the end of the chain.
+ */
+static __u32 get_cluster_run(fsdata *mydata, __u32 clust, __u32 max,
+			     __u32 *nextp)
+{
+	__u32 count = 1;
+	__u32 next;
+
+	while (1) {
+		next = get_fatent(mydata, clust);
+		if (count == max || next != clust + 1)
+			break;
+		clust = next;
+		count++;
+	}
+	*nextp = next;
+
+	return count;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
  * Update the number of bytes read in *gotsize or return -1 on fatal errors.
  */
-__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
-	__aligned(ARCH_DMA_MINALIGN);
-
 static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 			__u8 *buffer, loff_t maxsize, loff_t *gotsize)
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	__u32 newclust, count;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -337,24 +406,21 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
+	/* go to cluster at pos, a run at a time; pos < filesize < 4GB */
+	while (pos >= bytesperclust) {
+		count = get_cluster_run(mydata, curclust,
+					(__u32)pos / bytesperclust, &newclust);
+		actsize = (loff_t)count * bytesperclust;
+		filesize -= actsize;
+		pos -= actsize;
+		curclust = newclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			debug("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize += bytesperclust;
 	}
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
 	/* align to beginning of next cluster if any */
 	if (pos) {
 		actsize = min(filesize, (loff_t)bytesperclust);
@@ -379,50 +445,29 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+	/* read each run of consecutive clusters with a single request */
+	while (1) {
+		count = get_cluster_run(mydata, curclust,
+					((__u32)filesize - 1) / bytesperclust + 1,
+					&newclust);
+		actsize = min(filesize, (loff_t)count * bytesperclust);
+		if (get_cluster(mydata, curclust, buffer, actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
 		filesize -= actsize;
+		if (!filesize)
+			return 0;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
+		curclust = newclust;
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			printf("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
 }
 
 /*
@@ -551,7 +596,7 @@ exit:
 	return ret;
 }
 
-static int get_fs_info(fsdata *mydata)
+static int read_fs_info(fsdata *mydata)
 {
 	boot_sector bs;
 	volume_info volinfo;
@@ -597,9 +642,20 @@ static int get_fs_info(fsdata *mydata)
 			sect_to_clust(mydata, mydata->rootdir_sect);
 	}
 
+	/* Keep as much of the FAT as allowed, in whole FATBUFBLOCKS */
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
+	mydata->fatbufblocks = min_t(__u32,
+				     CONFIG_FS_FAT_CACHE_SIZE / mydata->sect_size,
+				     roundup(mydata->fatlength, FATBUFBLOCKS));
+	mydata->fatbufblocks = max_t(__u32,
+				     rounddown(mydata->fatbufblocks, FATBUFBLOCKS),
+				     FATBUFBLOCKS);
 	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+	if (mydata->fatbuf == NULL && mydata->fatbufblocks > FATBUFBLOCKS) {
+		mydata->fatbufblocks = FATBUFBLOCKS;
+		mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+	}
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
 		return -1;
@@ -621,6 +677,50 @@ static int get_fs_info(fsdata *mydata)
 	return 0;
 }
 
+/*
+ * Set up 'mydata' for the mounted filesystem, reading the boot sector only
+ * the first time. The FAT window is shared between calls; if it is already
+ * in use, e.g. by an open directory, a small one is allocated instead.
+ * Release it with put_fs_info().
+ */
+static int get_fs_info(fsdata *mydata)
+{
+	int ret;
+
+	if (!fat_mount.valid) {
+		ret = read_fs_info(&fat_mount.fsdata);
+		if (ret)
+			return ret;
+		fat_mount.valid = true;
+	}
+
+	*mydata = fat_mount.fsdata;
+	if (fat_mount.busy) {
+		mydata->fatbufnum = -1;
+		mydata->fatbufblocks = FATBUFBLOCKS;
+		mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
+		if (mydata->fatbuf == NULL) {
+			debug("Error: allocating memory\n");
+			return -1;
+		}
+	} else {
+		fat_mount.busy = true;
+	}
+
+	return 0;
+}
+
+static void put_fs_info(fsdata *mydata)
+{
+	if (fat_mount.busy && mydata->fatbuf == fat_mount.fsdata.fatbuf) {
+		/* Remember which part of the FAT is in the window */
+		fat_mount.fsdata.fatbufnum = mydata->fatbufnum;
+		fat_mount.busy = false;
+	} else {
+		free(mydata->fatbuf);
+	}
+}
+
 
 /*
  * Directory iterator, to simplify filesystem traversal
@@ -899,22 +999,80 @@ static int fat_itr_isdir(fat_itr *itr)
 #define TYPE_DIR  0x2
 #define TYPE_ANY  (TYPE_FILE | TYPE_DIR)
 
-/**
- * fat_itr_resolve() - traverse directory structure to resolve the
- * requested path.
- *
- * Traverse directory structure to the requested path.  If the specified
- * path is to a directory, this will descend into the directory and
- * leave it iterator at the start of the directory.  If the path is to a
- * file, it will leave the iterator in the parent directory with current
- * cursor at file's entry in the directory.
- *
- * @itr: iterator initialized to root
- * @path: the requested path
- * @type: bitmask of allowable file types
- * @return 0 on success or -errno
+/*
+ * Make the cache key for 'path' in 'key': the path without leading or
+ * repeated separators, in lower case, since names are matched ignoring
+ * case. A trailing separator is kept, as it stops the path naming a file.
+ * Returns the length of the key or -1 if it is too long to cache.
  */
-static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
+static int fat_dir_cache_key(const char *path, char *key)
+{
+	int len = 0;
+
+	while (ISDIRDELIM(*path))
+		path++;
+	while (*path) {
+		if (len == FAT_DIR_CACHE_PATH - 1)
+			return -1;
+		if (ISDIRDELIM(*path)) {
+			key[len++] = '/';
+			while (ISDIRDELIM(*path))
+				path++;
+		} else {
+			key[len++] = tolower(*path++);
+		}
+	}
+	key[len] = '\0';
+
+	return len;
+}
+
+/*
+ * Find the longest path in the cache which is 'key' or a leading part of it,
+ * setting *lenp to its length
+ */
+static struct fat_dir_cache *fat_dir_cache_find(const char *key, int *lenp)
+{
+	struct fat_dir_cache *ent, *found = NULL;
+	int i, len;
+
+	*lenp = 0;
+	for (i = 0; i < fat_mount.dir_count; i++) {
+		ent = &fat_mount.dirs[i];
+		len = strlen(ent->path);
+		if (len > *lenp && !strncmp(ent->path, key, len) &&
+		    (!key[len] || key[len] == '/')) {
+			found = ent;
+			*lenp = len;
+		}
+	}
+
+	return found;
+}
+
+/* Remember that the first 'len' characters of 'key' name 'dent' */
+static void fat_dir_cache_add(const char *key, int len, dir_entry *dent)
+{
+	struct fat_dir_cache *ent;
+
+	if (fat_mount.dir_count < FAT_DIR_CACHE_SIZE) {
+		ent = &fat_mount.dirs[fat_mount.dir_count++];
+	} else {
+		ent = &fat_mount.dirs[fat_mount.dir_next];
+		fat_mount.dir_next = (fat_mount.dir_next + 1) %
+				     FAT_DIR_CACHE_SIZE;
+	}
+	memcpy(ent->path, key, len);
+	ent->path[len] = '\0';
+	ent->dent = *dent;
+}
+
+/*
+ * Walk 'path' from the directory at 'itr'. If 'key' is not NULL, 'path' is
+ * part of it and each entry found on the way is added to the cache.
+ */
+static int fat_itr_resolve_path(fat_itr *itr, const char *path,
+				unsigned type, const char *key)
 {
 	const char *next;
 
@@ -948,10 +1106,13 @@ static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 		if (!match)
 			continue;
 
+		if (key)
+			fat_dir_cache_add(key, next - key, itr->dent);
+
 		if (fat_itr_isdir(itr)) {
 			/* recurse into directory: */
 			fat_itr_child(itr, itr);
-			return fat_itr_resolve(itr, next, type);
+			return fat_itr_resolve_path(itr, next, type, key);
 		} else if (next[0]) {
 			/*
 			 * If next is not empty then we have a case
@@ -969,6 +1130,60 @@ static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 	return -ENOENT;
 }
 
+/**
+ * fat_itr_resolve() - traverse directory structure to resolve the
+ * requested path.
+ *
+ * Traverse directory structure to the requested path.  If the specified
+ * path is to a directory, this will descend into the directory and
+ * leave it iterator at the start of the directory.  If the path is to a
+ * file, it will leave the iterator in the parent directory with current
+ * cursor at file's entry in the directory.
+ *
+ * Paths looked up since the filesystem was mounted are cached, so the walk
+ * starts from the deepest directory already known. When the whole path is
+ * cached, the cursor is at a copy of the entry rather than in its directory.
+ *
+ * @itr: iterator initialized to root
+ * @path: the requested path
+ * @type: bitmask of allowable file types
+ * @return 0 on success or -errno
+ */
+static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
+{
+	char key[FAT_DIR_CACHE_PATH];
+	struct fat_dir_cache *ent;
+	int keylen, len;
+
+	keylen = fat_dir_cache_key(path, key);
+	if (keylen < 0)
+		return fat_itr_resolve_path(itr, path, type, NULL);
+
+	ent = fat_dir_cache_find(key, &len);
+	if (!ent)
+		return fat_itr_resolve_path(itr, key, type, key);
+
+	/* carry on as if the cached entry had just been found: */
+	memcpy(itr->block, &ent->dent, sizeof(dir_entry));
+	itr->dent = (dir_entry *)itr->block;
+	itr->remaining = 0;
+	itr->last_cluster = 1;
+	get_name(itr->dent, itr->s_name);
+	itr->name = itr->s_name;
+
+	if (fat_itr_isdir(itr)) {
+		fat_itr_child(itr, itr);
+		return fat_itr_resolve_path(itr, key + len, type, key);
+	} else if (len != keylen) {
+		debug("bad trailing path: %s\n", key + len);
+		return -ENOENT;
+	} else if (!(type & TYPE_FILE)) {
+		return -ENOTDIR;
+	}
+
+	return 0;
+}
+
 int file_fat_detectfs(void)
 {
 	boot_sector bs;
@@ -1045,7 +1260,7 @@ int fat_exists(const char *filename)
 		goto out;
 
 	ret = fat_itr_resolve(itr, filename, TYPE_ANY);
-	free(fsdata.fatbuf);
+	put_fs_info(&fsdata);
 out:
 	free(itr);
 	return ret == 0;
@@ -1070,7 +1285,7 @@ int fat_size(const char *filename, loff_t *size)
 		 * Directories don't have size, but fs_size() is not
 		 * expected to fail if passed a directory path:
 		 */
-		free(fsdata.fatbuf);
+		put_fs_info(&fsdata);
 		fat_itr_root(itr, &fsdata);
 		if (!fat_itr_resolve(itr, filename, TYPE_DIR)) {
 			*size = 0;
@@ -1081,7 +1296,7 @@ int fat_size(const char *filename, loff_t *size)
 
 	*size = FAT2CPU32(itr->dent->size);
 out_free_both:
-	free(fsdata.fatbuf);
+	put_fs_info(&fsdata);
 out_free_itr:
 	free(itr);
 	return ret;
@@ -1109,7 +1324,7 @@ int file_fat_read_at(const char *filename, loff_t pos, void *buffer,
 	ret = get_contents(&fsdata, itr->dent, pos, buffer, maxsize, actread);
 
 out_free_both:
-	free(fsdata.fatbuf);
+	put_fs_info(&fsdata);
 out_free_itr:
 	free(itr);
 	return ret;
@@ -1166,7 +1381,7 @@ int fat_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	return 0;
 
 fail_free_both:
-	free(dir->fsdata.fatbuf);
+	put_fs_info(&dir->fsdata);
 fail_free_dir:
 	free(dir);
 	return ret;
@@ -1198,10 +1413,11 @@ int fat_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp)
 void fat_closedir(struct fs_dir_stream *dirs)
 {
 	fat_dir *dir = (fat_dir *)dirs;
-	free(dir->fsdata.fatbuf);
+	put_fs_info(&dir->fsdata);
 	free(dir);
 }
 
 void fat_close(void)
 {
+	fat_mount_invalidate();
 }
@@ -106,10 +106,10 @@ static __u8 num_of_fats;
  */
 static int flush_dirty_fat_buffer(fsdata *mydata)
 {
-	int getsize = FATBUFBLOCKS;
+	int getsize = mydata->fatbufblocks;
 	__u32 fatlength = mydata->fatlength;
 	__u8 *bufptr = mydata->fatbuf;
-	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
+	__u32 startblock = mydata->fatbufnum * mydata->fatbufblocks;
 
 	debug("debug: evicting %d, dirty: %d\n", mydata->fatbufnum,
 	      (int)mydata->fat_dirty);
@@ -117,7 +117,7 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 	if ((!mydata->fat_dirty) || (mydata->fatbufnum == -1))
 		return 0;
 
-	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	/* Cap length if fatlength is not a multiple of fatbufblocks */
 	if (startblock + getsize > fatlength)
 		getsize = fatlength - startblock;
 
@@ -388,12 +388,12 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 
 	/* Read a new block of FAT entries into the cache. */
 	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFBLOCKS;
+		int getsize = mydata->fatbufblocks;
 		__u8 *bufptr = mydata->fatbuf;
 		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
+		__u32 startblock = bufnum * mydata->fatbufblocks;
 
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+		/* Cap length if fatlength is not a multiple of fatbufblocks */
 		if (startblock + getsize > fatlength)
 			getsize = fatlength - startblock;
 
@@ -957,6 +957,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 	}
 
 	mydata->fatbufnum = -1;
+	mydata->fatbufblocks = FATBUFBLOCKS;
 	mydata->fat_dirty = 0;
 	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
 	if (mydata->fatbuf == NULL) {
@@ -1072,6 +1073,8 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 
 exit:
 	free(mydata->fatbuf);
+	/* Anything read before the write may now be out of date */
+	fat_mount_invalidate();
 	return ret;
 }
 
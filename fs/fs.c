@@ -336,7 +336,7 @@ int fs_get_fstype(const char **fstype_name)
 	return 0;
 }
 
-static void fs_close(void)
+void fs_close(void)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 
@@ -392,8 +392,8 @@ int fs_size(const char *filename, loff_t *size)
 	return ret;
 }
 
-int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
-	    loff_t *actread)
+int fs_read_keep(const char *filename, ulong addr, loff_t offset, loff_t len,
+		 loff_t *actread)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 	void *buf;
@@ -410,6 +410,16 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	/* If we requested a specific number of bytes, check we got it */
 	if (ret == 0 && len && *actread != len)
 		printf("** %s shorter than offset + len **\n", filename);
+
+	return ret;
+}
+
+int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
+	    loff_t *actread)
+{
+	int ret;
+
+	ret = fs_read_keep(filename, addr, offset, len, actread);
 	fs_close();
 
 	return ret;
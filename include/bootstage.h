@@ -205,6 +205,13 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_SPL,
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_ANDROID_LOAD,
+	BOOTSTAGE_ID_ACCUM_RKIMG_LOAD,
+	BOOTSTAGE_ID_ACCUM_SERIAL_TX,
+	BOOTSTAGE_ID_ACCUM_SPL_LOAD,
+	BOOTSTAGE_ID_ACCUM_SPL_FIT_READ,
+	BOOTSTAGE_ID_ACCUM_SPL_FIT_HASH,
+	BOOTSTAGE_ID_RELOCATE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -21,6 +21,9 @@ int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
 
+/* Forget the scripts kept parsed, e.g. to time parsing them */
+void hush_script_cache_flush(void);
+
 #if defined(CONFIG_HUSH_INIT_VAR)
 extern int hush_init_var (void);
 #endif
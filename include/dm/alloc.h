@@ -0,0 +1,119 @@
+/*
+ * Size-class allocator for driver model data
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_ALLOC_H
+#define _DM_ALLOC_H
+
+#include <malloc.h>
+
+/*
+ * Objects of up to DM_ALLOC_MAX bytes are rounded up to a power of two and
+ * carved out of DM_ALLOC_PAGE_SIZE pages, one size class per page.
+ */
+#define DM_ALLOC_MIN		16
+#define DM_ALLOC_CLASSES	6
+#define DM_ALLOC_MAX		(DM_ALLOC_MIN << (DM_ALLOC_CLASSES - 1))
+#define DM_ALLOC_PAGE_SIZE	4096
+
+/**
+ * struct dm_alloc_stats - Allocation counters
+ *
+ * All counters are cumulative except @heap and @live.
+ *
+ * @allocs:	Objects handed out from pages, per size class
+ * @frees:	Objects given back to pages, per size class
+ * @live:	Objects currently allocated from pages, per size class
+ * @reused:	Allocations served from a free list
+ * @pages:	Pages allocated
+ * @pages_freed: Pages given back to malloc() once empty
+ * @large:	Allocations passed through to calloc()
+ * @large_freed: Frees passed through to free()
+ * @mallocs:	Calls to malloc(), i.e. @pages plus @large
+ * @requested:	Bytes asked for in allocations served from pages
+ * @slot_bytes:	Bytes of the slots used for them
+ * @heap:	Bytes of malloc() heap currently held, including the
+ *		chunk overhead
+ * @heap_peak:	Highest value of @heap
+ */
+struct dm_alloc_stats {
+	ulong allocs[DM_ALLOC_CLASSES];
+	ulong frees[DM_ALLOC_CLASSES];
+	ulong live[DM_ALLOC_CLASSES];
+	ulong reused;
+	ulong pages;
+	ulong pages_freed;
+	ulong large;
+	ulong large_freed;
+	ulong mallocs;
+	ulong requested;
+	ulong slot_bytes;
+	ulong heap;
+	ulong heap_peak;
+};
+
+#if CONFIG_IS_ENABLED(DM_ALLOC)
+/**
+ * dm_calloc() - Allocate zeroed memory for driver model data
+ *
+ * Before relocation, or for sizes above DM_ALLOC_MAX, this is the same as
+ * calloc(1, size).
+ *
+ * @size:	Number of bytes to allocate
+ * @return pointer to the memory, or NULL if out of memory
+ */
+void *dm_calloc(size_t size);
+
+/**
+ * dm_free() - Free memory allocated by dm_calloc()
+ *
+ * @ptr:	Pointer to free, may be NULL
+ */
+void dm_free(void *ptr);
+
+/**
+ * dm_alloc_get_stats() - Get the allocation counters
+ *
+ * @stats:	Returns the counters
+ */
+void dm_alloc_get_stats(struct dm_alloc_stats *stats);
+
+/**
+ * dm_alloc_clear_stats() - Clear the cumulative counters
+ *
+ * The peak heap use restarts from the current heap use.
+ */
+void dm_alloc_clear_stats(void);
+
+/**
+ * dm_alloc_set_enabled() - Turn the size classes on or off
+ *
+ * While off, every allocation is passed through to calloc() but still
+ * counted, so that the two can be compared. Objects already allocated from
+ * pages are freed correctly either way.
+ *
+ * @enable:	true to use the size classes (the default)
+ */
+void dm_alloc_set_enabled(bool enable);
+
+/* Dump out the counters and the fragmentation of each size class */
+void dm_dump_alloc(void);
+#else
+static inline void *dm_calloc(size_t size)
+{
+	return calloc(1, size);
+}
+
+static inline void dm_free(void *ptr)
+{
+	free(ptr);
+}
+
+static inline void dm_dump_alloc(void)
+{
+}
+#endif
+
+#endif
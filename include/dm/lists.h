@@ -13,6 +13,8 @@
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 
+struct udevice_id;
+
 /**
  * lists_driver_lookup_name() - Return u_boot_driver corresponding to name
  *
@@ -45,6 +47,21 @@ struct uclass_driver *lists_uclass_lookup(enum uclass_id id);
  */
 int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * After relocation this uses a hash index of all the drivers' compatible
+ * strings, built on first use. Before that, or if the index cannot be
+ * allocated, the drivers are searched in turn. Either way the first driver
+ * in the linker list with a matching string is returned.
+ *
+ * @compat:	Compatible string to look up
+ * @of_idp:	Returns the matching entry in the driver's of_match table
+ * @return pointer to driver, or NULL if not found
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **of_idp);
+
 /**
  * lists_bind_fdt() - bind a device tree node
  *
@@ -370,6 +370,18 @@ int of_parse_phandle_with_args(const struct device_node *np,
 int of_count_phandle_with_args(const struct device_node *np,
 			       const char *list_name, const char *cells_name);
 
+/**
+ * of_phandle_scan() - Build the table used to look up nodes by phandle
+ *
+ * Until this is called, or after it is called for another tree,
+ * of_find_node_by_phandle() walks all the nodes.
+ *
+ * @root:	Root node of the tree, which must be gd->of_root for the
+ *		table to be used
+ * @return 0 if OK, -ENOMEM if not enough memory
+ */
+int of_phandle_scan(struct device_node *root);
+
 /**
  * of_alias_scan() - Scan all properties of the 'aliases' node
  *
@@ -0,0 +1,135 @@
+/*
+ * Probe tracing and deferral for driver model
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _DM_PROBE_H
+#define _DM_PROBE_H
+
+#include <dm/uclass-id.h>
+
+struct udevice;
+
+#define DM_PROBE_NAME_LEN	32
+
+/**
+ * struct dm_probe_record - Record of one probe
+ *
+ * @name:	Device name, or a device count for a deferred uclass
+ * @uclass:	Uclass name
+ * @caller:	Record of the probe which needed this one, -1 if none
+ * @depth:	Number of probes this one is nested in
+ * @deferred:	true if this records a uclass which was not probed
+ * @ret:	Result of the probe
+ * @start:	Time the probe started in microseconds
+ * @time:	Time taken in microseconds, including nested probes
+ */
+struct dm_probe_record {
+	char name[DM_PROBE_NAME_LEN];
+	const char *uclass;
+	int caller;
+	int depth;
+	bool deferred;
+	int ret;
+	ulong start;
+	ulong time;
+};
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TRACE)
+/**
+ * dm_probe_trace_start() - Record that a device is starting to probe
+ *
+ * Any device probed before the matching dm_probe_trace_end() is recorded as
+ * a dependency of this one.
+ *
+ * @dev:	Device being probed
+ * @return trace record to pass to dm_probe_trace_end(), or -1 if none
+ */
+int dm_probe_trace_start(struct udevice *dev);
+
+/**
+ * dm_probe_trace_end() - Record that a device has finished probing
+ *
+ * @trace:	Value returned by dm_probe_trace_start()
+ * @ret:	Result of the probe
+ */
+void dm_probe_trace_end(int trace, int ret);
+
+/**
+ * dm_probe_trace_defer() - Record that probing a uclass was deferred
+ *
+ * @id:		Uclass whose devices were not probed
+ * @count:	Number of devices left unprobed
+ */
+void dm_probe_trace_defer(enum uclass_id id, int count);
+
+/* Forget all records, e.g. before tracing a command */
+void dm_probe_trace_clear(void);
+
+/**
+ * dm_probe_trace_get() - Get the probe records
+ *
+ * @countp:	Returns the number of records
+ * @return the records, in the order the probes started
+ */
+const struct dm_probe_record *dm_probe_trace_get(int *countp);
+
+/* Dump out each probe with its time, nested under what needed it */
+void dm_dump_probe_trace(void);
+#else
+static inline int dm_probe_trace_start(struct udevice *dev)
+{
+	return -1;
+}
+
+static inline void dm_probe_trace_end(int trace, int ret)
+{
+}
+
+static inline void dm_probe_trace_defer(enum uclass_id id, int count)
+{
+}
+
+static inline void dm_probe_trace_clear(void)
+{
+}
+
+static inline void dm_dump_probe_trace(void)
+{
+}
+#endif
+
+#if CONFIG_IS_ENABLED(DM_PROBE_LAZY)
+/**
+ * dm_probe_needed() - Check whether a uclass must be probed during init
+ *
+ * Uclasses listed in CONFIG_DM_PROBE_BOOT_UCLASSES, or marked with
+ * dm_probe_set_needed(), are needed by the boot flow. Devices in other
+ * uclasses are only probed on first use. Before relocation every uclass is
+ * needed.
+ *
+ * @id:		Uclass to check
+ * @return true if its devices should be probed now
+ */
+bool dm_probe_needed(enum uclass_id id);
+
+/**
+ * dm_probe_set_needed() - Mark a uclass as needed by the boot flow or not
+ *
+ * @id:		Uclass to mark
+ * @needed:	true if uclass_probe_all() should probe its devices
+ */
+void dm_probe_set_needed(enum uclass_id id, bool needed);
+#else
+static inline bool dm_probe_needed(enum uclass_id id)
+{
+	return true;
+}
+
+static inline void dm_probe_set_needed(enum uclass_id id, bool needed)
+{
+}
+#endif
+
+#endif
@@ -333,6 +333,20 @@ int uclass_first_device_check(enum uclass_id id, struct udevice **devp);
  */
 int uclass_next_device_check(struct udevice **devp);
 
+/**
+ * uclass_probe_all() - Probe all the devices in a uclass
+ *
+ * This is for init code which wants every device of a uclass ready. With
+ * CONFIG_DM_PROBE_LAZY, nothing is probed unless the uclass is needed by
+ * the boot flow (see dm_probe_needed()). The devices are then probed on
+ * first use instead.
+ *
+ * @id: Uclass ID to probe
+ * @return 0 if OK, or the first error from a device which failed to probe.
+ * Devices after a failed one are still probed.
+ */
+int uclass_probe_all(enum uclass_id id);
+
 /**
  * uclass_resolve_seq() - Resolve a device's sequence number
  *
@@ -25,8 +25,9 @@
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
+/* FAT sectors read at a time, a multiple of 3 so FAT12 entries never split */
 #define FATBUFBLOCKS	6
-#define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
+#define FATBUFSIZE	(mydata->sect_size * mydata->fatbufblocks)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
@@ -173,6 +174,7 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	__u32	fatbufblocks;	/* Size of fatbuf in sectors */
 	int	rootdir_size;	/* Size of root dir for non-FAT32 */
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 } fsdata;
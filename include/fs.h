@@ -84,6 +84,22 @@ int fs_size(const char *filename, loff_t *size);
 int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	    loff_t *actread);
 
+/*
+ * fs_read_keep - Read file from the partition previously set by
+ * fs_set_blk_dev(), leaving the filesystem set up
+ *
+ * This is the same as fs_read() but does not close the filesystem, so that
+ * more of the file can be read without calling fs_set_blk_dev() again.
+ * Call fs_close() once done.
+ */
+int fs_read_keep(const char *filename, ulong addr, loff_t offset, loff_t len,
+		 loff_t *actread);
+
+/*
+ * fs_close - Close the filesystem set by fs_set_blk_dev()
+ */
+void fs_close(void);
+
 /*
  * fs_write - Write file to the partition previously set by fs_set_blk_dev()
  * Note that not all filesystem types support offset!=0.
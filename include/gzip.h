@@ -0,0 +1,95 @@
+/*
+ * Streaming gzip decompression
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __GZIP_H
+#define __GZIP_H
+
+#include <blk.h>
+
+/**
+ * struct gunzip_src - Source of compressed data for gunzip_stream()
+ *
+ * @read:	Read up to @size bytes at @offset into @buf. This may read
+ *		fewer bytes than requested but must make progress unless
+ *		@offset is at the end of the input. Returns the number of
+ *		bytes read, or -ve on error
+ * @close:	Release the source once gunzip_stream() is done with it, or
+ *		NULL if there is nothing to do
+ * @size:	Size of the input in bytes
+ * @blk:	Block device and first block, for gunzip_src_blk()
+ * @fs:		Interface, device/partition and filename, for gunzip_src_fs()
+ * @priv:	Private data for other sources
+ */
+struct gunzip_src {
+	long (*read)(struct gunzip_src *src, u64 offset, void *buf,
+		     ulong size);
+	void (*close)(struct gunzip_src *src);
+	u64 size;
+	union {
+		struct {
+			struct blk_desc *desc;
+			lbaint_t start;
+		} blk;
+		struct {
+			const char *ifname;
+			const char *dev_part;
+			const char *filename;
+			bool open;
+		} fs;
+		void *priv;
+	};
+};
+
+/**
+ * gunzip_src_blk() - Set up a source reading from a block device
+ *
+ * @src:	Source to set up
+ * @desc:	Block device
+ * @start:	First block of the compressed data
+ * @size:	Size of the compressed data in bytes. This may be larger than
+ *		the data, e.g. the size of the partition holding it, since
+ *		reading stops at the end of the gzip stream.
+ */
+void gunzip_src_blk(struct gunzip_src *src, struct blk_desc *desc,
+		    lbaint_t start, u64 size);
+
+/**
+ * gunzip_src_fs() - Set up a source reading from a file
+ *
+ * The strings are not copied, so must remain valid while the source is used.
+ * The filesystem is set up on the first read and kept open until
+ * gunzip_stream() is done, rather than being set up for each chunk.
+ *
+ * @src:	Source to set up
+ * @ifname:	Interface name, e.g. "mmc"
+ * @dev_part:	Device and partition, e.g. "0:1"
+ * @filename:	Path of the file
+ * @return 0 if OK, -ENODEV if the filesystem cannot be found, -ENOENT if the
+ *	file does not exist
+ */
+int gunzip_src_fs(struct gunzip_src *src, const char *ifname,
+		  const char *dev_part, const char *filename);
+
+/**
+ * gunzip_stream() - Decompress a gzip image while reading it
+ *
+ * The input is read CONFIG_GZIP_STREAM_CHUNK bytes at a time, so only two
+ * chunks need to be in memory at once rather than the whole image. The
+ * CRC32 and length in the gzip trailer are checked as the data is
+ * decompressed. With SMP_JOB enabled, each chunk is decompressed on another
+ * CPU while the next one is read.
+ *
+ * @src:	Source of the compressed data
+ * @dst:	Output buffer
+ * @dstlen:	Size of the output buffer in bytes
+ * @lenp:	Returns the number of bytes written to @dst
+ * @return 0 if OK, -ENOMEM if out of memory, -EIO on a read error, -ENOSPC
+ *	if @dst is too small, -EINVAL if the data is corrupt or truncated
+ */
+int gunzip_stream(struct gunzip_src *src, void *dst, ulong dstlen,
+		  ulong *lenp);
+
+#endif /* __GZIP_H */
@@ -694,6 +694,17 @@ int boot_relocate_fdt(struct lmb *lmb, char **of_flat_tree, ulong *of_size);
 
 int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 		  ulong *initrd_start, ulong *initrd_end);
+
+/**
+ * boot_ramdisk_placed() - Note a ramdisk already loaded to its final address
+ *
+ * boot_ramdisk_high() then boots this ramdisk in place rather than copying it
+ * below initrd_high, as long as it already lies below that.
+ *
+ * @rd_data:	Address of the ramdisk
+ * @rd_len:	Size of the ramdisk in bytes
+ */
+void boot_ramdisk_placed(ulong rd_data, ulong rd_len);
 int boot_get_cmdline(struct lmb *lmb, ulong *cmd_start, ulong *cmd_end);
 #ifdef CONFIG_SYS_BOOT_GET_KBD
 int boot_get_kbd(struct lmb *lmb, bd_t **kbd);
@@ -1275,6 +1286,11 @@ void android_print_contents(const struct andr_img_hdr *hdr);
  * image or if the image size needed to be read from disk is bigger than the
  * the passed |max_size| a negative number is returned.
  *
+ * The header is read to |load_address| but the kernel is read straight to its
+ * load address and the ramdisk to ramdisk_addr_r, where free, so that bootm
+ * need not copy them. Parts are otherwise read to their offset from the
+ * header, as in a contiguous image.
+ *
  * @dev_desc:		The device where to read the image from
  * @part_info:		The partition in |dev_desc| where to read the image from
  * @load_address:	The address where the image will be loaded
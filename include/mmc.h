@@ -61,8 +61,11 @@
 #define MMC_MODE_HS200		(1 << 6)
 #define MMC_MODE_HS400		(1 << 7)
 #define MMC_MODE_HS400ES	(1 << 8)
+/* Host does not send CMD12 by itself, so transfers may start with CMD23 */
+#define MMC_MODE_CMD23		(1 << 9)
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23	0x00000002	/* SET_BLOCK_COUNT is supported */
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -172,6 +175,8 @@
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_FLUSH_CACHE		32	/* W */
+#define EXT_CSD_CACHE_CTRL		33	/* R/W/E_P */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -197,6 +202,7 @@
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE_SUPPORT     231     /* RO */
+#define EXT_CSD_CACHE_SIZE		249	/* RO, 4 bytes */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -562,6 +568,8 @@ struct mmc {
 	u8 part_attr;
 	u8 wr_rel_set;
 	u8 part_config;
+	u8 part_num;		/* hardware partition selected on the card */
+	uint blocklen;		/* block length set by CMD16, 0 if unknown */
 	uint read_bl_len;
 	uint write_bl_len;
 	uint erase_grp_size;	/* in 512-byte sectors */
@@ -581,6 +589,14 @@ struct mmc {
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+	uint cache_size;	/* volatile cache size in KiB, 0 if none */
+	struct mmc_write_cache *wcache;	/* state during a write session */
+#endif
+#if CONFIG_IS_ENABLED(MMC_CMD_STATS)
+#define MMC_CMD_COUNT	64
+	ulong cmd_count[MMC_CMD_COUNT];	/* number of each command sent */
+#endif
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct udevice *dev;	/* Device for this MMC controller */
 #endif
@@ -713,6 +729,55 @@ int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
 int mmc_set_bkops_enable(struct mmc *mmc);
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_WRITE_CACHE)
+/**
+ * mmc_write_cache_begin() - Start a write session, e.g. for fastboot
+ *
+ * Until mmc_write_cache_end() is called, eMMC cards have their volatile cache
+ * turned on when first written, and small contiguous writes to any card are
+ * gathered into larger transfers. Reads, erases and partition switches see
+ * the gathered data, since it is written out before them.
+ */
+void mmc_write_cache_begin(void);
+
+/**
+ * mmc_write_cache_flush() - Write out the data of a write session so far
+ *
+ * This writes out any gathered data and flushes the cache of each card
+ * written during the session, which stays open. Commands which write, e.g.
+ * fastboot flash, call this before replying so that an error reaches the
+ * host.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int mmc_write_cache_flush(void);
+
+/**
+ * mmc_write_cache_end() - End a write session
+ *
+ * This writes out any gathered data, flushes and turns off the cache of each
+ * card written during the session, and shows how many transfers were saved.
+ * It must be called before a reset or before booting an OS.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int mmc_write_cache_end(void);
+#else
+static inline void mmc_write_cache_begin(void)
+{
+}
+
+static inline int mmc_write_cache_flush(void)
+{
+	return 0;
+}
+
+static inline int mmc_write_cache_end(void)
+{
+	return 0;
+}
+#endif
+
 /**
  * Start device initialization and return immediately; it does not block on
  * polling OCR (operation condition register) status.  Then you should call
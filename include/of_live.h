@@ -21,4 +21,17 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_unflatten() - build a live tree without scanning it
+ *
+ * This is of_live_build() without the alias and phandle scans, which are
+ * only wanted for the control tree. The tree is in a single allocation, so
+ * can be freed by passing the root node to free().
+ *
+ * @fdt_blob: Input tree to convert
+ * @rootp: Returns live tree that was created
+ * @return 0 if OK, -ve on error
+ */
+int of_live_unflatten(const void *fdt_blob, struct device_node **rootp);
+
 #endif
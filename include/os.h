@@ -310,4 +310,36 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * os_thread_create() - Start a host thread
+ *
+ * The thread shares U-Boot's memory, so must only run code which is safe
+ * to call from several threads at once.
+ *
+ * @func:	Function to run in the thread
+ * @arg:	Argument to pass to @func
+ * @threadp:	Returns a handle for os_thread_join()
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_create(void (*func)(void *arg), void *arg, void **threadp);
+
+/**
+ * os_thread_join() - Wait for a host thread to finish and free it
+ *
+ * @thread:	Handle from os_thread_create()
+ */
+void os_thread_join(void *thread);
+
+/**
+ * os_thread_wait() - Sleep until os_thread_wake() is called
+ *
+ * @usec:	Maximum time to sleep in microseconds
+ */
+void os_thread_wait(unsigned long usec);
+
+/**
+ * os_thread_wake() - Wake up all threads sleeping in os_thread_wait()
+ */
+void os_thread_wake(void);
+
 #endif
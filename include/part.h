@@ -109,6 +109,32 @@ void part_print(struct blk_desc *dev_desc);
 void part_init(struct blk_desc *dev_desc);
 void dev_print(struct blk_desc *dev_desc);
 
+/**
+ * part_cache_invalidate() - Forget the partition table of a block device
+ *
+ * This must be called after writing a new partition table, so that the next
+ * lookup reads it from the device. The table type is detected again too.
+ *
+ * @dev_desc:	Block device descriptor
+ */
+void part_cache_invalidate(struct blk_desc *dev_desc);
+
+/**
+ * part_cache_invalidate_range() - Check a write against the partition table
+ *
+ * With CONFIG_PARTITION_CACHE this calls part_cache_invalidate() unless the
+ * blocks lie entirely inside one cached partition, since a write anywhere
+ * else may change the partition table. Without a cached table, the tables
+ * kept by the partition drivers are dropped on every write. It is called for
+ * each block write.
+ *
+ * @dev_desc:	Block device descriptor
+ * @start:	First block written
+ * @blkcnt:	Number of blocks written
+ */
+void part_cache_invalidate_range(struct blk_desc *dev_desc, lbaint_t start,
+				 lbaint_t blkcnt);
+
 /**
  * blk_get_device_by_str() - Get a block device given its interface/hw partition
  *
@@ -215,6 +241,10 @@ static inline int part_get_info_whole_disk(struct blk_desc *dev_desc,
 { return -1; }
 static inline void part_print(struct blk_desc *dev_desc) {}
 static inline void part_init(struct blk_desc *dev_desc) {}
+static inline void part_cache_invalidate(struct blk_desc *dev_desc) {}
+static inline void part_cache_invalidate_range(struct blk_desc *dev_desc,
+					       lbaint_t start, lbaint_t blkcnt)
+{}
 static inline void dev_print(struct blk_desc *dev_desc) {}
 static inline int blk_get_device_by_str(const char *ifname, const char *dev_str,
 					struct blk_desc **dev_desc)
@@ -275,6 +305,16 @@ struct part_driver {
 	 *	   type, -ve if not
 	 */
 	int (*test)(struct blk_desc *dev_desc);
+
+	/**
+	 * invalidate() - Drop any partition table kept by the driver
+	 *
+	 * This is optional. It is called when the partition table of a
+	 * device may have changed, so the next get_info() must read it again.
+	 *
+	 * @dev_desc:	Block device descriptor
+	 */
+	void (*invalidate)(struct blk_desc *dev_desc);
 };
 
 /* Declare a new U-Boot partition 'driver' */
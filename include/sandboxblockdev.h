@@ -13,6 +13,7 @@ struct host_block_dev {
 #endif
 	char *filename;
 	int fd;
+	ulong reads;	/* number of read operations, for tests */
 };
 
 int host_dev_bind(int dev, char *filename);
@@ -53,6 +53,9 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Copy of the snapshot which entries were imported from, if any */
+	char *pool;
+	size_t pool_size;
 /*
  * Callback function which will check whether the given change for variable
  * "__item" to "newval" may be applied or not, and possibly apply such change.
@@ -103,6 +106,16 @@ extern int himport_r(struct hsearch_data *__htab,
 		     int __flag, int __crlf_is_lf, int nvars,
 		     char * const vars[]);
 
+/*
+ * Binary snapshot of the whole table, which can be imported without parsing.
+ * hsnapshot_check() returns non-zero if __buf starts like a snapshot.
+ */
+extern int hsnapshot_check(const char *__buf, size_t __size);
+extern ssize_t hexport_snapshot_r(struct hsearch_data *__htab, char *__buf,
+				  size_t __size);
+extern int himport_snapshot_r(struct hsearch_data *__htab, const char *__buf,
+			      size_t __size, int __flag);
+
 /* Walk the whole table calling the callback on each element */
 extern int hwalk_r(struct hsearch_data *__htab, int (*callback)(ENTRY *));
 
@@ -153,6 +153,10 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @tx_buf:	Pointer to the TX buffer, NULL if output is not buffered
+ * @tx_rd:	Read pointer in the TX buffer
+ * @tx_wr:	Write pointer in the TX buffer
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -160,8 +164,24 @@ struct serial_dev_priv {
 	char *buf;
 	int rd_ptr;
 	int wr_ptr;
+
+	char *tx_buf;
+	int tx_rd;
+	int tx_wr;
 };
 
+/**
+ * serial_flush() - Send all buffered serial output
+ *
+ * Waits until the TX buffer of each serial device has been taken by the
+ * UART, so that nothing is lost when booting an OS, resetting or hanging.
+ */
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+void serial_flush(void);
+#else
+static inline void serial_flush(void) {}
+#endif
+
 /* Access the serial operations for a device */
 #define serial_get_ops(dev)	((struct dm_serial_ops *)(dev)->driver->ops)
 
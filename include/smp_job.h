@@ -0,0 +1,155 @@
+/*
+ * Run independent jobs on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __SMP_JOB_H
+#define __SMP_JOB_H
+
+/**
+ * struct smp_job - A unit of work which may run on any CPU
+ *
+ * Jobs must not print, allocate memory or probe devices since these are not
+ * safe to do from several CPUs at once. Anything of that sort should be done
+ * by the caller before smp_job_queue() or after smp_job_wait().
+ *
+ * @func:	Function to run
+ * @arg:	Argument passed to @func
+ * @ret:	Return value of @func, valid once smp_job_wait() returns
+ * @done:	Set when @func has returned
+ * @next:	Next job in the queue (private)
+ */
+struct smp_job {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+	volatile int done;
+	struct smp_job *next;
+};
+
+/**
+ * struct smp_job_cpu - Per-CPU state of a worker
+ *
+ * @index:	Worker index, 0 for the first secondary CPU
+ * @id:		Arch-specific CPU ID, e.g. the MPIDR value
+ * @running:	Set by the worker once it is waiting for jobs, cleared when it
+ *		has left its loop
+ * @jobs:	Number of jobs run by this worker
+ * @priv:	Arch-private data
+ */
+struct smp_job_cpu {
+	int index;
+	ulong id;
+	volatile int running;
+	volatile uint jobs;
+	void *priv;
+};
+
+#if CONFIG_IS_ENABLED(SMP_JOB)
+/**
+ * smp_job_init() - Start the secondary CPUs if needed
+ *
+ * This is called by smp_job_queue() so need not be called explicitly. It
+ * does nothing if the workers are already running.
+ *
+ * @return number of worker CPUs available (0 if jobs run on the calling CPU)
+ */
+int smp_job_init(void);
+
+/**
+ * smp_job_queue() - Queue a job to be run by a worker
+ *
+ * If no workers are available the job is run before this function returns.
+ *
+ * @job:	Job to queue, which must stay valid until smp_job_wait()
+ * @func:	Function to run
+ * @arg:	Argument passed to @func
+ */
+void smp_job_queue(struct smp_job *job, int (*func)(void *arg), void *arg);
+
+/**
+ * smp_job_wait() - Wait for a job to complete
+ *
+ * The calling CPU runs queued jobs while it waits, so there is no need to
+ * wait for jobs in the order they were queued.
+ *
+ * @job:	Job to wait for
+ * @return value returned by the job's function
+ */
+int smp_job_wait(struct smp_job *job);
+
+/**
+ * smp_job_exit() - Run all queued jobs and stop the secondary CPUs
+ *
+ * This must be called before handing the secondary CPUs over to an OS.
+ */
+void smp_job_exit(void);
+
+/**
+ * smp_job_get_cpu() - Get the state of a worker CPU
+ *
+ * @index:	Worker index
+ * @return worker, or NULL if @index is not running
+ */
+struct smp_job_cpu *smp_job_get_cpu(int index);
+
+/* Loop run by each worker until smp_job_exit() is called */
+void smp_job_worker(struct smp_job_cpu *cpu);
+
+/**
+ * smp_job_arch_start() - Start the secondary CPUs
+ *
+ * Each CPU which is started must call smp_job_worker() with its entry in
+ * @cpus, which this function fills in.
+ *
+ * @cpus:	Array of worker state to fill in
+ * @max:	Maximum number of CPUs to start
+ * @return number of CPUs started
+ */
+int smp_job_arch_start(struct smp_job_cpu *cpus, int max);
+
+/**
+ * smp_job_arch_stop() - Wait for the workers to stop, then release them
+ *
+ * @cpus:	Array of worker state, as passed to smp_job_arch_start()
+ * @count:	Number of CPUs started
+ */
+void smp_job_arch_stop(struct smp_job_cpu *cpus, int count);
+
+/* Wait for smp_job_arch_kick(), used by idle workers */
+void smp_job_arch_idle(void);
+
+/* Wake up idle workers after new jobs are queued */
+void smp_job_arch_kick(void);
+#else
+static inline int smp_job_init(void)
+{
+	return 0;
+}
+
+static inline void smp_job_queue(struct smp_job *job, int (*func)(void *arg),
+				 void *arg)
+{
+	job->func = func;
+	job->arg = arg;
+	job->ret = func(arg);
+	job->done = 1;
+}
+
+static inline int smp_job_wait(struct smp_job *job)
+{
+	return job->ret;
+}
+
+static inline void smp_job_exit(void)
+{
+}
+
+static inline struct smp_job_cpu *smp_job_get_cpu(int index)
+{
+	return NULL;
+}
+#endif
+
+#endif /* __SMP_JOB_H */
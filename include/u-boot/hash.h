@@ -0,0 +1,154 @@
+/*
+ * Hash engine uclass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _UBOOT_HASH_H
+#define _UBOOT_HASH_H
+
+struct udevice;
+
+enum HASH_ALGO {
+	HASH_ALGO_CRC32,
+	HASH_ALGO_MD5,
+	HASH_ALGO_SHA1,
+	HASH_ALGO_SHA256,
+	HASH_ALGO_SHA512,
+
+	HASH_ALGO_NUM,
+	HASH_ALGO_INVALID = 0xffffffff,
+};
+
+/**
+ * struct hash_ops - Operations provided by a hash engine
+ *
+ * Several engines may be bound at once, e.g. a crypto block and the software
+ * fallback. hash_get_device() picks the probed engine with the highest
+ * @priority that supports the requested algorithm.
+ */
+struct hash_ops {
+	/* Engine preference, hardware engines should use a value above 0 */
+	int priority;
+
+	/**
+	 * supported() - Check whether the engine implements an algorithm
+	 *
+	 * @dev:	Hash device
+	 * @algo:	Algorithm to check
+	 * @return true if supported
+	 */
+	bool (*supported)(struct udevice *dev, enum HASH_ALGO algo);
+
+	/**
+	 * hash_init() - Start a progressive hash
+	 *
+	 * @dev:	Hash device
+	 * @algo:	Algorithm to use
+	 * @ctxp:	Returns the context, freed by hash_finish()
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*hash_init)(struct udevice *dev, enum HASH_ALGO algo, void **ctxp);
+
+	/**
+	 * hash_update() - Add data to a progressive hash
+	 *
+	 * The context is freed by this function if an error occurs.
+	 *
+	 * @dev:	Hash device
+	 * @ctx:	Context from hash_init()
+	 * @ibuf:	Data to hash
+	 * @ilen:	Length of data in bytes
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*hash_update)(struct udevice *dev, void *ctx, const void *ibuf,
+			   uint32_t ilen);
+
+	/**
+	 * hash_finish() - Write the digest and free the context
+	 *
+	 * @dev:	Hash device
+	 * @ctx:	Context from hash_init()
+	 * @obuf:	Output buffer, hash_algo_digest_size() bytes
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*hash_finish)(struct udevice *dev, void *ctx, void *obuf);
+
+	/**
+	 * hash_digest_wd() - Hash a buffer in one go
+	 *
+	 * This is optional, the uclass uses the progressive calls if it is
+	 * not provided.
+	 *
+	 * @dev:	Hash device
+	 * @algo:	Algorithm to use
+	 * @ibuf:	Data to hash
+	 * @ilen:	Length of data in bytes
+	 * @obuf:	Output buffer, hash_algo_digest_size() bytes
+	 * @chunk_sz:	Reset the watchdog after this many bytes
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*hash_digest_wd)(struct udevice *dev, enum HASH_ALGO algo,
+			      const void *ibuf, uint32_t ilen, void *obuf,
+			      uint32_t chunk_sz);
+};
+
+/**
+ * hash_algo_lookup_by_name() - Convert an algorithm name to its ID
+ *
+ * @name:	Algorithm name, e.g. "sha256"
+ * @return algorithm ID, or HASH_ALGO_INVALID if unknown
+ */
+enum HASH_ALGO hash_algo_lookup_by_name(const char *name);
+
+/**
+ * hash_algo_digest_size() - Get the digest size of an algorithm
+ *
+ * @algo:	Algorithm ID
+ * @return digest size in bytes, or -EINVAL if unknown
+ */
+int hash_algo_digest_size(enum HASH_ALGO algo);
+
+/**
+ * hash_algo_name() - Get the name of an algorithm
+ *
+ * @algo:	Algorithm ID
+ * @return name, or "unknown"
+ */
+const char *hash_algo_name(enum HASH_ALGO algo);
+
+/**
+ * hash_get_device() - Find the preferred engine for an algorithm
+ *
+ * Engines which fail to probe (e.g. because the CPU lacks the required
+ * instructions) are skipped.
+ *
+ * @algo:	Algorithm ID
+ * @devp:	Returns the device
+ * @return 0 if OK, -ENODEV if no engine supports @algo
+ */
+int hash_get_device(enum HASH_ALGO algo, struct udevice **devp);
+
+int hash_digest_wd(struct udevice *dev, enum HASH_ALGO algo,
+		   const void *ibuf, uint32_t ilen, void *obuf,
+		   uint32_t chunk_sz);
+int hash_init(struct udevice *dev, enum HASH_ALGO algo, void **ctxp);
+int hash_update(struct udevice *dev, void *ctx, const void *ibuf,
+		uint32_t ilen);
+int hash_finish(struct udevice *dev, void *ctx, void *obuf);
+
+/**
+ * hash_digest_by_name() - Hash a buffer with the preferred engine
+ *
+ * @name:	Algorithm name, e.g. "sha256"
+ * @ibuf:	Data to hash
+ * @ilen:	Length of data in bytes
+ * @obuf:	Output buffer
+ * @olen:	On entry the size of @obuf, on exit the digest size
+ * @return 0 if OK, -EPROTONOSUPPORT if the algorithm is unknown, -ENOSPC if
+ *	@obuf is too small, other -ve on error
+ */
+int hash_digest_by_name(const char *name, const void *ibuf, uint32_t ilen,
+			void *obuf, int *olen);
+
+#endif /* _UBOOT_HASH_H */
@@ -53,6 +53,18 @@ void sha1_starts( sha1_context *ctx );
 void sha1_update(sha1_context *ctx, const unsigned char *input,
 		 unsigned int ilen);
 
+/**
+ * \brief	   SHA-1 compression function over whole 64-byte blocks
+ *
+ * \param ctx	   SHA-1 context, only the state is updated
+ * \param data	   buffer holding the blocks
+ * \param blocks   number of 64-byte blocks in the buffer
+ */
+void sha1_transform(sha1_context *ctx, const unsigned char *data,
+		    unsigned int blocks);
+void sha1_transform_generic(sha1_context *ctx, const unsigned char *data,
+			    unsigned int blocks);
+
 /**
  * \brief	   SHA-1 final digest
  *
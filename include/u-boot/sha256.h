@@ -19,6 +19,18 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/**
+ * sha256_transform() - Run the SHA-256 compression function over whole blocks
+ *
+ * @state:	Hash state, updated in place
+ * @data:	Input data, @blocks * 64 bytes
+ * @blocks:	Number of 64-byte blocks to process
+ */
+void sha256_transform(uint32_t state[8], const uint8_t *data,
+		      unsigned int blocks);
+void sha256_transform_generic(uint32_t state[8], const uint8_t *data,
+			      unsigned int blocks);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
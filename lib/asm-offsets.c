@@ -34,6 +34,8 @@ int main(void)
 
 	DEFINE(GD_RELOCADDR, offsetof(struct global_data, relocaddr));
 
+	DEFINE(GD_RAM_TOP, offsetof(struct global_data, ram_top));
+
 	DEFINE(GD_RELOC_OFF, offsetof(struct global_data, reloc_off));
 
 	DEFINE(GD_START_ADDR_SP, offsetof(struct global_data, start_addr_sp));
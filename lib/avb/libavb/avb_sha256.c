@@ -36,6 +36,7 @@
  */
 
 #include <android_avb/avb_sha.h>
+#include <u-boot/sha256.h>
 
 #define SHFR(x, n) (x >> n)
 #define ROTR(x, n) ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -121,6 +122,14 @@ void avb_sha256_init(AvbSHA256Ctx* ctx) {
   ctx->tot_len = 0;
 }
 
+#ifdef CONFIG_SHA256
+/* Share U-Boot's block function, which may be architecture-accelerated */
+static void SHA256_transform(AvbSHA256Ctx* ctx,
+                             const uint8_t* message,
+                             unsigned int block_nb) {
+  sha256_transform(ctx->h, message, block_nb);
+}
+#else
 static void SHA256_transform(AvbSHA256Ctx* ctx,
                              const uint8_t* message,
                              unsigned int block_nb) {
@@ -319,6 +328,7 @@ static void SHA256_transform(AvbSHA256Ctx* ctx,
 #endif /* !UNROLL_LOOPS */
   }
 }
+#endif /* CONFIG_SHA256 */
 
 void avb_sha256_update(AvbSHA256Ctx* ctx, const uint8_t* data, uint32_t len) {
   unsigned int block_nb;
@@ -36,6 +36,7 @@
  */
 
 #include <android_avb/avb_sha.h>
+#include <u-boot/sha512.h>
 
 #define SHFR(x, n) (x >> n)
 #define ROTR(x, n) ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -152,6 +153,14 @@ void avb_sha512_init(AvbSHA512Ctx* ctx) {
   ctx->tot_len = 0;
 }
 
+#ifdef CONFIG_SHA512
+/* Share U-Boot's block function, which may be architecture-accelerated */
+static void SHA512_transform(AvbSHA512Ctx* ctx,
+                             const uint8_t* message,
+                             unsigned int block_nb) {
+  sha512_transform(ctx->h, message, block_nb);
+}
+#else
 static void SHA512_transform(AvbSHA512Ctx* ctx,
                              const uint8_t* message,
                              unsigned int block_nb) {
@@ -317,6 +326,7 @@ static void SHA512_transform(AvbSHA512Ctx* ctx,
 #endif /* UNROLL_LOOPS_SHA512 */
   }
 }
+#endif /* CONFIG_SHA512 */
 
 void avb_sha512_update(AvbSHA512Ctx* ctx, const uint8_t* data, uint32_t len) {
   unsigned int block_nb;
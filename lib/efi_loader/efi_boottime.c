@@ -14,6 +14,7 @@
 #include <u-boot/crc.h>
 #include <bootm.h>
 #include <inttypes.h>
+#include <smp_job.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -842,6 +843,9 @@ static efi_status_t EFIAPI efi_exit_boot_services(void *image_handle,
 {
 	EFI_ENTRY("%p, %ld", image_handle, map_key);
 
+	/* Power off the secondary CPUs so that the OS can start them */
+	smp_job_exit();
+
 	board_quiesce_devices();
 
 	/* Fix up caches for EFI payloads if necessary */
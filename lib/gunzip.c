@@ -9,9 +9,13 @@
 #include <watchdog.h>
 #include <command.h>
 #include <console.h>
+#include <fs.h>
+#include <gzip.h>
 #include <image.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <memalign.h>
+#include <smp_job.h>
 #include <u-boot/zlib.h>
 #include <div64.h>
 
@@ -306,3 +310,182 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 
 	return err;
 }
+
+#if CONFIG_IS_ENABLED(GZIP_STREAM)
+static long gunzip_blk_read(struct gunzip_src *src, u64 offset, void *buf,
+			    ulong size)
+{
+	struct blk_desc *desc = src->blk.desc;
+	lbaint_t blkcnt;
+
+	/* gunzip_stream() reads whole chunks, which are a multiple of blksz */
+	if (offset & (desc->blksz - 1))
+		return -EINVAL;
+	size = min_t(u64, size, src->size - offset);
+	blkcnt = DIV_ROUND_UP(size, desc->blksz);
+	if (blk_dread(desc, src->blk.start + lldiv(offset, desc->blksz),
+		      blkcnt, buf) != blkcnt)
+		return -EIO;
+
+	return size;
+}
+
+void gunzip_src_blk(struct gunzip_src *src, struct blk_desc *desc,
+		    lbaint_t start, u64 size)
+{
+	src->read = gunzip_blk_read;
+	src->close = NULL;
+	src->size = size;
+	src->blk.desc = desc;
+	src->blk.start = start;
+}
+
+static long gunzip_fs_read(struct gunzip_src *src, u64 offset, void *buf,
+			   ulong size)
+{
+	loff_t actread;
+
+	if (!src->fs.open) {
+		if (fs_set_blk_dev(src->fs.ifname, src->fs.dev_part,
+				   FS_TYPE_ANY))
+			return -ENODEV;
+		src->fs.open = true;
+	}
+	size = min_t(u64, size, src->size - offset);
+	if (fs_read_keep(src->fs.filename, map_to_sysmem(buf), offset, size,
+			 &actread))
+		return -EIO;
+
+	return actread;
+}
+
+static void gunzip_fs_close(struct gunzip_src *src)
+{
+	if (src->fs.open)
+		fs_close();
+	src->fs.open = false;
+}
+
+int gunzip_src_fs(struct gunzip_src *src, const char *ifname,
+		  const char *dev_part, const char *filename)
+{
+	loff_t size;
+
+	if (fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY))
+		return -ENODEV;
+	if (fs_size(filename, &size))
+		return -ENOENT;
+	src->read = gunzip_fs_read;
+	src->close = gunzip_fs_close;
+	src->size = size;
+	src->fs.ifname = ifname;
+	src->fs.dev_part = dev_part;
+	src->fs.filename = filename;
+	src->fs.open = false;
+
+	return 0;
+}
+
+static int gunzip_inflate(void *arg)
+{
+	return inflate(arg, Z_NO_FLUSH);
+}
+
+int gunzip_stream(struct gunzip_src *src, void *dst, ulong dstlen,
+		  ulong *lenp)
+{
+	const ulong chunk = CONFIG_GZIP_STREAM_CHUNK;
+	unsigned char *buf[2];
+	struct smp_job job;
+	u64 offset = 0;
+	long len, next;
+	bool async;
+	int cur = 0;
+	z_stream s;
+	int ret, r;
+
+	*lenp = 0;
+	buf[0] = malloc_cache_aligned(chunk);
+	buf[1] = malloc_cache_aligned(chunk);
+	if (!buf[0] || !buf[1]) {
+		ret = -ENOMEM;
+		goto err_buf;
+	}
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	/* Let zlib parse the gzip header and check the trailer */
+	r = inflateInit2(&s, 16 + MAX_WBITS);
+	if (r != Z_OK) {
+		printf("Error: inflateInit2() returned %d\n", r);
+		ret = -ENOMEM;
+		goto err_buf;
+	}
+	s.next_out = dst;
+	s.avail_out = min_t(ulong, dstlen, UINT_MAX);
+
+	len = src->read(src, 0, buf[0], chunk);
+	while (1) {
+		if (len < 0) {
+			printf("Error: gunzip read failed at %llu\n", offset);
+			ret = -EIO;
+			break;
+		} else if (!len) {
+			puts("Error: gunzip out of data\n");
+			ret = -EINVAL;
+			break;
+		}
+		offset += len;
+		s.next_in = buf[cur];
+		s.avail_in = len;
+
+		/*
+		 * inflate() allocates its window when it first produces
+		 * output, so keep it on this CPU until then. After that it
+		 * can run alongside the read of the next chunk.
+		 */
+		async = s.total_out != 0;
+		if (async)
+			smp_job_queue(&job, gunzip_inflate, &s);
+		else
+			r = gunzip_inflate(&s);
+		next = 0;
+		if (offset < src->size)
+			next = src->read(src, offset, buf[!cur], chunk);
+		if (async)
+			r = smp_job_wait(&job);
+		WATCHDOG_RESET();
+
+		if (r == Z_STREAM_END) {
+			ret = 0;
+			break;
+		} else if (r != Z_OK && r != Z_BUF_ERROR) {
+			printf("Error: inflate() returned %d\n", r);
+			ret = -EINVAL;
+			break;
+		} else if (s.avail_in) {
+			/* inflate() only stops early if the output is full */
+			puts("Error: gunzip output buffer too small\n");
+			ret = -ENOSPC;
+			break;
+		}
+		if (ctrlc()) {
+			puts("abort\n");
+			ret = -EINTR;
+			break;
+		}
+		cur = !cur;
+		len = next;
+	}
+
+	*lenp = s.next_out - (unsigned char *)dst;
+	inflateEnd(&s);
+err_buf:
+	free(buf[1]);
+	free(buf[0]);
+	if (src->close)
+		src->close(src);
+
+	return ret;
+}
+#endif
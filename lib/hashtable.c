@@ -32,6 +32,7 @@
 # include <common.h>
 # include <linux/string.h>
 # include <linux/ctype.h>
+# include <asm/unaligned.h>
 #endif
 
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
@@ -66,6 +67,22 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+/*
+ * Keys and values loaded from a snapshot point into htab->pool rather than
+ * being allocated one by one, so must not be freed on their own
+ */
+static inline int in_pool(struct hsearch_data *htab, const void *p)
+{
+	return htab->pool && (const char *)p >= htab->pool &&
+	       (const char *)p < htab->pool + htab->pool_size;
+}
+
+static void hfree(struct hsearch_data *htab, const void *p)
+{
+	if (!in_pool(htab, p))
+		free((void *)p);
+}
+
 /*
  * hcreate()
  */
@@ -151,11 +168,14 @@ void hdestroy_r(struct hsearch_data *htab)
 		if (htab->table[i].used > 0) {
 			ENTRY *ep = &htab->table[i].entry;
 
-			free((void *)ep->key);
-			free(ep->data);
+			hfree(htab, ep->key);
+			hfree(htab, ep->data);
 		}
 	}
 	free(htab->table);
+	free(htab->pool);
+	htab->pool = NULL;
+	htab->pool_size = 0;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -252,8 +272,11 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 				return 0;
 			}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
+			/* Setting the same value again changes nothing */
+			if (strcmp(htab->table[idx].entry.data, item.data)) {
+				hfree(htab, htab->table[idx].entry.data);
+				htab->table[idx].entry.data = strdup(item.data);
+			}
 			if (!htab->table[idx].entry.data) {
 				__set_errno(ENOMEM);
 				*retval = NULL;
@@ -268,32 +291,42 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 	return -1;
 }
 
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
-	      struct hsearch_data *htab, int flag)
+/* First hash function, which gives the first index tried for @key */
+static unsigned int hhash(const char *key, unsigned int size)
 {
+	unsigned int len = strlen(key);
 	unsigned int hval;
 	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
 
 	/* Compute an value for the given string. Perhaps use a better method. */
 	hval = len;
 	count = len;
 	while (count-- > 0) {
 		hval <<= 4;
-		hval += item.key[count];
+		hval += key[count];
 	}
 
 	/*
 	 * First hash function:
 	 * simply take the modul but prevent zero.
 	 */
-	hval %= htab->size;
+	hval %= size;
 	if (hval == 0)
 		++hval;
 
+	return hval;
+}
+
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab, int flag)
+{
+	unsigned int hval;
+	unsigned int idx;
+	unsigned int first_deleted = 0;
+	int ret;
+
+	hval = hhash(item.key, htab->size);
+
 	/* The first index tried. */
 	idx = hval;
 
@@ -430,8 +463,8 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 {
 	/* free used ENTRY */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
+	hfree(htab, ep->key);
+	hfree(htab, ep->data);
 	ep->callback = NULL;
 	ep->flags = 0;
 	htab->table[idx].used = -1;
@@ -956,6 +989,255 @@ int himport_r(struct hsearch_data *htab,
 	return 1;		/* everything OK */
 }
 
+#ifdef CONFIG_ENV_BINARY
+/*
+ * hexport_snapshot() / himport_snapshot()
+ */
+
+/*
+ * A snapshot holds the table as it is laid out in memory, so that it can be
+ * loaded without parsing text or hashing into a new table. It is made of:
+ *
+ * - a header
+ * - one 32-bit word for each slot of the table: 0 if the slot is empty, 1
+ *   if its entry was deleted, otherwise the offset of the entry's strings
+ * - the strings of each entry, "key\0value\0"
+ *
+ * The header starts with a NUL so that an older U-Boot sees an empty text
+ * environment rather than rubbish. Strings which have not changed keep
+ * their offset from one snapshot to the next, so saving one changes few
+ * blocks of the storage it is saved to.
+ */
+#define HSNAP_MAGIC	"\0HT1"
+#define HSNAP_EMPTY	0
+#define HSNAP_DELETED	1
+
+struct hsnap_hdr {
+	char magic[4];
+	u32 size;	/* Number of slots in the table */
+	u32 strings;	/* Offset of the first string */
+	u32 end;	/* Offset of the end of the last string */
+};
+
+int hsnapshot_check(const char *buf, size_t size)
+{
+	return size >= sizeof(struct hsnap_hdr) &&
+	       !memcmp(buf, HSNAP_MAGIC, sizeof(HSNAP_MAGIC) - 1);
+}
+
+/* Point the table's entries into a copy of the snapshot it was written to */
+static void hsnapshot_rebase(struct hsearch_data *htab, const char *buf,
+			     size_t size)
+{
+	const u32 *slots = (const u32 *)(buf + sizeof(struct hsnap_hdr));
+	char *pool;
+	int i;
+
+	pool = malloc(size);
+	if (!pool)
+		return;
+	memcpy(pool, buf, size);
+	for (i = 1; i <= htab->size; ++i) {
+		ENTRY *ep = &htab->table[i].entry;
+		char *key = pool + get_unaligned_le32(&slots[i - 1]);
+
+		if (htab->table[i].used <= 0)
+			continue;
+		hfree(htab, ep->key);
+		hfree(htab, ep->data);
+		ep->key = key;
+		ep->data = key + strlen(key) + 1;
+	}
+	free(htab->pool);
+	htab->pool = pool;
+	htab->pool_size = size;
+}
+
+#if !(defined(CONFIG_SPL_BUILD) && !defined(CONFIG_SPL_SAVEENV))
+ssize_t hexport_snapshot_r(struct hsearch_data *htab, char *buf, size_t size)
+{
+	struct hsnap_hdr *hdr = (struct hsnap_hdr *)buf;
+	const struct hsnap_hdr *old = (const struct hsnap_hdr *)htab->pool;
+	u32 *slots = (u32 *)(hdr + 1);
+	size_t strings = sizeof(*hdr) + htab->size * sizeof(u32);
+	size_t end;
+	int reuse;
+	int i;
+
+	if (strings > size) {
+		__set_errno(ENOSPC);
+		return -1;
+	}
+
+	/* Keep strings which are still in use where they were */
+	reuse = old && htab->pool_size == size &&
+		get_unaligned_le32(&old->size) == htab->size;
+again:
+	end = strings;
+	if (reuse) {
+		end = get_unaligned_le32(&old->end);
+		memcpy(buf + strings, htab->pool + strings, end - strings);
+	}
+	for (i = 1; i <= htab->size; ++i) {
+		ENTRY *ep = &htab->table[i].entry;
+		size_t klen, dlen;
+
+		if (!htab->table[i].used) {
+			put_unaligned_le32(HSNAP_EMPTY, &slots[i - 1]);
+			continue;
+		} else if (htab->table[i].used < 0) {
+			put_unaligned_le32(HSNAP_DELETED, &slots[i - 1]);
+			continue;
+		}
+
+		klen = strlen(ep->key) + 1;
+		if (reuse && in_pool(htab, ep->key) &&
+		    ep->data == ep->key + klen) {
+			put_unaligned_le32(ep->key - htab->pool, &slots[i - 1]);
+			continue;
+		}
+		dlen = strlen(ep->data) + 1;
+		if (end + klen + dlen > size) {
+			if (reuse) {
+				/* Pack all the strings afresh */
+				reuse = 0;
+				goto again;
+			}
+			__set_errno(ENOSPC);
+			return -1;
+		}
+		memcpy(buf + end, ep->key, klen);
+		memcpy(buf + end + klen, ep->data, dlen);
+		put_unaligned_le32(end, &slots[i - 1]);
+		end += klen + dlen;
+	}
+	memset(buf + end, '\0', size - end);
+
+	memcpy(hdr->magic, HSNAP_MAGIC, sizeof(hdr->magic));
+	put_unaligned_le32(htab->size, &hdr->size);
+	put_unaligned_le32(strings, &hdr->strings);
+	put_unaligned_le32(end, &hdr->end);
+	hsnapshot_rebase(htab, buf, size);
+
+	return size;
+}
+#endif
+
+/* Check that the slots of a snapshot only point at terminated strings */
+static int hsnapshot_valid(const char *buf, size_t size)
+{
+	const struct hsnap_hdr *hdr = (const struct hsnap_hdr *)buf;
+	const u32 *slots = (const u32 *)(hdr + 1);
+	size_t klen, dlen, off, end;
+	u32 i, count;
+
+	if (!hsnapshot_check(buf, size))
+		return 0;
+	count = get_unaligned_le32(&hdr->size);
+	end = get_unaligned_le32(&hdr->end);
+	if (count < 3 || count > size / sizeof(u32) ||
+	    get_unaligned_le32(&hdr->strings) !=
+			sizeof(*hdr) + count * sizeof(u32) ||
+	    get_unaligned_le32(&hdr->strings) > end || end > size)
+		return 0;
+	for (i = 0; i < count; ++i) {
+		off = get_unaligned_le32(&slots[i]);
+		if (off == HSNAP_EMPTY || off == HSNAP_DELETED)
+			continue;
+		if (off < get_unaligned_le32(&hdr->strings) || off >= end)
+			return 0;
+		klen = strnlen(buf + off, end - off) + 1;
+		if (klen == 1 || off + klen >= end)
+			return 0;
+		dlen = strnlen(buf + off + klen, end - off - klen) + 1;
+		if (off + klen + dlen > end)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Import a snapshot made by hexport_snapshot_r(), replacing the contents of
+ * the table. The strings stay in one copy of the snapshot. Callbacks and
+ * permission checks are run for each entry, as himport_r() does.
+ */
+int himport_snapshot_r(struct hsearch_data *htab, const char *buf,
+		       size_t size, int flag)
+{
+	const struct hsnap_hdr *hdr = (const struct hsnap_hdr *)buf;
+	const u32 *slots = (const u32 *)(hdr + 1);
+	u32 count;
+	int i;
+
+	if (!hsnapshot_valid(buf, size)) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	count = get_unaligned_le32(&hdr->size);
+	if (htab->table)
+		hdestroy_r(htab);
+	if (!hcreate_r(count, htab))
+		return 0;
+	if (htab->size != count) {
+		/* Not a prime, so not a table we wrote */
+		hdestroy_r(htab);
+		__set_errno(EINVAL);
+		return 0;
+	}
+	htab->pool = malloc(size);
+	if (!htab->pool) {
+		hdestroy_r(htab);
+		__set_errno(ENOMEM);
+		return 0;
+	}
+	memcpy(htab->pool, buf, size);
+	htab->pool_size = size;
+
+	for (i = 1; i <= htab->size; ++i) {
+		ENTRY *ep = &htab->table[i].entry;
+		u32 off = get_unaligned_le32(&slots[i - 1]);
+
+		if (off == HSNAP_EMPTY)
+			continue;
+		if (off == HSNAP_DELETED) {
+			htab->table[i].used = -1;
+			continue;
+		}
+		ep->key = htab->pool + off;
+		ep->data = htab->pool + off + strlen(ep->key) + 1;
+		htab->table[i].used = hhash(ep->key, htab->size);
+		++htab->filled;
+	}
+
+	/* Look up callbacks and flags once all the entries are present */
+	for (i = 1; i <= htab->size; ++i) {
+		ENTRY *ep = &htab->table[i].entry;
+
+		if (htab->table[i].used <= 0)
+			continue;
+		env_callback_init(ep);
+		env_flags_init(ep);
+		if (htab->change_ok != NULL &&
+		    htab->change_ok(ep, ep->data, env_op_create, flag)) {
+			debug("change_ok() rejected setting variable "
+				"%s, skipping it!\n", ep->key);
+			_hdelete(ep->key, htab, ep, i);
+			continue;
+		}
+		if (ep->callback &&
+		    ep->callback(ep->key, ep->data, env_op_create, flag)) {
+			debug("callback() rejected setting variable "
+				"%s, skipping it!\n", ep->key);
+			_hdelete(ep->key, htab, ep, i);
+		}
+	}
+
+	return 1;
+}
+#endif /* CONFIG_ENV_BINARY */
+
 /*
  * hwalk_r()
  */
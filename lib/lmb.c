@@ -322,6 +322,27 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 	return 0;
 }
 
+/*
+ * Reserve the region at a fixed address, if it lies within one memory region
+ * and none of it is reserved yet. Returns the address, or 0 on failure.
+ */
+phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	struct lmb_region *mem = &lmb->memory;
+	long rgn;
+
+	rgn = lmb_overlaps_region(mem, base, size);
+	if (rgn < 0 || base < mem->region[rgn].base ||
+	    base + size > mem->region[rgn].base + mem->region[rgn].size)
+		return 0;
+	if (lmb_overlaps_region(&lmb->reserved, base, size) >= 0)
+		return 0;
+	if (lmb_reserve(lmb, base, size) < 0)
+		return 0;
+
+	return base;
+}
+
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
 	int i;
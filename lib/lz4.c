@@ -23,6 +23,19 @@ static void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
     do { LZ4_copy8(d,s); d+=8; s+=8; } while (d<e);
 }
 
+/*
+ * As LZ4_wildCopy() but 16 bytes at a time, so it may overwrite up to 15
+ * bytes beyond dstEnd. The two 8-byte copies are done in order, so this is
+ * also correct for overlapping copies as long as dstPtr - srcPtr >= 8.
+ */
+static void LZ4_wildCopy16(void* dstPtr, const void* srcPtr, void* dstEnd)
+{
+    BYTE* d = (BYTE*)dstPtr;
+    const BYTE* s = (const BYTE*)srcPtr;
+    BYTE* e = (BYTE*)dstEnd;
+    do { LZ4_copy8(d,s); LZ4_copy8(d+8,s+8); d+=16; s+=16; } while (d<e);
+}
+
 
 /**************************************
 *  Common Constants
@@ -34,6 +47,9 @@ static void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
 #define MFLIMIT (COPYLENGTH+MINMATCH)
 static const int LZ4_minLength = (MFLIMIT+1);
 
+/* Matches ending closer than this to the end of the output are copied bytewise */
+#define MATCH_SAFEGUARD_DISTANCE 32
+
 #define KB *(1 <<10)
 #define MB *(1 <<20)
 #define GB *(1U<<30)
@@ -53,17 +69,65 @@ static const int LZ4_minLength = (MFLIMIT+1);
 typedef enum { noDict = 0, withPrefix64k, usingExtDict } dict_directive;
 typedef enum { endOnOutputSize = 0, endOnInputSize = 1 } endCondition_directive;
 typedef enum { full = 0, partial = 1 } earlyEnd_directive;
-
+typedef enum { separateBuffers = 0, inPlace = 1 } inPlace_directive;
 
 
 /*******************************
 *  Decompression functions
 *******************************/
+
+/*
+ * Copy a match whose offset is below 8, so that source and destination
+ * overlap within a single 8-byte copy. Offsets 1, 2 and 4 repeat an 8-byte
+ * pattern, the others are spread out until the distance is at least 8.
+ * May overwrite up to 7 bytes beyond dstEnd.
+ */
+FORCE_INLINE void LZ4_copyShortOffset(BYTE* op, const BYTE* match, BYTE* const dstEnd, const size_t offset)
+{
+    static const unsigned inc32table[8] = {0, 1, 2, 1, 0, 4, 4, 4};
+    static const int dec64table[8] = {0, 0, 0, -1, -4, 1, 2, 3};
+    U64 pattern;    /* not a byte array, since it is read with LZ4_copy8() */
+    BYTE* const v = (BYTE*)&pattern;
+
+    switch (offset)
+    {
+    case 1:
+        memset(v, *match, 8);
+        break;
+    case 2:
+        memcpy(v, match, 2);
+        memcpy(v+2, v, 2);
+        memcpy(v+4, v, 4);
+        break;
+    case 4:
+        memcpy(v, match, 4);
+        memcpy(v+4, v, 4);
+        break;
+    default:
+        op[0] = match[0];
+        op[1] = match[1];
+        op[2] = match[2];
+        op[3] = match[3];
+        match += inc32table[offset];
+        LZ4_copy4(op+4, match);
+        match -= dec64table[offset];
+        op += 8;
+        LZ4_wildCopy(op, match, dstEnd);
+        return;
+    }
+
+    do { LZ4_copy8(op, &pattern); op+=8; } while (op<dstEnd);
+}
+
 /*
  * This generic decompression function cover all use cases.
  * It shall be instantiated several times, using different sets of directives
  * Note that it is essential this generic function is really inlined,
  * in order to remove useless branches during compilation optimization.
+ *
+ * Unless the input lies within the output buffer (inPlace), literals and
+ * matches are copied 16 bytes at a time, and short sequences which are well
+ * away from the buffer ends take a shortcut which avoids most length checks.
  */
 FORCE_INLINE int LZ4_decompress_generic(
                  const char* const source,
@@ -77,7 +141,8 @@ FORCE_INLINE int LZ4_decompress_generic(
                  int dict,               /* noDict, withPrefix64k, usingExtDict */
                  const BYTE* const lowPrefix,  /* == dest if dict == noDict */
                  const BYTE* const dictStart,  /* only if dict==usingExtDict */
-                 const size_t dictSize         /* note : = 0 if noDict */
+                 const size_t dictSize,        /* note : = 0 if noDict */
+                 int inPlaceDecoding           /* separateBuffers, inPlace */
                  )
 {
     /* Local Variables */
@@ -91,12 +156,15 @@ FORCE_INLINE int LZ4_decompress_generic(
     const BYTE* const lowLimit = lowPrefix - dictSize;
 
     const BYTE* const dictEnd = (const BYTE*)dictStart + dictSize;
-    const size_t dec32table[] = {4, 1, 2, 1, 4, 4, 4, 4};
-    const size_t dec64table[] = {0, 0, 0, (size_t)-1, 0, 1, 2, 3};
 
     const int safeDecode = (endOnInput==endOnInputSize);
     const int checkOffset = ((safeDecode) && (dictSize < (int)(64 KB)));
 
+    /* The shortcut reads 16 literal bytes and writes up to 32 bytes */
+    const int shortcut = (endOnInput) && (!partialDecoding) && (dict==noDict) && (!inPlaceDecoding);
+    const BYTE* const shortiend = iend - 14 /* maxLL */ - 2 /* offset */;
+    BYTE* const shortoend = oend - 14 /* maxLL */ - 18 /* maxML */;
+
 
     /* Special cases */
     if ((partialDecoding) && (oexit> oend-MFLIMIT)) oexit = oend-MFLIMIT;                         /* targetOutputSize too high => decode everything */
@@ -109,11 +177,37 @@ FORCE_INLINE int LZ4_decompress_generic(
     {
         unsigned token;
         size_t length;
+        size_t offset;
         const BYTE* match;
 
         /* get literal length */
         token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)
+        length = token>>ML_BITS;
+
+        if ((shortcut) && (length != RUN_MASK)
+            && likely((inputSize >= 16) && (ip < shortiend) && (outputSize >= 32) && (op <= shortoend)))
+        {
+            /* copy up to 14 literals, then a match of up to 18 bytes */
+            LZ4_copy8(op, ip);
+            LZ4_copy8(op+8, ip+8);
+            op += length; ip += length;
+
+            length = token & ML_MASK;
+            offset = LZ4_readLE16(ip); ip += 2;
+            match = op - offset;
+            if ((length != ML_MASK) && (offset >= 8) && likely(match >= lowPrefix))
+            {
+                LZ4_copy8(op, match);
+                LZ4_copy8(op+8, match+8);
+                op[16] = match[16];
+                op[17] = match[17];
+                op += length + MINMATCH;
+                continue;
+            }
+            goto _copy_match;
+        }
+
+        if (length == RUN_MASK)
         {
             unsigned s;
             do
@@ -141,20 +235,25 @@ FORCE_INLINE int LZ4_decompress_generic(
                 if ((!endOnInput) && (cpy != oend)) goto _output_error;       /* Error : block decoding must stop exactly there */
                 if ((endOnInput) && ((ip+length != iend) || (cpy > oend))) goto _output_error;   /* Error : input must be consumed */
             }
-            memcpy(op, ip, length);
+            memmove(op, ip, length);
             ip += length;
             op += length;
             break;     /* Necessarily EOF, due to parsing restrictions */
         }
-        LZ4_wildCopy(op, ip, cpy);
+        if ((!inPlaceDecoding) && (endOnInput) && (cpy <= oend-16) && (ip+length <= iend-16))
+            LZ4_wildCopy16(op, ip, cpy);
+        else
+            LZ4_wildCopy(op, ip, cpy);
         ip += length; op = cpy;
 
         /* get offset */
-        match = cpy - LZ4_readLE16(ip); ip+=2;
-        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
+        offset = LZ4_readLE16(ip); ip+=2;
+        match = op - offset;
 
         /* get matchlength */
         length = token & ML_MASK;
+_copy_match:
+        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
         if (length == ML_MASK)
         {
             unsigned s;
@@ -203,29 +302,22 @@ FORCE_INLINE int LZ4_decompress_generic(
 
         /* copy repeated sequence */
         cpy = op + length;
-        if (unlikely((op-match)<8))
-        {
-            const size_t dec64 = dec64table[op-match];
-            op[0] = match[0];
-            op[1] = match[1];
-            op[2] = match[2];
-            op[3] = match[3];
-            match += dec32table[op-match];
-            LZ4_copy4(op+4, match);
-            op += 8; match -= dec64;
-        } else { LZ4_copy8(op, match); op+=8; match+=8; }
-
-        if (unlikely(cpy>oend-12))
+        if (unlikely(cpy > oend-MATCH_SAFEGUARD_DISTANCE))
         {
             if (cpy > oend-LASTLITERALS) goto _output_error;    /* Error : last LASTLITERALS bytes must be literals */
-            if (op < oend-8)
+            if ((op-match >= 8) && (op < oend-MATCH_SAFEGUARD_DISTANCE))
             {
-                LZ4_wildCopy(op, match, oend-8);
-                match += (oend-8) - op;
-                op = oend-8;
+                BYTE* const oCopyLimit = oend-MATCH_SAFEGUARD_DISTANCE;
+                LZ4_wildCopy(op, match, oCopyLimit);
+                match += oCopyLimit - op;
+                op = oCopyLimit;
             }
             while (op<cpy) *op++ = *match++;
         }
+        else if (unlikely(offset < 8))
+            LZ4_copyShortOffset(op, match, cpy, offset);
+        else if (!inPlaceDecoding)
+            LZ4_wildCopy16(op, match, cpy);
         else
             LZ4_wildCopy(op, match, cpy);
         op=cpy;   /* correction */
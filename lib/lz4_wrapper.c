@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <smp_job.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 
@@ -21,10 +22,14 @@ typedef uint64_t U64;
 
 #define FORCE_INLINE static inline __attribute__((always_inline))
 
-/* Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
+/*
+ * From github.com/Cyan4973/lz4, with unrelated code removed and the copy
+ * loops widened to 16 bytes.
+ */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 #define LZ4F_MAGIC 0x184D2204
+#define LZ4_LEGACY_MAGIC 0x184C2102
 
 struct lz4_frame_header {
 	u32 magic;
@@ -63,15 +68,257 @@ struct lz4_block_header {
 	/* + u32 block_checksum iff has_block_checksum is set */
 } __packed;
 
+/*
+ * Decode a single block into @out, which has room for @space bytes. @in_place
+ * must be set if the input may lie within the output buffer.
+ *
+ * @return number of bytes written, or -ve on error
+ */
+static int ulz4fn_block(const void *in, const struct lz4_block_header *b,
+			void *out, ptrdiff_t space, bool in_place)
+{
+	int ret;
+
+	if (b->not_compressed) {
+		size_t size = min_t(ptrdiff_t, b->size, space);
+
+		memmove(out, in, size);
+		if (size < b->size)
+			return -ENOBUFS;	/* output overrun */
+		return size;
+	}
+
+	/* constant folding essential, do not touch params! */
+	if (in_place)
+		ret = LZ4_decompress_generic(in, out, b->size, space,
+					     endOnInputSize, full, 0, noDict,
+					     out, NULL, 0, inPlace);
+	else
+		ret = LZ4_decompress_generic(in, out, b->size, space,
+					     endOnInputSize, full, 0, noDict,
+					     out, NULL, 0, separateBuffers);
+	if (ret < 0)
+		return -EPROTO;		/* decompression error */
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(SMP_JOB)
+/**
+ * struct ulz4fn_job - A run of blocks decoded by one CPU
+ *
+ * Every block but the last in a frame is assumed to decode to exactly the
+ * maximum block size, which gives each block a fixed place in the output.
+ *
+ * @job:	Job decoding the blocks
+ * @in:		Header of the first block
+ * @out:	Output for the first block
+ * @end:	End of the output buffer
+ * @first:	Index of the first block
+ * @count:	Number of blocks to decode
+ * @last:	Index of the last block in the frame
+ * @block_size:	Maximum block size
+ * @has_block_checksum: true if each block is followed by a checksum
+ * @bad:	Returns the index of the first block which did not decode to
+ *		its expected size, or -1 if all did
+ */
+struct ulz4fn_job {
+	struct smp_job job;
+	const void *in;
+	void *out;
+	void *end;
+	int first;
+	int count;
+	int last;
+	size_t block_size;
+	int has_block_checksum;
+	int bad;
+};
+
+static int ulz4fn_job_run(void *arg)
+{
+	struct ulz4fn_job *j = arg;
+	const void *in = j->in;
+	void *out = j->out;
+	int i, ret;
+
+	for (i = j->first; i < j->first + j->count; i++) {
+		struct lz4_block_header b;
+		ptrdiff_t space = j->end - out;
+
+		b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(struct lz4_block_header);
+		if (i != j->last)
+			space = min(space, (ptrdiff_t)j->block_size);
+		ret = space < 0 ? -ENOBUFS :
+		      ulz4fn_block(in, &b, out, space, false);
+		if (ret < 0 || (i != j->last && ret != j->block_size)) {
+			j->bad = i;
+			return 0;
+		}
+		out += ret;
+		in += b.size;
+		if (j->has_block_checksum)
+			in += sizeof(u32);
+	}
+	j->bad = -1;
+	j->out = out;
+
+	return 0;
+}
+
+/*
+ * Step over @count blocks starting at @in, returning the header of the next
+ * one, or NULL if the input ends first. The end mark counts as a block.
+ */
+static const void *ulz4fn_skip(const void *src, size_t srcn, const void *in,
+			       int count, int has_block_checksum)
+{
+	while (count--) {
+		struct lz4_block_header b;
+
+		if (in - src + sizeof(b) > srcn)
+			return NULL;
+		b.raw = le32_to_cpu(*(u32 *)in);
+		in += sizeof(b);
+		if (in - src + b.size > srcn)
+			return NULL;
+		if (!b.size)
+			return in;
+		in += b.size;
+		if (has_block_checksum)
+			in += sizeof(u32);
+	}
+
+	return in;
+}
+
+/**
+ * ulz4fn_parallel() - Decode the blocks of a frame on several CPUs
+ *
+ * If some block does not decode to its expected place, e.g. because the
+ * frame uses blocks shorter than the maximum size, @inp and @outp are set to
+ * that block so that the caller can carry on one block at a time. The result
+ * is then the same as if all blocks were decoded in order.
+ *
+ * @return true if all blocks were decoded, false if the caller must decode
+ *	the frame from @inp and @outp
+ */
+static bool ulz4fn_parallel(const void *src, size_t srcn, const void **inp,
+			    void **outp, void *end, size_t block_size,
+			    int has_block_checksum)
+{
+	struct ulz4fn_job jobs[CONFIG_SMP_JOB_MAX_CPUS + 1];
+	const void *in = *inp;
+	int total, chunks, done, i, bad = -1;
+	const void *next;
+
+	/* Count the blocks, excluding the end mark */
+	for (total = 0, next = in; next; total++) {
+		if (next - src + sizeof(u32) > srcn)
+			return false;
+		if (!le32_to_cpu(*(u32 *)next))
+			break;
+		next = ulz4fn_skip(src, srcn, next, 1, has_block_checksum);
+	}
+	if (!next || total < 2)
+		return false;
+
+	chunks = min(total, smp_job_init() + 1);
+	if (chunks < 2)
+		return false;
+	for (i = 0, done = 0, next = in; i < chunks; i++) {
+		struct ulz4fn_job *j = &jobs[i];
+
+		j->first = done;
+		j->count = (total - done) / (chunks - i);
+		j->in = next;
+		j->out = *outp + done * block_size;
+		j->end = end;
+		j->last = total - 1;
+		j->block_size = block_size;
+		j->has_block_checksum = has_block_checksum;
+		smp_job_queue(&j->job, ulz4fn_job_run, j);
+
+		done += j->count;
+		next = ulz4fn_skip(src, srcn, next, j->count,
+				   has_block_checksum);
+	}
+	for (i = 0; i < chunks; i++) {
+		smp_job_wait(&jobs[i].job);
+		if (bad == -1)
+			bad = jobs[i].bad;
+	}
+
+	if (bad != -1) {
+		*inp = ulz4fn_skip(src, srcn, in, bad, has_block_checksum);
+		*outp += bad * block_size;
+		return false;
+	}
+	*outp = jobs[chunks - 1].out;
+
+	return true;
+}
+#endif
+
+/*
+ * The legacy format made by 'lz4 -l', as used for Linux initramfs images, is
+ * the magic number followed by compressed blocks, each preceded by its size.
+ * A new magic number may start another stream.
+ */
+static int ulz4fn_legacy(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const void *in = src + sizeof(u32);
+	void *end = dst + *dstn;
+	void *out = dst;
+	bool in_place = src < end && dst < src + srcn;
+	int ret = 0;
+
+	while (src + srcn - in >= sizeof(u32)) {
+		struct lz4_block_header b;
+		u32 size = le32_to_cpu(*(u32 *)in);
+
+		in += sizeof(u32);
+		if (size == LZ4_LEGACY_MAGIC)
+			continue;
+		if (!size)
+			break;		/* padding after the last block */
+		if (size > src + srcn - in || size >= 1U << 31) {
+			ret = -EINVAL;	/* input overrun */
+			break;
+		}
+
+		b.raw = 0;
+		b.size = size;
+		ret = ulz4fn_block(in, &b, out, end - out, in_place);
+		if (ret < 0)
+			break;
+		out += ret;
+		in += size;
+		ret = 0;
+	}
+
+	*dstn = out - dst;
+	return ret;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
-	const void *end = dst + *dstn;
+	void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
+	size_t block_size = 0;
 	int has_block_checksum;
+	bool in_place;
 	int ret;
 	*dstn = 0;
 
+	if (srcn >= sizeof(u32) &&
+	    le32_to_cpu(*(u32 *)src) == LZ4_LEGACY_MAGIC) {
+		*dstn = end - dst;
+		return ulz4fn_legacy(src, srcn, dst, dstn);
+	}
+
 	{ /* With in-place decompression the header may become invalid later. */
 		const struct lz4_frame_header *h = in;
 
@@ -86,6 +333,8 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		if (!h->independent_blocks)
 			return -EPROTONOSUPPORT; /* we can't support this yet */
 		has_block_checksum = h->has_block_checksum;
+		if (h->max_block_size >= 4)
+			block_size = 1 << (8 + 2 * h->max_block_size);
 
 		in += sizeof(*h);
 		if (h->has_content_size)
@@ -93,6 +342,17 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
+	in_place = src < end && dst < src + srcn;
+#if CONFIG_IS_ENABLED(SMP_JOB)
+	/* Blocks are independent, so can be decoded on several CPUs */
+	if (!in_place && block_size &&
+	    ulz4fn_parallel(src, srcn, &in, &out, end, block_size,
+			    has_block_checksum)) {
+		*dstn = out - dst;
+		return 0;
+	}
+#endif
+
 	while (1) {
 		struct lz4_block_header b;
 
@@ -109,25 +369,10 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			break;
 		}
 
-		if (b.not_compressed) {
-			size_t size = min((ptrdiff_t)b.size, end - out);
-			memcpy(out, in, size);
-			out += size;
-			if (size < b.size) {
-				ret = -ENOBUFS;	/* output overrun */
-				break;
-			}
-		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, b.size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
-				break;
-			}
-			out += ret;
-		}
+		ret = ulz4fn_block(in, &b, out, end - out, in_place);
+		if (ret < 0)
+			break;
+		out += ret;
 
 		in += b.size;
 		if (has_block_checksum)
@@ -251,7 +251,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 }
 
 /**
- * unflatten_device_tree() - create tree of device_nodes from flat blob
+ * of_live_unflatten() - create tree of device_nodes from flat blob
  *
  * unflattens a device-tree, creating the
  * tree of struct device_node. It also fills the "name" and "type"
@@ -261,8 +261,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
  * @mynodes: The device_node tree created by the call
  * @return 0 if OK, -ve on error
  */
-static int unflatten_device_tree(const void *blob,
-				 struct device_node **mynodes)
+int of_live_unflatten(const void *blob, struct device_node **mynodes)
 {
 	unsigned long size;
 	int start;
@@ -297,6 +296,8 @@ static int unflatten_device_tree(const void *blob,
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
@@ -322,7 +323,7 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 	int ret;
 
 	debug("%s: start\n", __func__);
-	ret = unflatten_device_tree(fdt_blob, rootp);
+	ret = of_live_unflatten(fdt_blob, rootp);
 	if (ret) {
 		debug("Failed to create live tree: err=%d\n", ret);
 		return ret;
@@ -332,7 +333,11 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
 		return ret;
 	}
+	/* Without the table, phandles are found by walking the tree */
+	ret = of_phandle_scan(*rootp);
+	if (ret)
+		debug("Failed to scan live tree phandles: err=%d\n", ret);
 	debug("%s: stop\n", __func__);
 
-	return ret;
+	return 0;
 }
@@ -66,7 +66,7 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+static void sha1_process_one(sha1_context *ctx, const unsigned char data[64])
 {
 	unsigned long temp, W[16], A, B, C, D, E;
 
@@ -220,6 +220,28 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+void sha1_transform_generic(sha1_context *ctx, const unsigned char *data,
+			    unsigned int blocks)
+{
+	while (blocks--) {
+		sha1_process_one(ctx, data);
+		data += 64;
+	}
+}
+
+/*
+ * When the ARMv8 Crypto Extensions are enabled, arch code provides
+ * sha1_transform() and falls back to the generic version at run time if
+ * the CPU lacks them.
+ */
+#if !defined(CONFIG_ARMV8_CE_SHA1) || defined(USE_HOSTCC)
+void sha1_transform(sha1_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	sha1_transform_generic(ctx, data, blocks);
+}
+#endif
+
 /*
  * SHA-1 process buffer
  */
@@ -243,16 +265,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_transform(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_transform(ctx, input, ilen / 64);
+		input += ilen & ~0x3f;
+		ilen &= 0x3f;
 	}
 
 	if (ilen > 0) {
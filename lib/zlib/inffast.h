@@ -8,4 +8,13 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* U-Boot: minimum input and output space for inflate() to call inflate_fast() */
+#if CONFIG_IS_ENABLED(ZLIB_INFFAST64)
+#  define INFLATE_FAST_MIN_HAVE 8
+#  define INFLATE_FAST_MIN_LEFT 266
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
 void inflate_fast OF((z_streamp strm, unsigned start));
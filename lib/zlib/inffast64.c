@@ -0,0 +1,305 @@
+/* inffast64.c -- fast decoding with a 64-bit bit buffer
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/*
+ * U-Boot: this replaces inffast.c when CONFIG_ZLIB_INFFAST64 is enabled. It
+ * differs from it in three ways:
+ *
+ * - The bit buffer is refilled with a single 64-bit load at the top of each
+ *   loop, which always leaves enough bits for a whole length/distance pair
+ * - Matches are copied 8 bytes at a time, or as a repeated 8-byte pattern for
+ *   distances below 8. This may write up to 7 bytes past the end of a match,
+ *   so inflate() only calls this with INFLATE_FAST_MIN_LEFT bytes of space
+ * - For zlib and gzip streams the check value is brought up to date every
+ *   INFLATE_FAST_CHECK_SIZE bytes, while the output is still in the cache,
+ *   rather than in a second pass over the whole output in inflate()
+ *
+ * Unaligned 64-bit accesses must be allowed, and the CPU must be
+ * little-endian.
+ */
+
+/* Output bytes between updates of the check value */
+#define INFLATE_FAST_CHECK_SIZE	4096
+
+static inline u64 inflate_fast_load64(const unsigned char *p)
+{
+    return le64_to_cpu(*(const u64 *)p);
+}
+
+/* Bring state->check up to @out, see inflate() */
+static inline void inflate_fast_check(struct inflate_state FAR *state,
+                                      unsigned char FAR *out)
+{
+    unsigned len = out - state->checked;
+
+    if (state->wrap && len) {
+#ifdef GUNZIP
+        if (state->flags)
+            state->check = crc32(state->check, state->checked, len);
+        else
+#endif
+            state->check = adler32(state->check, state->checked, len);
+    }
+    state->checked = out;
+}
+
+/*
+ * Copy @len bytes from @dist bytes back in the output. The source may overlap
+ * the destination. Up to 7 bytes past out + len may be written.
+ */
+static inline unsigned char FAR *inflate_fast_copy(unsigned char FAR *out,
+                                                   unsigned dist, unsigned len)
+{
+    const unsigned char FAR *from = out - dist;
+    unsigned char FAR *end = out + len;
+
+    if (dist >= 8) {
+        do {
+            *(u64 *)out = *(const u64 *)from;
+            out += 8;
+            from += 8;
+        } while (out < end);
+    } else {
+        /* Repeat the pattern, stepping by a whole number of periods */
+        unsigned step = 8 - 8 % dist;
+        u64 pat = 0;
+        unsigned i;
+
+        for (i = 0; i < 8; i++)
+            pat |= (u64)from[i % dist] << (i * 8);
+        do {
+            *(u64 *)out = cpu_to_le64(pat);
+            out += step;
+        } while (out < end);
+    }
+
+    return end;
+}
+
+/*
+   Decode literal, length, and distance codes and write out the resulting
+   literal and match bytes until either not enough input or output is
+   available, an end-of-block is encountered, or a data error is encountered.
+
+   Entry assumptions:
+
+        state->mode == LEN
+        strm->avail_in >= INFLATE_FAST_MIN_HAVE
+        strm->avail_out >= INFLATE_FAST_MIN_LEFT
+        start >= strm->avail_out
+        state->bits < 8
+
+   On return, state->mode is one of:
+
+        LEN -- ran out of enough output space or enough available input
+        TYPE -- reached end of block code, inflate() to interpret next block
+        BAD -- error in block data
+
+   Notes:
+
+    - The maximum input bits used by a length/distance pair is 48 bits. After
+      the refill at the top of the loop there are at least 56 bits in hold, so
+      no further input is needed until the next loop. The refill reads 8
+      bytes, so the loop stops when fewer than 8 bytes of input remain.
+
+    - The maximum bytes that a single length/distance pair can output is 258
+      bytes, plus up to 7 bytes written past the match by the chunked copies.
+ */
+void inflate_fast(z_streamp strm, unsigned start)
+/* start: inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    u64 hold;                   /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - 7);
+    if (last < in) {
+        /*
+         * overflow detected, limit strm->avail_in to the
+         * max. possible size and recalculate last
+         */
+        strm->avail_in = (uintptr_t)-1 - (uintptr_t)in;
+        last = in + (strm->avail_in - 7);
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        /*
+         * Top up to 56-63 bits. Bits of hold above 'bits' are either zero
+         * or already hold the bytes at 'in', so or-ing is safe.
+         */
+        hold |= inflate_fast_load64(in) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    /* the window never overlaps the output */
+                    if (write == 0) {           /* very common case */
+                        from = window + wsize - op;
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from = window + wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            memcpy(out, from, op);
+                            out += op;
+                            len -= op;
+                            from = window;
+                            op = write;
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from = window + write - op;
+                    }
+                    if (op < len) {             /* rest from output */
+                        memcpy(out, from, op);
+                        out += op;
+                        out = inflate_fast_copy(out, dist, len - op);
+                    }
+                    else {
+                        memcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else {
+                    out = inflate_fast_copy(out, dist, len);
+                }
+                if (out - state->checked >= INFLATE_FAST_CHECK_SIZE)
+                    inflate_fast_check(state, out);
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+    inflate_fast_check(state, out);
+
+    /* return unused bytes (on entry, bits < 8, so in won't go too far back) */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1U << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ? 7 + (last - in) : 7 - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
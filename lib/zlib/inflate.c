@@ -355,6 +355,7 @@ int ZEXPORT inflate(z_streamp strm, int flush)
     LOAD();
     in = have;
     out = left;
+    state->checked = put;
     ret = Z_OK;
     for (;;)
         switch (state->mode) {
@@ -722,7 +723,7 @@ int ZEXPORT inflate(z_streamp strm, int flush)
             state->mode = LEN;
         case LEN:
 	    WATCHDOG_RESET();
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_HAVE && left >= INFLATE_FAST_MIN_LEFT) {
                 RESTORE();
                 inflate_fast(strm, out);
                 LOAD();
@@ -856,7 +857,9 @@ int ZEXPORT inflate(z_streamp strm, int flush)
                 state->total += out;
                 if (out)
                     strm->adler = state->check =
-                        UPDATE(state->check, put - out, out);
+                        UPDATE(state->check, state->checked,
+                               put - state->checked);
+                state->checked = put;
                 out = left;
                 if ((
 #ifdef GUNZIP
@@ -918,7 +921,8 @@ int ZEXPORT inflate(z_streamp strm, int flush)
     state->total += out;
     if (state->wrap && out)
         strm->adler = state->check =
-            UPDATE(state->check, strm->next_out - out, out);
+            UPDATE(state->check, state->checked,
+                   strm->next_out - state->checked);
     strm->data_type = state->bits + (state->last ? 64 : 0) +
                       (state->mode == TYPE ? 128 : 0);
     if (((in == 0 && out == 0) || flush == Z_FINISH) && ret == Z_OK)
@@ -0,0 +1,229 @@
+/*
+ * Benchmark for looking up drivers and phandles when binding a device tree
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <of_live.h>
+#include <dm/lists.h>
+#include <dm/of_access.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of times to repeat each pass, to get a measurable time */
+#define BIND_UT_LOOPS	100
+
+/* Find a driver by checking each one in turn, as binding used to */
+static struct driver *bind_ut_linear(const char *compat,
+				     const struct udevice_id **of_idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *of_id;
+	struct driver *entry;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_id = entry->of_match; of_id && of_id->compatible;
+		     of_id++) {
+			if (!strcmp(of_id->compatible, compat)) {
+				*of_idp = of_id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static struct device_node *bind_ut_phandle_linear(phandle handle)
+{
+	struct device_node *np;
+
+	for_each_of_allnodes(np) {
+		if (np->phandle == handle)
+			return np;
+	}
+
+	return NULL;
+}
+
+/*
+ * Look up the driver for each node in @root the way lists_bind_fdt() does,
+ * stopping at the first compatible string with a driver
+ */
+static int bind_ut_match(struct device_node *root, bool linear)
+{
+	const struct udevice_id *of_id;
+	const char *compat, *end;
+	struct device_node *np;
+	struct property *prop;
+	struct driver *drv;
+	int matches = 0;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		prop = of_find_property(np, "compatible", NULL);
+		if (!prop)
+			continue;
+		end = prop->value + prop->length;
+		for (compat = prop->value; compat < end;
+		     compat += strlen(compat) + 1) {
+			if (linear)
+				drv = bind_ut_linear(compat, &of_id);
+			else
+				drv = lists_driver_lookup_compat(compat,
+								 &of_id);
+			if (drv) {
+				matches++;
+				break;
+			}
+		}
+	}
+
+	return matches;
+}
+
+/* Check that the index finds the same driver as a linear search */
+static int bind_ut_check(struct device_node *root, int *compatsp)
+{
+	const struct udevice_id *lin_id, *idx_id;
+	struct driver *lin, *idx;
+	const char *compat, *end;
+	struct device_node *np;
+	struct property *prop;
+
+	*compatsp = 0;
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle && bind_ut_phandle_linear(np->phandle) !=
+		    of_find_node_by_phandle(np->phandle)) {
+			printf("%s: phandle %#x of '%s' mismatch\n", __func__,
+			       np->phandle, np->full_name);
+			return -EINVAL;
+		}
+		prop = of_find_property(np, "compatible", NULL);
+		if (!prop)
+			continue;
+		end = prop->value + prop->length;
+		for (compat = prop->value; compat < end;
+		     compat += strlen(compat) + 1) {
+			lin = bind_ut_linear(compat, &lin_id);
+			idx = lists_driver_lookup_compat(compat, &idx_id);
+			if (lin != idx || (lin && lin_id != idx_id)) {
+				printf("%s: '%s' found %s, expected %s\n",
+				       __func__, compat, idx ? idx->name : "-",
+				       lin ? lin->name : "-");
+				return -EINVAL;
+			}
+			(*compatsp)++;
+		}
+	}
+
+	return 0;
+}
+
+/* Look up the phandle of every node, returning the number found */
+static int bind_ut_phandles(struct device_node *root, bool linear)
+{
+	struct device_node *np;
+	int found = 0;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (!np->phandle)
+			continue;
+		if (linear)
+			found += bind_ut_phandle_linear(np->phandle) == np;
+		else
+			found += of_find_node_by_phandle(np->phandle) == np;
+	}
+
+	return found;
+}
+
+static int bind_ut_run(struct device_node *root)
+{
+	ulong start, lin_us, idx_us;
+	int compats, matches, found;
+	int i, ret;
+
+	ret = bind_ut_check(root, &compats);
+	if (ret)
+		return ret;
+
+	start = timer_get_us();
+	for (i = 0; i < BIND_UT_LOOPS; i++)
+		matches = bind_ut_match(root, true);
+	lin_us = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < BIND_UT_LOOPS; i++)
+		bind_ut_match(root, false);
+	idx_us = timer_get_us() - start;
+	printf("Drivers: %d compatible strings, %d nodes matched, linear %lu us, indexed %lu us\n",
+	       compats, matches, lin_us / BIND_UT_LOOPS,
+	       idx_us / BIND_UT_LOOPS);
+
+	/* Only an index made at build time can be used before relocation */
+	gd->flags &= ~GD_FLG_RELOC;
+	start = timer_get_us();
+	for (i = 0; i < BIND_UT_LOOPS; i++)
+		bind_ut_match(root, false);
+	idx_us = timer_get_us() - start;
+	gd->flags |= GD_FLG_RELOC;
+	printf("Drivers before relocation: %lu us\n", idx_us / BIND_UT_LOOPS);
+
+	start = timer_get_us();
+	for (i = 0; i < BIND_UT_LOOPS; i++)
+		found = bind_ut_phandles(root, true);
+	lin_us = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < BIND_UT_LOOPS; i++)
+		bind_ut_phandles(root, false);
+	idx_us = timer_get_us() - start;
+	printf("Phandles: %d, linear %lu us, table %lu us\n", found,
+	       lin_us / BIND_UT_LOOPS, idx_us / BIND_UT_LOOPS);
+
+	return 0;
+}
+
+int do_ut_bind(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	const void *blob = gd->fdt_blob;
+	struct device_node *root, *old_root;
+	ulong start, unflatten_us, scan_us;
+	int ret;
+
+	if (argc > 1)
+		blob = map_sysmem(simple_strtoul(argv[1], NULL, 16), 0);
+
+	start = timer_get_us();
+	ret = of_live_unflatten(blob, &root);
+	unflatten_us = timer_get_us() - start;
+	if (ret) {
+		printf("Cannot unflatten tree: err=%d\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	/* Phandle lookups use the tree at gd->of_root */
+	old_root = gd->of_root;
+	gd->of_root = root;
+	start = timer_get_us();
+	ret = of_phandle_scan(root);
+	scan_us = timer_get_us() - start;
+	printf("Tree: %u bytes, unflatten %lu us, phandle scan %lu us\n",
+	       fdt_totalsize(blob), unflatten_us, scan_us);
+	if (!ret)
+		ret = bind_ut_run(root);
+
+	gd->of_root = old_root;
+	if (old_root)
+		of_phandle_scan(old_root);
+	free(root);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -13,15 +13,30 @@ static int do_ut_all(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 static cmd_tbl_t cmd_ut_sub[] = {
 	U_BOOT_CMD_MKENT(all, CONFIG_SYS_MAXARGS, 1, do_ut_all, "", ""),
+#ifdef CONFIG_UT_BIND
+	U_BOOT_CMD_MKENT(bind, CONFIG_SYS_MAXARGS, 1, do_ut_bind, "", ""),
+#endif
 #if defined(CONFIG_UT_DM)
 	U_BOOT_CMD_MKENT(dm, CONFIG_SYS_MAXARGS, 1, do_ut_dm, "", ""),
 #endif
 #if defined(CONFIG_UT_ENV)
 	U_BOOT_CMD_MKENT(env, CONFIG_SYS_MAXARGS, 1, do_ut_env, "", ""),
 #endif
+#ifdef CONFIG_UT_HUSH
+	U_BOOT_CMD_MKENT(hush, CONFIG_SYS_MAXARGS, 1, do_ut_hush, "", ""),
+#endif
+#ifdef CONFIG_UT_MEM
+	U_BOOT_CMD_MKENT(mem, CONFIG_SYS_MAXARGS, 1, do_ut_mem, "", ""),
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	U_BOOT_CMD_MKENT(overlay, CONFIG_SYS_MAXARGS, 1, do_ut_overlay, "", ""),
 #endif
+#ifdef CONFIG_UT_SMP_JOB
+	U_BOOT_CMD_MKENT(smp_job, CONFIG_SYS_MAXARGS, 1, do_ut_smp_job, "", ""),
+#endif
+#ifdef CONFIG_UT_SPL_FIT
+	U_BOOT_CMD_MKENT(spl_fit, CONFIG_SYS_MAXARGS, 1, do_ut_spl_fit, "", ""),
+#endif
 #ifdef CONFIG_UT_TIME
 	U_BOOT_CMD_MKENT(time, CONFIG_SYS_MAXARGS, 1, do_ut_time, "", ""),
 #endif
@@ -65,15 +80,31 @@ static int do_ut(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #ifdef CONFIG_SYS_LONGHELP
 static char ut_help_text[] =
 	"all - execute all enabled tests\n"
+#ifdef CONFIG_UT_BIND
+	"ut bind [fdt_addr] - Time driver and phandle lookups for a tree\n"
+#endif
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
 #endif
 #ifdef CONFIG_UT_ENV
 	"ut env [test-name]\n"
 #endif
+#ifdef CONFIG_UT_HUSH
+	"ut hush [loops] - Check and time scripts kept parsed\n"
+#endif
+#ifdef CONFIG_UT_MEM
+	"ut mem [seed] - Check memcpy, memmove and memset\n"
+	"ut mem bench [size [iterations]] - Time memcpy, memmove and memset\n"
+#endif
 #ifdef CONFIG_UT_OVERLAY
 	"ut overlay [test-name]\n"
 #endif
+#ifdef CONFIG_UT_SMP_JOB
+	"ut smp_job - Check running jobs on secondary CPUs\n"
+#endif
+#ifdef CONFIG_UT_SPL_FIT
+	"ut spl_fit - Check reading FIT images in one pass\n"
+#endif
 #ifdef CONFIG_UT_TIME
 	"ut time - Very basic test of time functions\n"
 #endif
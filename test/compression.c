@@ -9,9 +9,11 @@
 #include <common.h>
 #include <bootm.h>
 #include <command.h>
+#include <gzip.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/zlib.h>
 #include <bzlib.h>
@@ -371,16 +373,593 @@ out:
 	return ret;
 }
 
+/*
+ * LZ4 conformance test
+ *
+ * Frames are built from sequences chosen to reach every copy path in the
+ * decoder: match offsets of 1 to 20 bytes, which overlap the output being
+ * written, and long offsets up to 64KB, with lengths from 4 to 300 bytes.
+ * The expected output is produced a byte at a time while encoding.
+ */
+#define LZ4_TEST_BLOCK_SIZE	(256 << 10)
+#define LZ4_TEST_MAX_BLOCKS	8
+
+#define LZ4_TEST_STORED		(1 << 0)	/* block is not compressed */
+
+#define LZ4_TEST_CHECKSUM	(1 << 0)	/* frame has block checksums */
+#define LZ4_TEST_CONTENT_SIZE	(1 << 1)	/* frame has the content size */
+
+struct lz4_test_block {
+	int size;
+	int flags;
+};
+
+static uint lz4_test_rand(uint *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+
+	return *seed >> 16;
+}
+
+static u8 *lz4_test_put_len(u8 *p, int len)
+{
+	for (len -= 15; len >= 255; len -= 255)
+		*p++ = 255;
+	*p++ = len;
+
+	return p;
+}
+
+static u8 *lz4_test_put_seq(u8 *p, const u8 *lit, int lit_len, int offset,
+			    int match_len)
+{
+	u8 *token = p++;
+
+	*token = min(lit_len, 15) << 4;
+	if (lit_len >= 15)
+		p = lz4_test_put_len(p, lit_len);
+	memcpy(p, lit, lit_len);
+	p += lit_len;
+	if (!match_len)
+		return p;	/* last literals */
+
+	*token |= min(match_len - 4, 15);
+	*p++ = offset;
+	*p++ = offset >> 8;
+	if (match_len - 4 >= 15)
+		p = lz4_test_put_len(p, match_len - 4);
+
+	return p;
+}
+
+/* Encode a block of @size bytes, writing the expected output to @ref */
+static int lz4_test_gen_block(u8 *out, u8 *ref, int size, uint *seed)
+{
+	static const int offsets[] = {
+		1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+		19, 20, 100, 65535,
+	};
+	int pos = 0, lit_len, match_len, offset, i;
+	u8 *p = out;
+
+	while (1) {
+		lit_len = lz4_test_rand(seed) % 20;
+		if (!(lz4_test_rand(seed) % 16))
+			lit_len = 300;
+		match_len = 4 + lz4_test_rand(seed) % 60;
+		if (!(lz4_test_rand(seed) % 16))
+			match_len = 300;
+		offset = offsets[lz4_test_rand(seed) % ARRAY_SIZE(offsets)];
+
+		/* The last 12 bytes of a block must be literals */
+		if (pos + lit_len + match_len > size - 12)
+			break;
+		if (!pos && !lit_len)
+			lit_len = 1;
+		if (offset > pos + lit_len)
+			offset = 1 + lz4_test_rand(seed) % (pos + lit_len);
+
+		for (i = 0; i < lit_len; i++)
+			ref[pos++] = lz4_test_rand(seed);
+		p = lz4_test_put_seq(p, ref + pos - lit_len, lit_len, offset,
+				     match_len);
+		for (i = 0; i < match_len; i++, pos++)
+			ref[pos] = ref[pos - offset];
+	}
+
+	lit_len = size - pos;
+	for (i = 0; i < lit_len; i++)
+		ref[pos++] = lz4_test_rand(seed);
+	p = lz4_test_put_seq(p, ref + pos - lit_len, lit_len, 0, 0);
+
+	return p - out;
+}
+
+/*
+ * Build a frame from @count blocks, writing the expected output to @ref. The
+ * header and block checksums are not checked by ulz4fn() so are left as zero.
+ *
+ * @return size of the frame in bytes
+ */
+static ulong lz4_test_gen_frame(u8 *out, u8 *ref, ulong *ref_len,
+				const struct lz4_test_block *blocks, int count,
+				int flags, uint seed)
+{
+	ulong total = 0;
+	u8 *p = out;
+	int i, j;
+
+	for (i = 0; i < count; i++)
+		total += blocks[i].size;
+
+	put_unaligned_le32(0x184d2204, p);
+	p += 4;
+	*p++ = 0x40 | 0x20 | (flags & LZ4_TEST_CHECKSUM ? 0x10 : 0) |
+	       (flags & LZ4_TEST_CONTENT_SIZE ? 0x08 : 0);
+	*p++ = 5 << 4;		/* 256KB blocks */
+	if (flags & LZ4_TEST_CONTENT_SIZE) {
+		put_unaligned_le64(total, p);
+		p += 8;
+	}
+	*p++ = 0;
+
+	for (i = 0, *ref_len = 0; i < count; i++) {
+		const struct lz4_test_block *b = &blocks[i];
+		u8 *hdr = p;
+		int size;
+
+		p += 4;
+		if (b->flags & LZ4_TEST_STORED) {
+			for (j = 0; j < b->size; j++)
+				ref[*ref_len + j] = lz4_test_rand(&seed);
+			memcpy(p, ref + *ref_len, b->size);
+			size = b->size;
+			put_unaligned_le32(size | 0x80000000, hdr);
+		} else {
+			size = lz4_test_gen_block(p, ref + *ref_len, b->size,
+						  &seed);
+			put_unaligned_le32(size, hdr);
+		}
+		p += size;
+		*ref_len += b->size;
+		if (flags & LZ4_TEST_CHECKSUM) {
+			put_unaligned_le32(0, p);
+			p += 4;
+		}
+	}
+	put_unaligned_le32(0, p);	/* end mark */
+	p += 4;
+
+	return p - out;
+}
+
+static int run_lz4_frame_test(const char *name,
+			      const struct lz4_test_block *blocks, int count,
+			      int flags)
+{
+	const ulong max_size = LZ4_TEST_BLOCK_SIZE * LZ4_TEST_MAX_BLOCKS;
+	u8 *frame = NULL, *ref = NULL, *out = NULL;
+	ulong frame_size, ref_len, margin, start;
+	size_t size;
+	int ret;
+
+	printf(" testing lz4 %s ...\n", name);
+	frame = malloc(max_size + max_size / 8);
+	errcheck(frame != NULL);
+	ref = malloc(max_size);
+	errcheck(ref != NULL);
+	/* Room for an in-place copy of the frame after the output */
+	out = malloc(max_size * 2 + max_size / 8);
+	errcheck(out != NULL);
+
+	frame_size = lz4_test_gen_frame(frame, ref, &ref_len, blocks, count,
+					flags, 0x1234);
+	printf("\tframe_size:%lu ref_len:%lu\n", frame_size, ref_len);
+
+	/* Separate buffers, with space remaining */
+	memset(out, 'A', ref_len + 1);
+	size = ref_len + 1;
+	start = timer_get_us();
+	errcheck(ulz4fn(frame, frame_size, out, &size) == 0);
+	printf("\tdecoded in %lu us\n", timer_get_us() - start);
+	errcheck(size == ref_len);
+	errcheck(memcmp(ref, out, ref_len) == 0);
+	errcheck(out[ref_len] == 'A');
+
+	/* Exactly the right size */
+	memset(out, 'A', ref_len + 1);
+	size = ref_len;
+	errcheck(ulz4fn(frame, frame_size, out, &size) == 0);
+	errcheck(size == ref_len);
+	errcheck(memcmp(ref, out, ref_len) == 0);
+	errcheck(out[ref_len] == 'A');
+
+	/* One byte short */
+	memset(out, 'A', ref_len + 1);
+	size = ref_len - 1;
+	errcheck(ulz4fn(frame, frame_size, out, &size) != 0);
+	errcheck(out[ref_len - 1] == 'A');
+	printf("\tuncompress does not overrun\n");
+
+	/*
+	 * In place, with the frame at the end of the output buffer. Each
+	 * stored block needs room for its header and checksum.
+	 */
+	margin = (frame_size >> 8) + 32 + 8 * count + 16;
+	memset(out, 'A', ref_len + margin);
+	memcpy(out + ref_len + margin - frame_size, frame, frame_size);
+	size = ref_len;
+	errcheck(ulz4fn(out + ref_len + margin - frame_size, frame_size, out,
+			&size) == 0);
+	errcheck(size == ref_len);
+	errcheck(memcmp(ref, out, ref_len) == 0);
+	printf("\tin-place uncompress ok\n");
+
+	ret = 0;
+out:
+	printf(" lz4 %s: %s\n", name, ret == 0 ? "ok" : "FAILED");
+	free(out);
+	free(ref);
+	free(frame);
+
+	return ret;
+}
+
+/* Check that bad input is rejected rather than read or written out of range */
+static int run_lz4_error_test(void)
+{
+	static const u8 lit[8] = "abcdefgh";
+	u8 frame[64], out[64], *p;
+	size_t size;
+	int ret;
+
+	printf(" testing lz4 errors ...\n");
+	p = frame;
+	put_unaligned_le32(0x184d2204, p);
+	p += 4;
+	*p++ = 0x60;
+	*p++ = 4 << 4;
+	*p++ = 0;
+	p += 4;
+	/* Match offset reaching before the start of the output */
+	p = lz4_test_put_seq(p, lit, 4, 5, 8);
+	p = lz4_test_put_seq(p, lit, 8, 0, 0);
+	put_unaligned_le32(p - frame - 11, frame + 7);
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	size = sizeof(out);
+	errcheck(ulz4fn(frame, p - frame, out, &size) != 0);
+
+	/* Truncated input */
+	size = sizeof(out);
+	errcheck(ulz4fn(frame, p - frame - 8, out, &size) != 0);
+
+	ret = 0;
+out:
+	printf(" lz4 errors: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+static int run_lz4_conformance(void)
+{
+	static const struct lz4_test_block full[] = {
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ LZ4_TEST_BLOCK_SIZE, LZ4_TEST_STORED },
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ 1000 },
+	};
+	/* Short blocks before the end cannot be placed in advance */
+	static const struct lz4_test_block short_blocks[] = {
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ 70000 },
+		{ LZ4_TEST_BLOCK_SIZE },
+		{ 5000, LZ4_TEST_STORED },
+		{ LZ4_TEST_BLOCK_SIZE },
+	};
+	static const struct lz4_test_block single[] = {
+		{ 100 },
+	};
+	int err = 0;
+
+	err += run_lz4_frame_test("blocks", full, ARRAY_SIZE(full),
+				  LZ4_TEST_CHECKSUM);
+	err += run_lz4_frame_test("content size", full, ARRAY_SIZE(full),
+				  LZ4_TEST_CONTENT_SIZE);
+	err += run_lz4_frame_test("short blocks", short_blocks,
+				  ARRAY_SIZE(short_blocks), 0);
+	err += run_lz4_frame_test("single block", single, ARRAY_SIZE(single),
+				  LZ4_TEST_CHECKSUM | LZ4_TEST_CONTENT_SIZE);
+	err += run_lz4_error_test();
+
+	return err;
+}
+
+#ifdef CONFIG_GZIP_STREAM
+#define GZIP_STREAM_TEST_SIZE	(3 << 20)
+
+struct gzip_stream_test {
+	const u8 *data;
+	ulong step;
+	int reads;
+};
+
+static long gzip_stream_test_read(struct gunzip_src *src, u64 offset,
+				  void *buf, ulong size)
+{
+	struct gzip_stream_test *test = src->priv;
+
+	size = min_t(u64, size, src->size - offset);
+	size = min(size, test->step);
+	memcpy(buf, test->data + offset, size);
+	test->reads++;
+
+	return size;
+}
+
+/* Decompress with reads of @step bytes, returning the gunzip_stream() result */
+static int gzip_stream_test_run(const u8 *data, ulong size, ulong step,
+				void *out, ulong out_size, ulong *lenp)
+{
+	struct gzip_stream_test test = { .data = data, .step = step };
+	struct gunzip_src src = {
+		.read = gzip_stream_test_read,
+		.size = size,
+		.priv = &test,
+	};
+
+	return gunzip_stream(&src, out, out_size, lenp);
+}
+
+static int run_gzip_stream_test(void)
+{
+	ulong orig_size = GZIP_STREAM_TEST_SIZE;
+	ulong gz_size, len, i;
+	u8 *orig = NULL, *gz = NULL, *out = NULL;
+	int ret;
+
+	printf(" testing gzip stream ...\n");
+	orig = malloc(orig_size);
+	errcheck(orig != NULL);
+	gz = malloc(orig_size);
+	errcheck(gz != NULL);
+	out = malloc(orig_size + 1);
+	errcheck(out != NULL);
+
+	/* Compressible, but spanning several chunks once compressed */
+	for (i = 0; i < orig_size; i++)
+		orig[i] = (i % 251) ^ (i * 2654435761U >> 27);
+	gz_size = orig_size;
+	errcheck(gzip(gz, &gz_size, orig, orig_size) == 0);
+	printf("\tcompressed_size:%lu\n", gz_size);
+	errcheck(gz_size > CONFIG_GZIP_STREAM_CHUNK);
+
+	/* Whole chunks, then reads which split the header and trailer */
+	errcheck(gzip_stream_test_run(gz, gz_size, ~0UL, out, orig_size + 1,
+				      &len) == 0);
+	errcheck(len == orig_size);
+	errcheck(memcmp(orig, out, orig_size) == 0);
+	memset(out, '\0', orig_size);
+	errcheck(gzip_stream_test_run(gz, gz_size, 5, out, orig_size,
+				      &len) == 0);
+	errcheck(len == orig_size);
+	errcheck(memcmp(orig, out, orig_size) == 0);
+
+	/* Trailing data after the stream is not read */
+	errcheck(gzip_stream_test_run(gz, orig_size, ~0UL, out, orig_size,
+				      &len) == 0);
+	errcheck(len == orig_size);
+
+	/* Output too small */
+	memset(out, 'A', orig_size + 1);
+	errcheck(gzip_stream_test_run(gz, gz_size, ~0UL, out, orig_size - 1,
+				      &len) == -ENOSPC);
+	errcheck(out[orig_size - 1] == 'A');
+
+	/* Truncated input */
+	errcheck(gzip_stream_test_run(gz, gz_size - 4, ~0UL, out, orig_size,
+				      &len) == -EINVAL);
+
+	/* Bad CRC32 */
+	gz[gz_size - 8] ^= 1;
+	errcheck(gzip_stream_test_run(gz, gz_size, ~0UL, out, orig_size,
+				      &len) == -EINVAL);
+	gz[gz_size - 8] ^= 1;
+
+	/* Corrupt data */
+	gz[gz_size / 2] ^= 0xff;
+	errcheck(gzip_stream_test_run(gz, gz_size, ~0UL, out, orig_size,
+				      &len) != 0);
+
+	ret = 0;
+out:
+	printf(" gzip stream: %s\n", ret == 0 ? "ok" : "FAILED");
+	free(out);
+	free(gz);
+	free(orig);
+
+	return ret;
+}
+#endif
+
+/*
+ * Decompression benchmark. Without arguments this uses a generated corpus of
+ * text, machine code and random data, otherwise the given memory region, e.g.
+ * a kernel image.
+ */
+#define BENCH_PART_SIZE		(1 << 20)
+#define BENCH_LOOPS		5
+
+static void bench_fill_text(u8 *buf, ulong size, uint *seed)
+{
+	static const char *const words[] = {
+		"the ", "of ", "and ", "boot ", "kernel ", "image ", "device ",
+		"memory ", "U-Boot ", "partition ", "is ", "a ", "to ", "in ",
+		"loaded ", "from ", "with ", "block ", "\n", ", ", ". ",
+	};
+	const char *word;
+	ulong pos, len;
+
+	for (pos = 0; pos < size; pos += len) {
+		*seed = *seed * 1103515245 + 12345;
+		word = words[(*seed >> 16) % ARRAY_SIZE(words)];
+		len = min(strlen(word), size - pos);
+		memcpy(buf + pos, word, len);
+	}
+}
+
+/* Roughly the mix of repeated opcodes and varying operands in code */
+static void bench_fill_code(u8 *buf, ulong size, uint *seed)
+{
+	static const u32 ops[] = {
+		0xf9400000, 0xf9000000, 0x91000000, 0xaa0003e0, 0x94000000,
+		0xb4000000, 0x52800000, 0xd65f03c0, 0xa9bf7bfd, 0x910003fd,
+	};
+	ulong i;
+
+	for (i = 0; i + 4 <= size; i += 4) {
+		u32 insn;
+
+		*seed = *seed * 1103515245 + 12345;
+		insn = ops[(*seed >> 16) % ARRAY_SIZE(ops)];
+		if (insn != 0xd65f03c0)
+			insn |= (*seed >> 8) & 0x3ff;
+		put_unaligned_le32(insn, buf + i);
+	}
+}
+
+static void bench_fill_random(u8 *buf, ulong size, uint *seed)
+{
+	ulong i;
+
+	for (i = 0; i < size; i++) {
+		*seed = *seed * 1103515245 + 12345;
+		buf[i] = *seed >> 16;
+	}
+}
+
+#ifdef CONFIG_GZIP_STREAM
+static long bench_stream_read(struct gunzip_src *src, u64 offset, void *buf,
+			      ulong size)
+{
+	size = min_t(u64, size, src->size - offset);
+	memcpy(buf, src->priv + offset, size);
+
+	return size;
+}
+#endif
+
+/* Report the best time of BENCH_LOOPS runs as MB/s of output */
+static void bench_report(const char *what, ulong size, ulong best)
+{
+	printf("\t%-12s %5lu MB/s\n", what, size / max(best, 1UL));
+}
+
+static int run_gzip_bench(const char *name, u8 *data, ulong size)
+{
+	ulong gz_size = size + size / 8 + 1024;
+	ulong start, us, best, len;
+	u8 *gz = NULL, *out = NULL;
+	int i, ret;
+
+	gz = malloc(gz_size);
+	errcheck(gz != NULL);
+	out = malloc(size);
+	errcheck(out != NULL);
+	errcheck(gzip(gz, &gz_size, data, size) == 0);
+	printf(" %s: %lu bytes, gzip %lu bytes (%lu%%)\n", name, size, gz_size,
+	       gz_size * 100 / size);
+
+	for (i = 0, best = ~0UL; i < BENCH_LOOPS; i++) {
+		len = gz_size;
+		start = timer_get_us();
+		errcheck(gunzip(out, size, gz, &len) == 0);
+		us = timer_get_us() - start;
+		best = min(best, us);
+	}
+	errcheck(len == size && !memcmp(data, out, size));
+	bench_report("gunzip", size, best);
+
+#ifdef CONFIG_GZIP_STREAM
+	for (i = 0, best = ~0UL; i < BENCH_LOOPS; i++) {
+		struct gunzip_src src = {
+			.read = bench_stream_read,
+			.size = gz_size,
+			.priv = gz,
+		};
+
+		start = timer_get_us();
+		errcheck(gunzip_stream(&src, out, size, &len) == 0);
+		us = timer_get_us() - start;
+		best = min(best, us);
+	}
+	errcheck(len == size && !memcmp(data, out, size));
+	bench_report("stream+crc", size, best);
+#endif
+
+	ret = 0;
+out:
+	free(out);
+	free(gz);
+
+	return ret;
+}
+
+static int do_compression_bench(int argc, char *const argv[])
+{
+	ulong addr, size;
+	uint seed = 1;
+	u8 *buf;
+	int err = 0;
+
+	printf("inflate: %s\n", CONFIG_IS_ENABLED(ZLIB_INFFAST64) ?
+	       "64-bit fast path" : "portable");
+	if (argc > 2) {
+		addr = simple_strtoul(argv[1], NULL, 16);
+		size = simple_strtoul(argv[2], NULL, 16);
+		buf = map_sysmem(addr, size);
+		err = run_gzip_bench("memory", buf, size);
+		unmap_sysmem(buf);
+
+		return err;
+	}
+
+	buf = malloc(BENCH_PART_SIZE * 3);
+	if (!buf)
+		return -ENOMEM;
+	bench_fill_text(buf, BENCH_PART_SIZE, &seed);
+	bench_fill_code(buf + BENCH_PART_SIZE, BENCH_PART_SIZE, &seed);
+	bench_fill_random(buf + BENCH_PART_SIZE * 2, BENCH_PART_SIZE, &seed);
+	err += run_gzip_bench("text", buf, BENCH_PART_SIZE);
+	err += run_gzip_bench("code", buf + BENCH_PART_SIZE, BENCH_PART_SIZE);
+	err += run_gzip_bench("random", buf + BENCH_PART_SIZE * 2,
+			      BENCH_PART_SIZE);
+	err += run_gzip_bench("all", buf, BENCH_PART_SIZE * 3);
+	free(buf);
+
+	return err;
+}
+
 static int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			     char *const argv[])
 {
 	int err = 0;
 
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return do_compression_bench(argc - 1, argv + 1);
+
 	err += run_test("gzip", compress_using_gzip, uncompress_using_gzip);
 	err += run_test("bzip2", compress_using_bzip2, uncompress_using_bzip2);
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
 	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+	err += run_lz4_conformance();
+#ifdef CONFIG_GZIP_STREAM
+	err += run_gzip_stream_test();
+#endif
 
 	printf("ut_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -467,7 +1046,9 @@ static int do_ut_image_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
 
 U_BOOT_CMD(
 	ut_compression,	5,	1,	do_ut_compression,
-	"Basic test of compressors: gzip bzip2 lzma lzo", ""
+	"Basic test of compressors: gzip bzip2 lzma lzo",
+	"[bench [addr size]]\n"
+	"    - with 'bench', report gzip decompression speed instead"
 );
 
 U_BOOT_CMD(
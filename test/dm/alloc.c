@@ -0,0 +1,136 @@
+/*
+ * Tests for the driver model size-class allocator
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <asm/state.h>
+#include <dm/alloc.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * Unbind everything, then bind and probe all devices from platdata and the
+ * device tree, returning the counters and the peak heap use for that. The
+ * sandbox SPI state points at the old emulators, so it is reset as well.
+ */
+static int dm_alloc_probe_all(struct unit_test_state *uts, bool enable,
+			      struct dm_alloc_stats *stats, ulong *peak)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	ulong start;
+	int id;
+
+	for (id = UCLASS_ROOT + 1; id < UCLASS_COUNT; id++) {
+		uc = uclass_find(id);
+		if (uc)
+			ut_assertok(uclass_destroy(uc));
+	}
+	state_reset_for_test(state_get_current());
+
+	dm_alloc_set_enabled(enable);
+	dm_alloc_clear_stats();
+	dm_alloc_get_stats(stats);
+	start = stats->heap;
+
+	ut_assertok(dm_scan_platdata(false));
+	ut_assertok(dm_extended_scan_fdt(gd->fdt_blob, false));
+	for (id = UCLASS_ROOT + 1; id < UCLASS_COUNT; id++) {
+		uc = uclass_find(id);
+		if (!uc)
+			continue;
+		/* Some test devices are meant to fail, that is fine here */
+		uclass_foreach_dev(dev, uc)
+			device_probe(dev);
+	}
+
+	dm_alloc_get_stats(stats);
+	*peak = stats->heap_peak - start;
+	dm_alloc_set_enabled(true);
+
+	return 0;
+}
+
+/* Probing every device takes far fewer malloc() calls with size classes */
+static int dm_test_alloc_probe_all(struct unit_test_state *uts)
+{
+	struct dm_alloc_stats off, on;
+	ulong off_peak, on_peak;
+	int cls, objs = 0;
+
+	ut_assertok(dm_alloc_probe_all(uts, false, &off, &off_peak));
+	ut_assertok(dm_alloc_probe_all(uts, true, &on, &on_peak));
+	debug("malloc calls %lu -> %lu, heap peak %lu -> %lu bytes\n",
+	      off.mallocs, on.mallocs, off_peak, on_peak);
+
+	/* Nothing is served from pages while the classes are off */
+	ut_asserteq(off.large, off.mallocs);
+	ut_asserteq(0, off.pages);
+
+	for (cls = 0; cls < DM_ALLOC_CLASSES; cls++)
+		objs += on.allocs[cls];
+	ut_assert(objs > 0);
+	ut_asserteq(on.pages + on.large, on.mallocs);
+	ut_assert(on.mallocs * 4 < off.mallocs);
+	/*
+	 * Rounding up to a power of two costs more than the chunk headers
+	 * saved, but the heap should grow by no more than one partly used
+	 * page per size class
+	 */
+	ut_assert(on_peak < off_peak + DM_ALLOC_CLASSES * DM_ALLOC_PAGE_SIZE);
+
+	return 0;
+}
+DM_TEST(dm_test_alloc_probe_all, 0);
+
+/* Objects are zeroed, reused after free and pages go back when empty */
+static int dm_test_alloc_reuse(struct unit_test_state *uts)
+{
+	struct dm_alloc_stats stats;
+	void *ptr[4], *big;
+	char *buf;
+	int i;
+
+	dm_alloc_clear_stats();
+	for (i = 0; i < ARRAY_SIZE(ptr); i++) {
+		ptr[i] = dm_calloc(40);
+		ut_assertnonnull(ptr[i]);
+		memset(ptr[i], 0xaa, 40);
+	}
+	big = dm_calloc(DM_ALLOC_MAX + 1);
+	ut_assertnonnull(big);
+
+	dm_alloc_get_stats(&stats);
+	ut_asserteq(4, stats.allocs[2]);
+	ut_asserteq(1, stats.large);
+	ut_asserteq(4 * 24, stats.slot_bytes - stats.requested);
+
+	dm_free(ptr[1]);
+	buf = dm_calloc(33);
+	ut_assertnonnull(buf);
+	if (IS_ENABLED(CONFIG_DM_ALLOC_REUSE))
+		ut_asserteq_ptr(ptr[1], buf);
+	for (i = 0; i < 33; i++)
+		ut_asserteq(0, buf[i]);
+	ptr[1] = buf;
+
+	for (i = 0; i < ARRAY_SIZE(ptr); i++)
+		dm_free(ptr[i]);
+	dm_free(big);
+
+	dm_alloc_get_stats(&stats);
+	ut_asserteq(5, stats.frees[2]);
+	ut_asserteq(1, stats.large_freed);
+	ut_asserteq(stats.pages, stats.pages_freed);
+
+	return 0;
+}
+DM_TEST(dm_test_alloc_reuse, 0);
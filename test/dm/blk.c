@@ -6,6 +6,10 @@
 
 #include <common.h>
 #include <dm.h>
+#include <malloc.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -168,3 +172,110 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define PART_TEST_FILE	"part_cache.img"
+#define PART_TEST_SIZE	(1 << 20)
+/* Protective MBR, GPT header and entries, up to the first usable block */
+#define PART_TEST_GPT_BLKS	34
+
+static const char part_test_guid[] = "375a56f7-d6c9-4e81-b5f0-09d41ca89efe";
+
+static int part_test_write_gpt(struct unit_test_state *uts,
+			       struct blk_desc *desc, const char *last_name)
+{
+	static const char *const names[] = { "boot", "system", "misc" };
+	disk_partition_t parts[3];
+	int i;
+
+	memset(parts, '\0', sizeof(parts));
+	for (i = 0; i < ARRAY_SIZE(parts); i++) {
+		parts[i].start = 64 + i * 256;
+		parts[i].size = 256;
+		strcpy((char *)parts[i].name, i == 2 ? last_name : names[i]);
+		sprintf(parts[i].uuid, "%.35s%d", part_test_guid, i);
+	}
+	ut_assertok(gpt_restore(desc, (char *)part_test_guid, parts,
+				ARRAY_SIZE(parts)));
+
+	return 0;
+}
+
+/* Test that partition lookups only read the partition table once */
+static int dm_test_blk_part_cache(struct unit_test_state *uts)
+{
+	struct host_block_dev *host_dev;
+	disk_partition_t info;
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char block[512];
+	ulong reads;
+	char *buf, *gpt;
+	int fd;
+
+	/* Create an empty disk image */
+	buf = calloc(1, PART_TEST_SIZE);
+	ut_assertnonnull(buf);
+	fd = os_open(PART_TEST_FILE, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(PART_TEST_SIZE, os_write(fd, buf, PART_TEST_SIZE));
+	os_close(fd);
+	free(buf);
+
+	ut_assertok(host_dev_bind(0, PART_TEST_FILE));
+	ut_assertok(blk_get_device(IF_TYPE_HOST, 0, &dev));
+	desc = dev_get_uclass_platdata(dev);
+	host_dev = dev_get_priv(dev);
+	ut_assertok(part_test_write_gpt(uts, desc, "misc"));
+	gpt = malloc(PART_TEST_GPT_BLKS * desc->blksz);
+	ut_assertnonnull(gpt);
+	ut_asserteq(PART_TEST_GPT_BLKS,
+		    blk_dread(desc, 0, PART_TEST_GPT_BLKS, gpt));
+
+	/* The first lookup reads the table */
+	host_dev->reads = 0;
+	ut_asserteq(2, part_get_info_by_name(desc, "system", &info));
+	ut_asserteq(64 + 256, info.start);
+	ut_asserteq(256, info.size);
+	reads = host_dev->reads;
+	ut_assert(reads > 0);
+
+	/* Later ones do not, whether by name or number */
+	ut_asserteq(3, part_get_info_by_name(desc, "misc", &info));
+	ut_asserteq(1, part_get_info_by_name(desc, "boot", &info));
+	ut_asserteq(-1, part_get_info_by_name(desc, "cache", &info));
+	ut_assertok(part_get_info(desc, 3, &info));
+	ut_asserteq_str("misc", (char *)info.name);
+	ut_asserteq(reads, host_dev->reads);
+
+	/* Writing inside a partition keeps the table */
+	memset(block, '\0', sizeof(block));
+	ut_asserteq(1, blk_dwrite(desc, 64 + 256, 1, block));
+	ut_asserteq(3, part_get_info_by_name(desc, "misc", &info));
+	ut_asserteq(reads, host_dev->reads);
+
+	/* A new table is read by the next lookup */
+	ut_assertok(part_test_write_gpt(uts, desc, "cache"));
+	ut_asserteq(-1, part_get_info_by_name(desc, "misc", &info));
+	ut_asserteq(3, part_get_info_by_name(desc, "cache", &info));
+	ut_assert(host_dev->reads > reads);
+
+	/* So is one written block by block, e.g. by fastboot */
+	ut_asserteq(1, blk_dread(desc, 1, 1, block));
+	ut_asserteq(1, blk_dwrite(desc, 1, 1, block));
+	reads = host_dev->reads;
+	ut_asserteq(3, part_get_info_by_name(desc, "cache", &info));
+	ut_assert(host_dev->reads > reads);
+
+	/* And one replaced by raw writes, with or without the cache */
+	ut_asserteq(PART_TEST_GPT_BLKS,
+		    blk_dwrite(desc, 0, PART_TEST_GPT_BLKS, gpt));
+	ut_asserteq(-1, part_get_info_by_name(desc, "cache", &info));
+	ut_asserteq(3, part_get_info_by_name(desc, "misc", &info));
+	free(gpt);
+
+	ut_assertok(host_dev_bind(0, NULL));
+	os_unlink(PART_TEST_FILE);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_part_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -14,6 +14,8 @@
 #include <mapmem.h>
 #include <errno.h>
 #include <asm/io.h>
+#include <dm/alloc.h>
+#include <dm/probe.h>
 #include <dm/root.h>
 #include <dm/util.h>
 
@@ -41,10 +43,34 @@ static int do_dm_dump_devres(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_dm_dump_alloc(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	dm_dump_alloc();
+
+	return 0;
+}
+
+static int do_dm_probe_trace(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	if (argc > 0) {
+		if (strcmp(argv[0], "clear"))
+			return CMD_RET_USAGE;
+		dm_probe_trace_clear();
+		return 0;
+	}
+	dm_dump_probe_trace();
+
+	return 0;
+}
+
 static cmd_tbl_t test_commands[] = {
 	U_BOOT_CMD_MKENT(tree, 0, 1, do_dm_dump_all, "", ""),
 	U_BOOT_CMD_MKENT(uclass, 1, 1, do_dm_dump_uclass, "", ""),
 	U_BOOT_CMD_MKENT(devres, 1, 1, do_dm_dump_devres, "", ""),
+	U_BOOT_CMD_MKENT(mem, 1, 1, do_dm_dump_alloc, "", ""),
+	U_BOOT_CMD_MKENT(probe-trace, 1, 1, do_dm_probe_trace, "", ""),
 };
 
 static __maybe_unused void dm_reloc(void)
@@ -85,5 +111,7 @@ U_BOOT_CMD(
 	"Driver model low level access",
 	"tree         Dump driver model tree ('*' = activated)\n"
 	"dm uclass        Dump list of instances for each uclass\n"
-	"dm devres        Dump list of device resources for each device"
+	"dm devres        Dump list of device resources for each device\n"
+	"dm mem           Dump allocation counters for driver model data\n"
+	"dm probe-trace [clear]  Dump (or clear) the time taken by each probe"
 );
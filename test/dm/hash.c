@@ -0,0 +1,249 @@
+/*
+ * Tests for the hash uclass
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/hash.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+/* Large enough for all the algorithms, plus a canary byte */
+#define DIGEST_BUF_SIZE		65
+
+#define PATTERN_SIZE		1000003
+#define BENCH_ADDR		0x1000000
+#define BENCH_SIZE		(8 << 20)
+
+struct hash_vector {
+	const char *algo;
+	const char *msg;
+	const char *digest;
+};
+
+/* FIPS 180 / RFC 1321 test vectors */
+static const struct hash_vector hash_vectors[] = {
+	{ "crc32", "abc", "352441c2" },
+	{ "md5", "abc", "900150983cd24fb0d6963f7d28e17f72" },
+	{ "sha1", "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+	{ "sha1", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	  "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+	{ "sha256", "abc",
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "sha256", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "sha512", "abc",
+	  "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+	  "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" },
+	{ "sha512", "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+		    "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+	  "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+	  "501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909" },
+};
+
+/* Digests of fill_pattern() over PATTERN_SIZE bytes */
+static const struct hash_vector pattern_vectors[] = {
+	{ "crc32", NULL, "23a3c124" },
+	{ "md5", NULL, "c4cf1f03c71b3106e1e7af71b52b6cf3" },
+	{ "sha1", NULL, "cd87c47848c3a95d6093422122dff27bf49799d3" },
+	{ "sha256", NULL,
+	  "08d14a1d67ea1ca028fa245ce8fba33a3cf5a7007aa997581e7e13fc854f5c7c" },
+	{ "sha512", NULL,
+	  "5cc53b51f98e58adbe9310d9e8ec8e6cd22026e9b3d060bfef1185f643f21e1f"
+	  "67481713398e91d5b75e985a9733b42e7945e82749f178662f1664c29bce52ac" },
+};
+
+static void fill_pattern(uint8_t *buf, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = i * 7 + (i >> 8);
+}
+
+static void digest_to_str(const uint8_t *digest, int len, char *str)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		sprintf(str + i * 2, "%02x", digest[i]);
+}
+
+/* Hash @buf progressively, feeding it in pieces of @step bytes */
+static int hash_in_steps(struct udevice *dev, enum HASH_ALGO algo,
+			 const uint8_t *buf, int size, int step, uint8_t *out)
+{
+	void *ctx;
+	int ret, len;
+
+	ret = hash_init(dev, algo, &ctx);
+	if (ret)
+		return ret;
+	for (; size > 0; size -= len, buf += len) {
+		len = min(size, step);
+		ret = hash_update(dev, ctx, buf, len);
+		if (ret)
+			return ret;
+	}
+
+	return hash_finish(dev, ctx, out);
+}
+
+/* Check the known-answer vectors through the preferred engine */
+static int dm_test_hash_vectors(struct unit_test_state *uts)
+{
+	char str[DIGEST_BUF_SIZE * 2];
+	uint8_t out[DIGEST_BUF_SIZE];
+	const struct hash_vector *v;
+	int i, len;
+
+	for (i = 0; i < ARRAY_SIZE(hash_vectors); i++) {
+		v = &hash_vectors[i];
+		len = sizeof(out) - 1;
+		out[len] = 0xa5;
+		ut_assertok(hash_digest_by_name(v->algo, v->msg,
+						strlen(v->msg), out, &len));
+		ut_asserteq(strlen(v->digest) / 2, len);
+		ut_asserteq(0xa5, out[sizeof(out) - 1]);
+		digest_to_str(out, len, str);
+		ut_asserteq_str(v->digest, str);
+	}
+
+	len = 4;
+	ut_asserteq(-ENOSPC, hash_digest_by_name("sha1", "abc", 3, out, &len));
+	len = sizeof(out);
+	ut_asserteq(-EPROTONOSUPPORT,
+		    hash_digest_by_name("sha3", "abc", 3, out, &len));
+
+	return 0;
+}
+DM_TEST(dm_test_hash_vectors, DM_TESTF_SCAN_PDATA);
+
+/*
+ * Check that one-shot and progressive hashing agree across block boundaries,
+ * including updates which do not fill a block
+ */
+static int dm_test_hash_progressive(struct unit_test_state *uts)
+{
+	static const int steps[] = { 1, 63, 64, 65, 127, 4096, PATTERN_SIZE };
+	char str[DIGEST_BUF_SIZE * 2];
+	uint8_t out[DIGEST_BUF_SIZE];
+	const struct hash_vector *v;
+	struct udevice *dev;
+	enum HASH_ALGO algo;
+	uint8_t *buf;
+	int i, j, len;
+
+	buf = malloc(PATTERN_SIZE);
+	ut_assertnonnull(buf);
+	fill_pattern(buf, PATTERN_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(pattern_vectors); i++) {
+		v = &pattern_vectors[i];
+		algo = hash_algo_lookup_by_name(v->algo);
+		ut_assert(algo != HASH_ALGO_INVALID);
+		len = hash_algo_digest_size(algo);
+		ut_assertok(hash_get_device(algo, &dev));
+
+		ut_assertok(hash_digest_wd(dev, algo, buf, PATTERN_SIZE, out,
+					   0x10000));
+		digest_to_str(out, len, str);
+		ut_asserteq_str(v->digest, str);
+
+		for (j = 0; j < ARRAY_SIZE(steps); j++) {
+			/* Byte-at-a-time is slow, so only do the first 4KB */
+			int size = steps[j] == 1 ? 4096 : PATTERN_SIZE;
+			uint8_t ref[DIGEST_BUF_SIZE];
+
+			ut_assertok(hash_digest_wd(dev, algo, buf, size, ref,
+						   0x10000));
+			ut_assertok(hash_in_steps(dev, algo, buf, size,
+						  steps[j], out));
+			ut_assertok(memcmp(ref, out, len));
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_progressive, DM_TESTF_SCAN_PDATA);
+
+/*
+ * Check the selected block functions against the generic C ones, with
+ * unaligned input. On ARMv8 with the Crypto Extensions this compares the
+ * accelerated code against the fallback.
+ */
+static int dm_test_hash_transform(struct unit_test_state *uts)
+{
+	uint8_t *buf, *data;
+	int blocks = 33;
+	int i;
+
+	buf = malloc(blocks * 64 + 1);
+	ut_assertnonnull(buf);
+	data = buf + 1;
+	fill_pattern(data, blocks * 64);
+
+#ifdef CONFIG_SHA1
+	{
+		sha1_context a, b;
+
+		sha1_starts(&a);
+		sha1_starts(&b);
+		sha1_transform(&a, data, blocks);
+		sha1_transform_generic(&b, data, blocks);
+		for (i = 0; i < 5; i++)
+			ut_asserteq(b.state[i], a.state[i]);
+	}
+#endif
+#ifdef CONFIG_SHA256
+	{
+		sha256_context a, b;
+
+		sha256_starts(&a);
+		sha256_starts(&b);
+		sha256_transform(a.state, data, blocks);
+		sha256_transform_generic(b.state, data, blocks);
+		for (i = 0; i < 8; i++)
+			ut_asserteq(b.state[i], a.state[i]);
+	}
+#endif
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_transform, DM_TESTF_SCAN_PDATA);
+
+/* Report the throughput of each algorithm, useful when comparing engines */
+static int dm_test_hash_bench(struct unit_test_state *uts)
+{
+	uint8_t out[DIGEST_BUF_SIZE];
+	struct udevice *dev;
+	enum HASH_ALGO algo;
+	ulong start, us;
+	uint8_t *buf;
+
+	buf = map_sysmem(BENCH_ADDR, BENCH_SIZE);
+	fill_pattern(buf, BENCH_SIZE);
+
+	for (algo = 0; algo < HASH_ALGO_NUM; algo++) {
+		if (hash_get_device(algo, &dev))
+			continue;
+		start = timer_get_us();
+		ut_assertok(hash_digest_wd(dev, algo, buf, BENCH_SIZE, out,
+					   0x10000));
+		us = max((ulong)(timer_get_us() - start), 1UL);
+		printf("%-8s %-10s %6lu MB/s\n", hash_algo_name(algo),
+		       dev->name, BENCH_SIZE / us);
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_bench, DM_TESTF_SCAN_PDATA);
@@ -44,3 +44,101 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(MMC_CMD_STATS)
+static int dm_test_mmc_cmd_count(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct mmc *mmc;
+	ulong count[MMC_CMD_COUNT];
+	char buf[1024];
+	int i;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = find_mmc_device(dev_desc->devnum);
+	ut_assertnonnull(mmc);
+
+	/* The first read may need to set the block length */
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	memcpy(count, mmc->cmd_count, sizeof(count));
+
+	/* Further reads need one CMD23 and one CMD18 each, and nothing else */
+	for (i = 0; i < 3; i++)
+		ut_asserteq(2, blk_dread(dev_desc, 2 + i * 2, 2, buf));
+	ut_asserteq(count[MMC_CMD_SET_BLOCKLEN],
+		    mmc->cmd_count[MMC_CMD_SET_BLOCKLEN]);
+	ut_asserteq(count[MMC_CMD_STOP_TRANSMISSION],
+		    mmc->cmd_count[MMC_CMD_STOP_TRANSMISSION]);
+	ut_asserteq(count[MMC_CMD_SWITCH], mmc->cmd_count[MMC_CMD_SWITCH]);
+	ut_asserteq(count[MMC_CMD_SET_BLOCK_COUNT] + 3,
+		    mmc->cmd_count[MMC_CMD_SET_BLOCK_COUNT]);
+	ut_asserteq(count[MMC_CMD_READ_MULTIPLE_BLOCK] + 3,
+		    mmc->cmd_count[MMC_CMD_READ_MULTIPLE_BLOCK]);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cmd_count, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#define mmc_test_writes(mmc)	((mmc)->cmd_count[MMC_CMD_WRITE_SINGLE_BLOCK] + \
+				 (mmc)->cmd_count[MMC_CMD_WRITE_MULTIPLE_BLOCK])
+
+static int dm_test_mmc_write_cache(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct mmc *mmc;
+	char buf[512 * 8];
+	char cmp[512 * 8];
+	ulong writes;
+	int i;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = find_mmc_device(dev_desc->devnum);
+	ut_assertnonnull(mmc);
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i * 3 + (i >> 9);
+
+	/* Small contiguous writes are held back and sent as one transfer */
+	mmc_write_cache_begin();
+	writes = mmc_test_writes(mmc);
+	for (i = 0; i < 8; i++)
+		ut_asserteq(1, blk_dwrite(dev_desc, 0x100 + i, 1,
+					  buf + i * 512));
+	ut_asserteq(writes, mmc_test_writes(mmc));
+
+	/* A read sees them, since they are written out first */
+	memset(cmp, '\0', sizeof(cmp));
+	ut_asserteq(8, blk_dread(dev_desc, 0x100, 8, cmp));
+	ut_asserteq(writes + 1, mmc_test_writes(mmc));
+	ut_assertok(memcmp(buf, cmp, sizeof(buf)));
+
+	/* A write which does not follow on sends the ones before it */
+	ut_asserteq(1, blk_dwrite(dev_desc, 0x200, 1, buf + 512));
+	ut_asserteq(1, blk_dwrite(dev_desc, 0x300, 1, buf + 1024));
+	ut_asserteq(writes + 2, mmc_test_writes(mmc));
+
+	/* A flush sends them too, and the session carries on */
+	ut_assertok(mmc_write_cache_flush());
+	ut_asserteq(writes + 3, mmc_test_writes(mmc));
+	ut_asserteq(1, blk_dwrite(dev_desc, 0x301, 1, buf + 1536));
+	ut_asserteq(writes + 3, mmc_test_writes(mmc));
+
+	/* Ending the session sends the rest */
+	ut_assertok(mmc_write_cache_end());
+	ut_asserteq(writes + 4, mmc_test_writes(mmc));
+	ut_asserteq(1, blk_dread(dev_desc, 0x200, 1, cmp));
+	ut_assertok(memcmp(buf + 512, cmp, 512));
+	ut_asserteq(1, blk_dread(dev_desc, 0x300, 1, cmp));
+	ut_assertok(memcmp(buf + 1024, cmp, 512));
+	ut_asserteq(1, blk_dread(dev_desc, 0x301, 1, cmp));
+	ut_assertok(memcmp(buf + 1536, cmp, 512));
+
+	/* Outside a session each write is sent straight away */
+	ut_asserteq(1, blk_dwrite(dev_desc, 0x400, 1, buf + 1536));
+	ut_asserteq(writes + 5, mmc_test_writes(mmc));
+	ut_asserteq(1, blk_dread(dev_desc, 0x400, 1, cmp));
+	ut_assertok(memcmp(buf + 1536, cmp, 512));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_write_cache, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Tests for probe tracing and deferral
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <dm/device-internal.h>
+#include <dm/probe.h>
+#include <dm/test.h>
+#include <dm/uclass-internal.h>
+#include <dm/util.h>
+#include <test/ut.h>
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TRACE)
+/* Probing a regulator records the PMIC it needed, nested under it */
+static int dm_test_probe_trace(struct unit_test_state *uts)
+{
+	const struct dm_probe_record *rec;
+	struct udevice *dev;
+	int i, count;
+
+	ut_assertok(uclass_find_device_by_name(UCLASS_REGULATOR, "buck1",
+					       &dev));
+	ut_assert(!(dev->parent->flags & DM_FLAG_ACTIVATED));
+
+	dm_probe_trace_clear();
+	ut_assertok(device_probe(dev));
+	/* Probing again does nothing, so is not recorded */
+	ut_assertok(device_probe(dev));
+
+	rec = dm_probe_trace_get(&count);
+	ut_assert(count >= 2);
+	ut_asserteq_str("buck1", rec[0].name);
+	ut_asserteq_str("regulator", rec[0].uclass);
+	ut_asserteq(-1, rec[0].caller);
+	ut_asserteq(0, rec[0].depth);
+	ut_asserteq(0, rec[0].ret);
+
+	/* Everything else was probed on behalf of the regulator */
+	for (i = 1; i < count; i++) {
+		ut_assert(rec[i].caller >= 0 && rec[i].caller < i);
+		ut_asserteq(rec[rec[i].caller].depth + 1, rec[i].depth);
+		ut_assert(rec[i].time <= rec[rec[i].caller].time);
+	}
+	for (i = 1; i < count; i++) {
+		if (!strcmp(rec[i].name, dev->parent->name))
+			break;
+	}
+	ut_assert(i < count);
+	ut_asserteq(0, rec[i].caller);
+	ut_asserteq_str("pmic", rec[i].uclass);
+
+	return 0;
+}
+DM_TEST(dm_test_probe_trace, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+#if CONFIG_IS_ENABLED(DM_PROBE_LAZY)
+/* A uclass which the boot flow does not need is left until first use */
+static int dm_test_probe_lazy(struct unit_test_state *uts)
+{
+#if CONFIG_IS_ENABLED(DM_PROBE_TRACE)
+	const struct dm_probe_record *rec;
+	int count;
+#endif
+	struct udevice *dev;
+	struct uclass *uc;
+	int devs;
+
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	devs = list_count_items(&uc->dev_head);
+	ut_assert(devs > 1);
+
+	dm_probe_trace_clear();
+	dm_probe_set_needed(UCLASS_TEST_FDT, false);
+	ut_assert(!dm_probe_needed(UCLASS_TEST_FDT));
+	ut_assertok(uclass_probe_all(UCLASS_TEST_FDT));
+	uclass_foreach_dev(dev, uc)
+		ut_assert(!(dev->flags & DM_FLAG_ACTIVATED));
+
+#if CONFIG_IS_ENABLED(DM_PROBE_TRACE)
+	rec = dm_probe_trace_get(&count);
+	ut_asserteq(1, count);
+	ut_assert(rec[0].deferred);
+	ut_asserteq_str("testfdt", rec[0].uclass);
+#endif
+
+	/* First use still probes the device */
+	ut_assertok(uclass_get_device(UCLASS_TEST_FDT, 0, &dev));
+	ut_assert(dev->flags & DM_FLAG_ACTIVATED);
+
+	dm_probe_set_needed(UCLASS_TEST_FDT, true);
+	ut_assertok(uclass_probe_all(UCLASS_TEST_FDT));
+	uclass_foreach_dev(dev, uc)
+		ut_assert(dev->flags & DM_FLAG_ACTIVATED);
+	dm_probe_set_needed(UCLASS_TEST_FDT, false);
+
+	/* Only the boot uclasses are needed by default */
+	ut_assert(dm_probe_needed(UCLASS_MMC));
+	ut_assert(!dm_probe_needed(UCLASS_VIDEO));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_lazy, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
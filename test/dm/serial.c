@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2017 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <serial.h>
+#include <stdio_dev.h>
+#include <asm/test.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+/* Number of characters written by serial_test_write() */
+#define SERIAL_TEST_LEN		6
+
+static void serial_test_write(struct stdio_dev *sdev)
+{
+	const char *s = "[buf]";
+
+	while (*s)
+		sdev->putc(sdev, *s++);
+	sdev->putc(sdev, '\n');
+}
+
+/* Test that output waits in the TX buffer while the UART is busy */
+static int dm_test_serial_tx_buffer(struct unit_test_state *uts)
+{
+	struct serial_dev_priv *upriv;
+	struct stdio_dev *sdev;
+	struct udevice *dev;
+	ulong count;
+	int pending;
+
+	ut_assertok(uclass_get_device(UCLASS_SERIAL, 0, &dev));
+	upriv = dev_get_uclass_priv(dev);
+	ut_assertnonnull(upriv->tx_buf);
+	sdev = upriv->sdev;
+	ut_assertnonnull(sdev);
+
+	/* Nothing reaches the UART while its FIFO is full */
+	count = sandbox_serial_get_tx_count(dev);
+	sandbox_serial_set_tx_busy(dev, 1000);
+	serial_test_write(sdev);
+	sandbox_serial_set_tx_busy(dev, 0);
+	ut_asserteq(count, sandbox_serial_get_tx_count(dev));
+
+	/* The newline is sent as "\r\n" */
+	pending = upriv->tx_wr - upriv->tx_rd;
+	ut_asserteq(SERIAL_TEST_LEN + 1, pending);
+
+	/* Polling for input sends it once the UART has room */
+	sdev->tstc(sdev);
+	ut_asserteq(upriv->tx_wr, upriv->tx_rd);
+	ut_asserteq(count + SERIAL_TEST_LEN + 1,
+		    sandbox_serial_get_tx_count(dev));
+
+	/*
+	 * Each character written tries the UART once, so it is still busy
+	 * after the write and a flush must wait for it to take everything
+	 */
+	sandbox_serial_set_tx_busy(dev, SERIAL_TEST_LEN + 4);
+	serial_test_write(sdev);
+	ut_asserteq(count + SERIAL_TEST_LEN + 1,
+		    sandbox_serial_get_tx_count(dev));
+	serial_flush();
+	ut_asserteq(upriv->tx_wr, upriv->tx_rd);
+	ut_asserteq(count + 2 * (SERIAL_TEST_LEN + 1),
+		    sandbox_serial_get_tx_count(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_serial_tx_buffer, DM_TESTF_SCAN_FDT);
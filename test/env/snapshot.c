@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2017 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <errno.h>
+#include <search.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+#define SNAP_SIZE	8192
+#define SNAP_BLKSZ	512
+#define SNAP_VARS	100
+
+static int snapshot_set(struct hsearch_data *htab, const char *name,
+			const char *value)
+{
+	ENTRY e, *ep;
+
+	e.key = name;
+	e.data = (char *)value;
+
+	return hsearch_r(e, ENTER, &ep, htab, 0) ? 0 : -EINVAL;
+}
+
+static const char *snapshot_get(struct hsearch_data *htab, const char *name)
+{
+	ENTRY e, *ep;
+
+	e.key = name;
+	e.data = NULL;
+	if (!hsearch_r(e, FIND, &ep, htab, 0))
+		return NULL;
+
+	return ep->data;
+}
+
+/* Fill a table with variables var0..var99, each with a distinct value */
+static int snapshot_fill(struct unit_test_state *uts,
+			 struct hsearch_data *htab)
+{
+	char name[16], value[48];
+	int i;
+
+	ut_assert(hcreate_r(SNAP_VARS * 2, htab));
+	for (i = 0; i < SNAP_VARS; i++) {
+		snprintf(name, sizeof(name), "var%d", i);
+		snprintf(value, sizeof(value), "value of variable number %d", i);
+		ut_assertok(snapshot_set(htab, name, value));
+	}
+
+	return 0;
+}
+
+static int env_test_snapshot_import(struct unit_test_state *uts)
+{
+	struct hsearch_data src = {}, dst = {};
+	char name[16], value[48];
+	char *buf;
+	int i;
+
+	buf = calloc(1, SNAP_SIZE);
+	ut_assertnonnull(buf);
+	ut_assertok(snapshot_fill(uts, &src));
+	ut_assertok(hdelete_r("var7", &src, 0) ? 0 : -ENOENT);
+	ut_asserteq(SNAP_SIZE, hexport_snapshot_r(&src, buf, SNAP_SIZE));
+	ut_assert(hsnapshot_check(buf, SNAP_SIZE));
+
+	/* The exporting table now uses the strings of the snapshot */
+	ut_asserteq_str("value of variable number 3",
+			snapshot_get(&src, "var3"));
+
+	ut_assert(himport_snapshot_r(&dst, buf, SNAP_SIZE, 0));
+	ut_asserteq(src.size, dst.size);
+	ut_asserteq(SNAP_VARS - 1, dst.filled);
+	for (i = 0; i < SNAP_VARS; i++) {
+		snprintf(name, sizeof(name), "var%d", i);
+		snprintf(value, sizeof(value), "value of variable number %d", i);
+		if (i == 7) {
+			ut_asserteq_ptr(NULL, snapshot_get(&dst, name));
+		} else {
+			ut_asserteq_str(value, snapshot_get(&dst, name));
+		}
+	}
+
+	/* An imported table can be changed like any other */
+	ut_assertok(snapshot_set(&dst, "var3", "changed"));
+	ut_assertok(snapshot_set(&dst, "var7", "back again"));
+	ut_asserteq_str("changed", snapshot_get(&dst, "var3"));
+	ut_asserteq_str("back again", snapshot_get(&dst, "var7"));
+
+	hdestroy_r(&src);
+	hdestroy_r(&dst);
+	free(buf);
+
+	return 0;
+}
+ENV_TEST(env_test_snapshot_import, 0);
+
+static int env_test_snapshot_stable(struct unit_test_state *uts)
+{
+	struct hsearch_data htab = {};
+	char *buf, *prev;
+	int i, changed;
+
+	buf = calloc(1, SNAP_SIZE);
+	prev = calloc(1, SNAP_SIZE);
+	ut_assertnonnull(buf);
+	ut_assertnonnull(prev);
+	ut_assertok(snapshot_fill(uts, &htab));
+	ut_asserteq(SNAP_SIZE, hexport_snapshot_r(&htab, prev, SNAP_SIZE));
+
+	/* Setting a variable to the value it has changes nothing */
+	ut_assertok(snapshot_set(&htab, "var50",
+				 "value of variable number 50"));
+	ut_asserteq(SNAP_SIZE, hexport_snapshot_r(&htab, buf, SNAP_SIZE));
+	ut_assertok(memcmp(prev, buf, SNAP_SIZE));
+
+	/*
+	 * Only the slots and the newly added strings differ, not the strings
+	 * after the ones which changed
+	 */
+	ut_assertok(snapshot_set(&htab, "var50", "a new value"));
+	ut_assertok(hdelete_r("var20", &htab, 0) ? 0 : -ENOENT);
+	ut_assertok(snapshot_set(&htab, "added", "a new variable"));
+	ut_asserteq(SNAP_SIZE, hexport_snapshot_r(&htab, buf, SNAP_SIZE));
+	for (i = 0, changed = 0; i < SNAP_SIZE; i += SNAP_BLKSZ)
+		changed += memcmp(prev + i, buf + i, SNAP_BLKSZ) != 0;
+	ut_assert(changed <= 4);
+
+	ut_asserteq_str("a new value", snapshot_get(&htab, "var50"));
+	ut_asserteq_ptr(NULL, snapshot_get(&htab, "var20"));
+	ut_asserteq_str("a new variable", snapshot_get(&htab, "added"));
+
+	/* A snapshot which does not fit fails rather than being cut short */
+	ut_asserteq(-1, hexport_snapshot_r(&htab, buf, 1024));
+	ut_asserteq(ENOSPC, errno);
+
+	hdestroy_r(&htab);
+	free(prev);
+	free(buf);
+
+	return 0;
+}
+ENV_TEST(env_test_snapshot_stable, 0);
+
+static int env_test_snapshot_corrupt(struct unit_test_state *uts)
+{
+	struct hsearch_data src = {}, dst = {};
+	u32 *slots;
+	char *buf;
+	int i;
+
+	buf = calloc(1, SNAP_SIZE);
+	ut_assertnonnull(buf);
+	ut_assertok(snapshot_fill(uts, &src));
+	ut_asserteq(SNAP_SIZE, hexport_snapshot_r(&src, buf, SNAP_SIZE));
+
+	/* A slot pointing past the strings */
+	slots = (u32 *)(buf + 16);
+	for (i = 0; slots[i] <= 1; i++)
+		;
+	slots[i] = SNAP_SIZE - 4;
+	ut_asserteq(0, himport_snapshot_r(&dst, buf, SNAP_SIZE, 0));
+	ut_asserteq(EINVAL, errno);
+
+	/* A text environment is not a snapshot */
+	strcpy(buf, "var0=value");
+	ut_assert(!hsnapshot_check(buf, SNAP_SIZE));
+	ut_asserteq(0, himport_snapshot_r(&dst, buf, SNAP_SIZE, 0));
+
+	hdestroy_r(&src);
+	free(buf);
+
+	return 0;
+}
+ENV_TEST(env_test_snapshot_corrupt, 0);
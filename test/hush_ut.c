@@ -0,0 +1,117 @@
+/*
+ * Tests and benchmark for running scripts kept parsed by the hush shell
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cli_hush.h>
+#include <command.h>
+#include <environment.h>
+#include <malloc.h>
+
+/* Each block is a few lines of the benchmark script */
+#define HUSH_UT_BLOCKS	64
+#define HUSH_UT_LOOPS	1000
+
+static const char hush_ut_block[] =
+	"if true; then true; else false; fi\n"
+	"true && false || true\n"
+	"for i in a b c; do true; done\n"
+	"while false; do true; done\n";
+
+static int hush_ut_expect(const char *cmd, const char *name,
+			  const char *expect)
+{
+	const char *val;
+
+	run_command_list(cmd, -1, 0);
+	val = env_get(name);
+	if (!val || strcmp(val, expect)) {
+		printf("%s: %s is '%s', expected '%s'\n", cmd, name,
+		       val ? val : "(unset)", expect);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int hush_ut_check(void)
+{
+	int ret = 0;
+	int i;
+
+	/* The same text gives the same result, parsed or kept */
+	for (i = 0; i < 3; i++)
+		ret |= hush_ut_expect("setenv out; for i in 1 2 3; do "
+				      "if test $i = 2; then setenv out ${out}b; "
+				      "else setenv out ${out}$i; fi; done",
+				      "out", "1b3");
+
+	/* A loop left by exit is run again from the start */
+	env_set("loop", "setenv out; for i in 1 2 3; do setenv out ${out}$i; "
+		"if test $i = 2; then exit; fi; done");
+	for (i = 0; i < 3; i++)
+		ret |= hush_ut_expect("run loop", "out", "12");
+
+	/* A script which runs itself from a loop does not see the loop */
+	env_set("loop", "for i in a b; do setenv out ${out}$i; "
+		"if test -z \"$depth\"; then setenv depth 1; run loop; fi; "
+		"done");
+	for (i = 0; i < 3; i++)
+		ret |= hush_ut_expect("setenv out; setenv depth; run loop",
+				      "out", "aabb");
+
+	/* Changing a variable runs the new text */
+	env_set("script", "setenv out a");
+	ret |= hush_ut_expect("run script", "out", "a");
+	env_set("script", "setenv out b");
+	ret |= hush_ut_expect("run script", "out", "b");
+
+	env_set("loop", NULL);
+	env_set("script", NULL);
+	env_set("depth", NULL);
+	env_set("out", NULL);
+
+	return ret;
+}
+
+int do_ut_hush(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	ulong loops = HUSH_UT_LOOPS;
+	ulong start, parse_us, kept_us;
+	char *script;
+	int ret, i;
+
+	if (argc > 1)
+		loops = simple_strtoul(argv[1], NULL, 10) ?: loops;
+
+	ret = hush_ut_check();
+
+	script = malloc(sizeof(hush_ut_block) * HUSH_UT_BLOCKS);
+	if (!script) {
+		printf("%s: out of memory\n", __func__);
+		return CMD_RET_FAILURE;
+	}
+	*script = '\0';
+	for (i = 0; i < HUSH_UT_BLOCKS; i++)
+		strcat(script, hush_ut_block);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		hush_script_cache_flush();
+		run_command_list(script, -1, 0);
+	}
+	parse_us = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		run_command_list(script, -1, 0);
+	kept_us = timer_get_us() - start;
+	printf("Script: %u lines, %lu runs, parsed %lu us, kept %lu us\n",
+	       HUSH_UT_BLOCKS * 4, loops, parse_us / loops, kept_us / loops);
+	free(script);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,238 @@
+/*
+ * Tests for memcpy(), memmove() and memset()
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <errno.h>
+#include <malloc.h>
+
+/* Size of the test buffer; copies and fills land anywhere inside it */
+#define MEM_UT_SIZE	8192
+#define MEM_UT_ITERS	20000
+
+enum {
+	MEM_UT_MEMCPY,
+	MEM_UT_MEMMOVE,
+	MEM_UT_MEMSET,
+	MEM_UT_MEMSET_ZERO,
+
+	MEM_UT_COUNT,
+};
+
+static const char *const mem_ut_name[MEM_UT_COUNT] = {
+	"memcpy", "memmove", "memset", "memset zero",
+};
+
+/* xorshift32, so that a failure can be reproduced from the seed */
+static u32 mem_ut_rand(u32 *state)
+{
+	u32 x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/*
+ * Pick a length, mostly small ones since the routines have separate paths
+ * for each size up to 64 bytes, and some up to the whole buffer
+ */
+static ulong mem_ut_len(u32 *state)
+{
+	switch (mem_ut_rand(state) % 4) {
+	case 0:
+		return mem_ut_rand(state) % 80;
+	case 1:
+		return mem_ut_rand(state) % 600;
+	case 2:
+		return mem_ut_rand(state) % 4096;
+	default:
+		return mem_ut_rand(state) % (MEM_UT_SIZE / 2);
+	}
+}
+
+static int mem_ut_run(u32 seed, u8 *buf, u8 *ref)
+{
+	ulong iter, len, dst, src, i;
+	u32 state = seed;
+	void *ret;
+	int op, c;
+
+	for (i = 0; i < MEM_UT_SIZE; i++)
+		buf[i] = mem_ut_rand(&state);
+	memcpy(ref, buf, MEM_UT_SIZE);
+
+	for (iter = 0; iter < MEM_UT_ITERS; iter++) {
+		op = mem_ut_rand(&state) % MEM_UT_COUNT;
+		len = mem_ut_len(&state);
+		dst = mem_ut_rand(&state) % (MEM_UT_SIZE - len + 1);
+		src = mem_ut_rand(&state) % (MEM_UT_SIZE - len + 1);
+		c = mem_ut_rand(&state);
+
+		switch (op) {
+		case MEM_UT_MEMCPY:
+			/*
+			 * The source may overlap the destination from above,
+			 * otherwise move it out of the way
+			 */
+			len = min_t(ulong, len, MEM_UT_SIZE / 3);
+			if (!(mem_ut_rand(&state) % 4))
+				src = min(dst + mem_ut_rand(&state) % 33,
+					  MEM_UT_SIZE - len);
+			if (src < dst && dst < src + len) {
+				if (dst >= len)
+					src = mem_ut_rand(&state) % (dst - len + 1);
+				else
+					src = dst + len + mem_ut_rand(&state) %
+					      (MEM_UT_SIZE - dst - 2 * len + 1);
+			}
+			ret = memcpy(buf + dst, buf + src, len);
+			for (i = 0; i < len; i++)
+				ref[dst + i] = ref[src + i];
+			break;
+		case MEM_UT_MEMMOVE:
+			/* Mostly overlapping, by a small distance */
+			if (mem_ut_rand(&state) % 4) {
+				src = dst + mem_ut_rand(&state) % 33;
+				src = src >= 16 ? src - 16 : 0;
+				src = min(src, MEM_UT_SIZE - len);
+			}
+			ret = memmove(buf + dst, buf + src, len);
+			if (dst < src) {
+				for (i = 0; i < len; i++)
+					ref[dst + i] = ref[src + i];
+			} else {
+				for (i = len; i > 0; i--)
+					ref[dst + i - 1] = ref[src + i - 1];
+			}
+			break;
+		case MEM_UT_MEMSET:
+		case MEM_UT_MEMSET_ZERO:
+			if (op == MEM_UT_MEMSET_ZERO)
+				c = 0;
+			ret = memset(buf + dst, c, len);
+			for (i = 0; i < len; i++)
+				ref[dst + i] = c;
+			break;
+		}
+
+		if (ret != buf + dst || memcmp(buf, ref, MEM_UT_SIZE)) {
+			for (i = 0; i < MEM_UT_SIZE && buf[i] == ref[i]; i++)
+				;
+			printf("%s: seed %#x, iteration %lu: %s(%#lx, %#lx, %#lx) failed at byte %#lx\n",
+			       __func__, seed, iter, mem_ut_name[op], dst, src,
+			       len, i);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static void mem_ut_bench_show(const char *name, ulong bytes, ulong iter,
+			      ulong us)
+{
+	printf("%-18s %10lu us %8lu MB/s\n", name, us,
+	       us ? (ulong)lldiv((u64)bytes * iter, us) : 0);
+}
+
+/*
+ * Time memcpy(), memmove() and memset() over a buffer, to compare the
+ * string routines built in.
+ *
+ * Syntax:
+ *	ut mem bench [size [iterations]]
+ */
+static int mem_ut_bench(int argc, char * const argv[])
+{
+	ulong size = 0x100000, iter, total, i, start;
+	u8 *buf, *dst;
+
+	if (argc > 1)
+		size = simple_strtoul(argv[1], NULL, 16);
+	if (size < 8)
+		return CMD_RET_USAGE;
+	iter = max(1UL, 0x4000000UL / size);
+	if (argc > 2)
+		iter = simple_strtoul(argv[2], NULL, 10);
+	if (!iter)
+		return CMD_RET_USAGE;
+
+	/* Source, then destination one cache line further on */
+	total = size * 2 + ARCH_DMA_MINALIGN;
+	buf = memalign(ARCH_DMA_MINALIGN, total);
+	if (!buf) {
+		printf("Cannot allocate %#lx bytes\n", total);
+		return CMD_RET_FAILURE;
+	}
+	dst = buf + size + ARCH_DMA_MINALIGN;
+	memset(buf, 0x5a, total);
+	printf("size %#lx, %lu iterations\n", size, iter);
+
+	start = timer_get_us();
+	for (i = 0; i < iter; i++)
+		memcpy(dst, buf, size);
+	mem_ut_bench_show("memcpy", size, iter, timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < iter; i++)
+		memcpy(dst + 3, buf + 1, size - 3);
+	mem_ut_bench_show("memcpy unaligned", size - 3, iter,
+			  timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < iter; i++)
+		memmove(buf + 8, buf, size);
+	mem_ut_bench_show("memmove overlap", size, iter,
+			  timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < iter; i++)
+		memset(buf, i | 1, size);
+	mem_ut_bench_show("memset", size, iter, timer_get_us() - start);
+
+	start = timer_get_us();
+	for (i = 0; i < iter; i++)
+		memset(buf, 0, size);
+	mem_ut_bench_show("memset zero", size, iter, timer_get_us() - start);
+
+	free(buf);
+
+	return 0;
+}
+
+int do_ut_mem(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u32 seed = 0x12345678;
+	u8 *buf, *ref;
+	int ret;
+
+	if (argc > 1 && !strcmp(argv[1], "bench"))
+		return mem_ut_bench(argc - 1, argv + 1);
+	if (argc > 1)
+		seed = simple_strtoul(argv[1], NULL, 16) ?: seed;
+
+	buf = malloc(MEM_UT_SIZE);
+	ref = malloc(MEM_UT_SIZE);
+	if (!buf || !ref) {
+		free(buf);
+		free(ref);
+		printf("%s: out of memory\n", __func__);
+		return CMD_RET_FAILURE;
+	}
+
+	ret = mem_ut_run(seed, buf, ref);
+	free(buf);
+	free(ref);
+
+	printf("Test %s\n", ret ? "failed" : "passed");
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,161 @@
+# Copyright (c) 2017 Rockchip Electronics Co., Ltd
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check that the parts of an Android boot image are loaded straight to their
+# final addresses, falling back to their place in the image if not free
+
+import os
+import pytest
+import struct
+import zlib
+import u_boot_utils as util
+
+PAGE_SIZE = 2048
+DEFAULT_KERNEL_ADDR = 0x10008000
+
+# Sizes which are not a whole number of blocks
+KERNEL_SIZE = 1024 * 1024 + 123
+RAMDISK_SIZE = 300000
+SECOND_SIZE = 5000
+
+def align(size):
+    """Round a size up to a whole number of pages"""
+    return (size + PAGE_SIZE - 1) // PAGE_SIZE * PAGE_SIZE
+
+def make_image(fname, kernel_addr, ramdisk=None):
+    """Make an Android boot image
+
+    Args:
+        fname: Filename of the image to create
+        kernel_addr: Kernel load address to put in the header
+        ramdisk: Contents of the ramdisk, or None for random data
+    Returns:
+        Dict of part name to contents
+    """
+    parts = {
+        'kernel': os.urandom(KERNEL_SIZE),
+        'ramdisk': ramdisk or os.urandom(RAMDISK_SIZE),
+        'second': os.urandom(SECOND_SIZE),
+    }
+    hdr = struct.pack('<8s10I16s512s32s1024s', 'ANDROID!',
+                      KERNEL_SIZE, kernel_addr, len(parts['ramdisk']), 0,
+                      SECOND_SIZE, 0, 0, PAGE_SIZE, 0, 0, 'test',
+                      'console=ttyS0', '', '')
+    with open(fname, 'wb') as fd:
+        fd.write(hdr.ljust(PAGE_SIZE, '\0'))
+        for name in ('kernel', 'ramdisk', 'second'):
+            fd.write(parts[name].ljust(align(len(parts[name])), '\0'))
+    return parts
+
+def check_crc(cons, addr, data):
+    """Check that memory at addr holds data"""
+    output = cons.run_command('crc32 %x %x' % (addr, len(data)))
+    assert '==> %08x' % (zlib.crc32(data) & 0xffffffff) in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_load_android')
+def test_android_load(u_boot_console):
+    """Test loading the parts of an Android image to where they are booted"""
+    cons = u_boot_console
+    fname = os.path.join(cons.config.persistent_data_dir, 'android_load.img')
+    base = util.find_ram_base(cons)
+    addr = base + 0x100000
+    kernel_addr = base + 0x1000000
+    ramdisk_addr = base + 0x2000000
+    blob_kernel = addr + PAGE_SIZE
+    blob_ramdisk = blob_kernel + align(KERNEL_SIZE)
+    blob_second = blob_ramdisk + align(RAMDISK_SIZE)
+
+    # Kernel and ramdisk are read straight to their addresses, leaving their
+    # places in the image untouched
+    parts = make_image(fname, kernel_addr)
+    cons.run_command('host bind 0 %s' % fname)
+    try:
+        cons.run_command('mw.b %x 0 %x' % (addr, 4 * 1024 * 1024))
+        cons.run_command('setenv ramdisk_addr_r %x' % ramdisk_addr)
+        reads = util.host_reads(cons)
+        output = cons.run_command('load_android host 0:0 %x' % addr)
+        assert 'Error' not in output
+        reads = util.host_reads(cons) - reads
+        check_crc(cons, kernel_addr, parts['kernel'])
+        check_crc(cons, ramdisk_addr, parts['ramdisk'])
+        check_crc(cons, blob_second, parts['second'])
+        check_crc(cons, blob_kernel, '\0' * (blob_second - blob_kernel))
+
+        # A read for the header and for each part, with a partial last block,
+        # and one to check the format of the ramdisk
+        assert reads <= 9
+    finally:
+        cons.run_command('host bind 0')
+
+    # The kernel is used in place, and a ramdisk address which overlaps the
+    # header is not used
+    parts = make_image(fname, DEFAULT_KERNEL_ADDR)
+    cons.run_command('host bind 0 %s' % fname)
+    try:
+        cons.run_command('setenv ramdisk_addr_r %x' % addr)
+        output = cons.run_command('load_android host 0:0 %x' % addr)
+        assert 'Error' not in output
+        check_crc(cons, blob_kernel, parts['kernel'])
+        check_crc(cons, blob_ramdisk, parts['ramdisk'])
+        check_crc(cons, blob_second, parts['second'])
+    finally:
+        cons.run_command('setenv ramdisk_addr_r')
+        cons.run_command('host bind 0')
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('android_ramdisk_decompress')
+@pytest.mark.parametrize('comp', ['gzip', 'lz4', 'lz4_legacy'])
+def test_android_load_ramdisk(u_boot_console, comp):
+    """Test decompressing the ramdisk of an Android image while loading it"""
+    cons = u_boot_console
+    if comp == 'gzip' and cons.config.buildconfig.get(
+            'config_gzip_stream', 'n') != 'y':
+        pytest.skip('gzip streaming not enabled')
+    if comp != 'gzip' and cons.config.buildconfig.get(
+            'config_lz4', 'n') != 'y':
+        pytest.skip('LZ4 not enabled')
+    tmpdir = cons.config.persistent_data_dir
+    fname = os.path.join(tmpdir, 'android_load.img')
+    rdname = os.path.join(tmpdir, 'android_ramdisk')
+    base = util.find_ram_base(cons)
+    addr = base + 0x100000
+    ramdisk_addr = base + 0x2000000
+
+    # Compressible, and spanning several LZ4 blocks and gzip read chunks
+    data = ''.join(os.urandom(1024) * 16 for i in range(1024))
+    with open(rdname, 'wb') as fd:
+        fd.write(data)
+    if comp == 'gzip':
+        util.run_and_log(cons, ['gzip', '-f', '-k', rdname])
+        rdname += '.gz'
+    else:
+        args = ['lz4', '-f', '-q']
+        if comp == 'lz4_legacy':
+            args.append('-l')
+        util.run_and_log(cons, args + [rdname, rdname + '.lz4'])
+        rdname += '.lz4'
+    with open(rdname, 'rb') as fd:
+        parts = make_image(fname, DEFAULT_KERNEL_ADDR, fd.read())
+
+    cons.run_command('host bind 0 %s' % fname)
+    try:
+        cons.run_command('setenv ramdisk_addr_r %x' % ramdisk_addr)
+        output = cons.run_command('load_android host 0:0 %x' % addr)
+        assert ('Android ramdisk decompressed to 0x%x, %d KiB' %
+                (ramdisk_addr, len(data) // 1024)) in output
+        check_crc(cons, ramdisk_addr, data)
+
+        # With no room to read an LZ4 ramdisk before decompressing it, it is
+        # loaded compressed
+        if comp != 'gzip':
+            blob_ramdisk = addr + PAGE_SIZE + align(KERNEL_SIZE)
+            cons.run_command('setenv ramdisk_addr_r %x' % blob_ramdisk)
+            output = cons.run_command('load_android host 0:0 %x' % addr)
+            assert 'loading it compressed' in output
+            assert 'Error' not in output
+            check_crc(cons, blob_ramdisk, parts['ramdisk'])
+    finally:
+        cons.run_command('setenv ramdisk_addr_r')
+        cons.run_command('host bind 0')
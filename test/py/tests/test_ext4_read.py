@@ -0,0 +1,104 @@
+# Copyright (c) 2017 Rockchip Electronics Co., Ltd
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check that ext4 files are read a run of blocks at a time, by counting the
+# read requests made to a sandbox host device
+
+import os
+import pytest
+import zlib
+import u_boot_utils as util
+
+# Size of the filesystem image, and of the files used to fragment it
+IMAGE_SIZE = 96 * 1024 * 1024
+FILLER_SIZE = 1024 * 1024
+FILLER_COUNT = 88
+
+# Large enough to need an extent index block once fragmented
+BIG_SIZE = 30 * 1024 * 1024
+SPARSE_SIZE = 5000000
+
+def make_image(cons, fname):
+    """Make an ext4 image holding a fragmented file and a sparse file
+
+    The image is filled with filler files and every other one is removed,
+    so the big file written after them is spread over many extents.
+
+    Args:
+        cons: U-Boot console
+        fname: Filename of the image to create
+    Returns:
+        Dict of filename to contents, for files in the image
+    """
+    tmpdir = cons.config.persistent_data_dir
+    files = {
+        'big': os.urandom(BIG_SIZE),
+        'filler': os.urandom(FILLER_SIZE),
+    }
+    for name, data in files.items():
+        with open(os.path.join(tmpdir, name), 'wb') as fd:
+            fd.write(data)
+
+    # Only the written parts of the sparse file are allocated
+    sparse = bytearray(SPARSE_SIZE)
+    with open(os.path.join(tmpdir, 'sparse'), 'wb') as fd:
+        for pos, data in ((2000000, 'middle'), (SPARSE_SIZE - 3, 'end')):
+            fd.seek(pos)
+            fd.write(data)
+            sparse[pos:pos + len(data)] = data
+    files['sparse'] = str(sparse)
+
+    cmds = os.path.join(tmpdir, 'ext4_read.cmds')
+    with open(cmds, 'w') as fd:
+        for i in range(FILLER_COUNT):
+            fd.write('write %s f%d\n' % (os.path.join(tmpdir, 'filler'), i))
+        for i in range(0, FILLER_COUNT, 2):
+            fd.write('rm f%d\n' % i)
+        fd.write('write %s big\n' % os.path.join(tmpdir, 'big'))
+        fd.write('write %s sparse\n' % os.path.join(tmpdir, 'sparse'))
+
+    util.run_and_log(cons, ['mkfs.ext4', '-q', '-F', '-b', '4096', fname,
+                            '%dK' % (IMAGE_SIZE / 1024)])
+    util.run_and_log(cons, ['debugfs', '-w', '-f', cmds, fname])
+    del files['filler']
+    return files
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_ext4')
+def test_ext4_read(u_boot_console):
+    """Test that a fragmented file is read with a few requests"""
+    cons = u_boot_console
+    fname = os.path.join(cons.config.persistent_data_dir, 'ext4_read.img')
+    files = make_image(cons, fname)
+    addr = util.find_ram_base(cons) + 0x100000
+
+    cons.run_command('host bind 0 %s' % fname)
+    try:
+        # Count the reads needed to mount and find the file
+        reads = util.host_reads(cons)
+        output = cons.run_command('ext4size host 0 big')
+        assert 'Error' not in output
+        lookup = util.host_reads(cons) - reads
+
+        for name, data in sorted(files.items()):
+            reads = util.host_reads(cons)
+            output = cons.run_command('ext4load host 0 %x %s' % (addr, name))
+            assert '%d bytes read' % len(data) in output
+            reads = util.host_reads(cons) - reads
+            output = cons.run_command('crc32 %x %x' % (addr, len(data)))
+            assert '==> %08x' % (zlib.crc32(data) & 0xffffffff) in output
+
+            # One read per extent, plus the index block, not one per block
+            if name == 'big':
+                assert reads < lookup + 64
+
+        # Part of the file, starting part-way into a block
+        offset = 4660
+        size = 1024 * 1024
+        cons.run_command('ext4load host 0 %x big %x %x' % (addr, size, offset))
+        output = cons.run_command('crc32 %x %x' % (addr, size))
+        crc = zlib.crc32(files['big'][offset:offset + size]) & 0xffffffff
+        assert '==> %08x' % crc in output
+    finally:
+        cons.run_command('host bind 0')
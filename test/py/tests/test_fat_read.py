@@ -0,0 +1,154 @@
+# Copyright (c) 2017 Rockchip Electronics Co., Ltd
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Check that FAT files are read a run of clusters at a time, with the FAT
+# read once, by counting the read requests made to a sandbox host device
+
+import os
+import pytest
+import struct
+import zlib
+import u_boot_utils as util
+
+SECT_SIZE = 512
+CLUST_SECTS = 4
+CLUST_SIZE = SECT_SIZE * CLUST_SECTS
+TOTAL_SECTS = 64 * 1024 * 1024 // SECT_SIZE
+FAT_SECTS = 128
+ROOT_ENTRIES = 512
+DATA_SECT = 1 + 2 * FAT_SECTS + ROOT_ENTRIES * 32 // SECT_SIZE
+
+# The big file is interleaved with a filler file, a run of clusters each. A
+# run fits in the FAT driver's bounce buffer, used if the load address is not
+# aligned for DMA
+BIG_SIZE = 16 * 1024 * 1024
+RUN_CLUSTS = 32
+BIG_RUNS = BIG_SIZE // CLUST_SIZE // RUN_CLUSTS
+SMALL_SIZE = 3000
+
+def dir_entry(name, attr, start, size):
+    """Make a directory entry
+
+    Args:
+        name: 8.3 name, padded to 11 characters
+        attr: Attributes
+        start: First cluster
+        size: Size in bytes
+    Returns:
+        String holding the entry
+    """
+    return struct.pack('<11sBBBHHHHHHHI', name, attr, 0, 0, 0, 0, 0, 0, 0, 0,
+                       start, size)
+
+def make_image(fname):
+    """Make a FAT16 image with a fragmented file in a subdirectory
+
+    Args:
+        fname: Filename of the image to create
+    Returns:
+        Dict of path to contents, for files in the image
+    """
+    img = bytearray(TOTAL_SECTS * SECT_SIZE)
+    fat = [0xfff8, 0xffff]
+    files = {
+        'boot/big': os.urandom(BIG_SIZE),
+        'boot/small': os.urandom(SMALL_SIZE),
+        'filler': os.urandom(BIG_SIZE),
+    }
+    chains = {name: [] for name in files}
+
+    # Cluster 2 is the boot directory, then alternate runs of big and filler
+    fat.append(0xffff)
+    for run in range(BIG_RUNS):
+        for name in ('boot/big', 'filler'):
+            chains[name] += range(len(fat), len(fat) + RUN_CLUSTS)
+            fat += [0] * RUN_CLUSTS
+    small_clusts = (SMALL_SIZE + CLUST_SIZE - 1) // CLUST_SIZE
+    chains['boot/small'] = range(len(fat), len(fat) + small_clusts)
+    fat += [0] * small_clusts
+
+    for name, chain in chains.items():
+        for i, clust in enumerate(chain):
+            fat[clust] = chain[i + 1] if i + 1 < len(chain) else 0xffff
+            pos = (DATA_SECT + (clust - 2) * CLUST_SECTS) * SECT_SIZE
+            data = files[name][i * CLUST_SIZE:(i + 1) * CLUST_SIZE]
+            img[pos:pos + len(data)] = data
+
+    boot = struct.pack('<3s8sHBHBHHBHHHII', '\xeb\x3c\x90', 'U-BOOT  ',
+                       SECT_SIZE, CLUST_SECTS, 1, 2, ROOT_ENTRIES, 0, 0xf8,
+                       FAT_SECTS, 32, 64, 0, TOTAL_SECTS)
+    boot += struct.pack('<BBBI11s8s', 0x80, 0, 0x29, 0x12345678,
+                        'NO NAME    ', 'FAT16   ')
+    img[0:len(boot)] = boot
+    img[510:512] = '\x55\xaa'
+    table = struct.pack('<%dH' % len(fat), *fat)
+    for i in range(2):
+        pos = (1 + i * FAT_SECTS) * SECT_SIZE
+        img[pos:pos + len(table)] = table
+
+    root = dir_entry('BOOT       ', 0x10, 2, 0)
+    root += dir_entry('FILLER     ', 0x20, chains['filler'][0], BIG_SIZE)
+    pos = (1 + 2 * FAT_SECTS) * SECT_SIZE
+    img[pos:pos + len(root)] = root
+
+    subdir = dir_entry('.          ', 0x10, 2, 0)
+    subdir += dir_entry('..         ', 0x10, 0, 0)
+    subdir += dir_entry('BIG        ', 0x20, chains['boot/big'][0], BIG_SIZE)
+    subdir += dir_entry('SMALL      ', 0x20, chains['boot/small'][0],
+                        SMALL_SIZE)
+    pos = DATA_SECT * SECT_SIZE
+    img[pos:pos + len(subdir)] = subdir
+
+    with open(fname, 'wb') as fd:
+        fd.write(img)
+    del files['filler']
+    return files
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_fat')
+def test_fat_read(u_boot_console):
+    """Test reading a fragmented file and looking up paths"""
+    cons = u_boot_console
+    fname = os.path.join(cons.config.persistent_data_dir, 'fat_read.img')
+    files = make_image(fname)
+    addr = util.find_ram_base(cons) + 0x100000
+
+    cons.run_command('host bind 0 %s' % fname)
+    try:
+        # Count the reads needed to mount and find the file
+        reads = util.host_reads(cons)
+        output = cons.run_command('fatsize host 0:0 boot/big')
+        assert 'Error' not in output
+        lookup = util.host_reads(cons) - reads
+
+        for name, data in sorted(files.items()):
+            reads = util.host_reads(cons)
+            output = cons.run_command('fatload host 0:0 %x %s' % (addr, name))
+            assert '%d bytes read' % len(data) in output
+            reads = util.host_reads(cons) - reads
+            output = cons.run_command('crc32 %x %x' % (addr, len(data)))
+            assert '==> %08x' % (zlib.crc32(data) & 0xffffffff) in output
+
+            # One read per run and one for the FAT, not one per FAT window
+            if name == 'boot/big':
+                assert reads <= lookup + BIG_RUNS + 2
+
+        # Part of the file, starting part-way into a cluster
+        offset = RUN_CLUSTS * CLUST_SIZE * 3 + 1234
+        size = 1024 * 1024
+        cons.run_command('fatload host 0:0 %x boot/big %x %x' %
+                         (addr, size, offset))
+        output = cons.run_command('crc32 %x %x' % (addr, size))
+        crc = zlib.crc32(files['boot/big'][offset:offset + size]) & 0xffffffff
+        assert '==> %08x' % crc in output
+
+        # Lookups which find a directory first, then reuse it
+        assert 'filesize=0' in cons.run_command(
+            'fatsize host 0:0 /BOOT//; printenv filesize')
+        assert 'filesize=' not in cons.run_command(
+            'setenv filesize; fatsize host 0:0 boot/big/; printenv filesize')
+        output = cons.run_command('fatls host 0:0 boot')
+        assert 'small' in output and '%d' % BIG_SIZE in output
+    finally:
+        cons.run_command('host bind 0')
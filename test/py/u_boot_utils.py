@@ -8,6 +8,7 @@ import hashlib
 import os
 import os.path
 import pytest
+import re
 import sys
 import time
 import pytest
@@ -237,3 +238,23 @@ def find_ram_base(u_boot_console):
             raise Exception('Failed to find RAM bank start in `bdinfo`')
 
     return ram_base
+
+def host_reads(u_boot_console, dev=0):
+    """Count the reads made by a sandbox host device.
+
+    Read requests are counted by the sandbox host block driver and shown
+    by `host info`. Tests use the count to check that data is read in as
+    few requests as expected.
+
+    Args:
+        u_boot_console: A console connection to U-Boot.
+        dev: The host device number.
+
+    Returns:
+        The number of read requests made so far, as an integer.
+    """
+
+    output = u_boot_console.run_command('host info %d' % dev)
+    m = re.search(r'^\s*%d\s+\d+\s+(\d+)\s' % dev, output, re.M)
+    assert m, 'No read count for host device %d' % dev
+    return int(m.group(1))
@@ -0,0 +1,176 @@
+/*
+ * Tests for running jobs on secondary CPUs
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <smp_job.h>
+#include <image.h>
+#include <malloc.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+#include <u-boot/sha256.h>
+
+#define JOB_COUNT	32
+#define JOB_DATA_SIZE	0x10000
+#define FIT_IMAGES	8
+#define FIT_SIZE	(FIT_IMAGES * JOB_DATA_SIZE + 0x1000)
+
+struct test_job {
+	struct smp_job job;
+	const uint8_t *data;
+	uint32_t crc;
+};
+
+struct test_gate {
+	volatile int started;
+	volatile int open;
+};
+
+static int test_job_crc(void *arg)
+{
+	struct test_job *tj = arg;
+
+	tj->crc = crc32(0, tj->data, JOB_DATA_SIZE);
+
+	return tj->crc & 1 ? -EINVAL : 0;
+}
+
+static int test_job_gate(void *arg)
+{
+	struct test_gate *gate = arg;
+
+	gate->started = 1;
+	while (!gate->open)
+		;
+
+	return 0;
+}
+
+/* Check that results match running the jobs one after another */
+static int smp_job_ut_results(struct unit_test_state *uts)
+{
+	struct test_job *jobs;
+	uint8_t *buf;
+	int i, ret;
+
+	buf = malloc(JOB_COUNT * JOB_DATA_SIZE);
+	ut_assertnonnull(buf);
+	jobs = calloc(JOB_COUNT, sizeof(*jobs));
+	ut_assertnonnull(jobs);
+	for (i = 0; i < JOB_COUNT * JOB_DATA_SIZE; i++)
+		buf[i] = i * 13 + (i >> 12);
+
+	for (i = 0; i < JOB_COUNT; i++) {
+		jobs[i].data = buf + i * JOB_DATA_SIZE;
+		smp_job_queue(&jobs[i].job, test_job_crc, &jobs[i]);
+	}
+	/* Wait out of order, the waiting CPU runs queued jobs meanwhile */
+	for (i = JOB_COUNT - 1; i >= 0; i--) {
+		ret = smp_job_wait(&jobs[i].job);
+		ut_asserteq(crc32(0, jobs[i].data, JOB_DATA_SIZE),
+			    jobs[i].crc);
+		ut_asserteq(jobs[i].crc & 1 ? -EINVAL : 0, ret);
+	}
+	smp_job_exit();
+	ut_asserteq_ptr(NULL, smp_job_get_cpu(0));
+
+	free(jobs);
+	free(buf);
+
+	return 0;
+}
+
+/* Check that a job runs on another CPU while this one carries on */
+static int smp_job_ut_parallel(struct unit_test_state *uts)
+{
+	struct test_gate gate = { 0 };
+	struct smp_job job;
+	ulong start;
+
+	ut_assert(smp_job_init() > 0);
+	ut_assertnonnull(smp_job_get_cpu(0));
+	smp_job_queue(&job, test_job_gate, &gate);
+
+	start = get_timer(0);
+	while (!gate.started && get_timer(start) < 1000)
+		;
+	ut_assert(gate.started);
+	ut_asserteq(0, job.done);
+
+	gate.open = 1;
+	ut_assertok(smp_job_wait(&job));
+	smp_job_exit();
+
+	return 0;
+}
+
+/* Check FIT sha256 hashes calculated by jobs, with a mismatch */
+static int smp_job_ut_fit_sha256(struct unit_test_state *uts)
+{
+	uint8_t value[SHA256_SUM_LEN];
+	uint8_t *data;
+	char name[20];
+	int images, node, hash;
+	void *fit;
+	int i, j;
+
+	fit = malloc(FIT_SIZE);
+	ut_assertnonnull(fit);
+	data = malloc(JOB_DATA_SIZE);
+	ut_assertnonnull(data);
+	ut_assertok(fdt_create_empty_tree(fit, FIT_SIZE));
+	images = fdt_add_subnode(fit, 0, "images");
+	ut_assert(images >= 0);
+	for (i = 0; i < FIT_IMAGES; i++) {
+		for (j = 0; j < JOB_DATA_SIZE; j++)
+			data[j] = j * 7 + i + (j >> 10);
+		sha256_csum_wd(data, JOB_DATA_SIZE, value, CHUNKSZ_SHA256);
+
+		snprintf(name, sizeof(name), "kernel@%d", i + 1);
+		node = fdt_add_subnode(fit, images, name);
+		ut_assert(node >= 0);
+		ut_assertok(fdt_setprop(fit, node, FIT_DATA_PROP, data,
+					JOB_DATA_SIZE));
+		hash = fdt_add_subnode(fit, node, "hash@1");
+		ut_assert(hash >= 0);
+		ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP,
+					       "sha256"));
+		ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value,
+					sizeof(value)));
+	}
+
+	ut_assert(smp_job_init() > 0);
+	ut_asserteq(1, fit_all_image_verify(fit));
+	node = fdt_path_offset(fit, "/images/kernel@1");
+	ut_asserteq(1, fit_image_verify(fit, node));
+
+	/* Spoil the hash of the last image */
+	hash = fdt_path_offset(fit, "/images/kernel@8/hash@1");
+	ut_assert(hash >= 0);
+	value[0] ^= 0xff;
+	ut_assertok(fdt_setprop_inplace(fit, hash, FIT_VALUE_PROP, value,
+					sizeof(value)));
+	ut_asserteq(0, fit_all_image_verify(fit));
+	smp_job_exit();
+
+	free(data);
+	free(fit);
+
+	return 0;
+}
+
+int do_ut_smp_job(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test_state uts = { .fail_count = 0 };
+
+	smp_job_ut_results(&uts);
+	smp_job_ut_parallel(&uts);
+	smp_job_ut_fit_sha256(&uts);
+	printf("Test %s\n", uts.fail_count ? "failed" : "passed");
+
+	return uts.fail_count ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
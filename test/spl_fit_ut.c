@@ -0,0 +1,291 @@
+/*
+ * Tests for reading the images of a FIT in one pass, as SPL does with
+ * CONFIG_SPL_LOAD_FIT_MERGED
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+
+/*
+ * Build the SPL FIT loader into U-Boot proper, with the FIT header and the
+ * read buffer below 16MB of sandbox RAM and pieces smaller than the gap
+ * between the images below
+ */
+#undef CONFIG_SYS_TEXT_BASE
+#define CONFIG_SYS_TEXT_BASE		0x1000000
+#define CONFIG_LOAD_FIT			1
+#define CONFIG_SPL_LOAD_FIT_MERGED	1
+#define CONFIG_SPL_LOAD_FIT_CHUNK_SIZE	0x1000
+#define CONFIG_SPL_LOAD_FIT_HASH	1
+
+#include <command.h>
+#include <errno.h>
+#include <hash.h>
+#include <image.h>
+#include <libfdt.h>
+#include <mapmem.h>
+#include <spl.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#include "../common/common_fit.c"
+#include "../common/spl/spl_fit.c"
+
+#define SPL_FIT_UT_BLKSZ	512
+#define SPL_FIT_UT_HDR_SIZE	0x1000
+#define SPL_FIT_UT_SECTOR	4
+#define SPL_FIT_UT_DISK		0x3000000
+#define SPL_FIT_UT_DISK_SIZE	0x10000
+/* A load address in the read buffer below the FIT header */
+#define SPL_FIT_UT_BUF_LOAD	(CONFIG_SYS_TEXT_BASE - 0x2000)
+
+/**
+ * struct spl_fit_ut_image - an image with external data in the test FIT
+ *
+ * @name:	Name of the image node
+ * @offset:	Offset of the data from the end of the FIT header
+ * @size:	Size of the data
+ * @load:	Load address, 0 for none
+ * @algo:	Hash algorithm, NULL for no hash node
+ */
+struct spl_fit_ut_image {
+	const char *name;
+	ulong offset;
+	ulong size;
+	ulong load;
+	const char *algo;
+};
+
+/*
+ * "fw" and "a" share a block, and the FDT follows them. "b" is two pieces
+ * long, after a gap of several pieces which should not be read.
+ */
+static const struct spl_fit_ut_image spl_fit_ut_images[] = {
+	{ "fw", 0, 0x300, 0x2000000, "sha256" },
+	{ "a", 0x300, 0x500, 0x2100000, "crc32" },
+	{ "fdt", 0x800, 0x200, 0, NULL },
+	{ "b", 0x5000, 0x1800, 0x2200000, "sha256" },
+};
+
+/* Reads made through spl_fit_ut_read() */
+static ulong spl_fit_ut_reads;
+static ulong spl_fit_ut_blocks;
+
+static ulong spl_fit_ut_read(struct spl_load_info *load, ulong sector,
+			     ulong count, void *buf)
+{
+	spl_fit_ut_reads++;
+	spl_fit_ut_blocks += count;
+	if ((sector + count) * SPL_FIT_UT_BLKSZ > SPL_FIT_UT_DISK_SIZE)
+		return 0;
+	memcpy(buf, load->priv + sector * SPL_FIT_UT_BLKSZ,
+	       count * SPL_FIT_UT_BLKSZ);
+
+	return count;
+}
+
+int board_fit_config_name_match(const char *name)
+{
+	return 0;
+}
+
+/* Write the FIT header and the image data to the disk */
+static int spl_fit_ut_make(struct unit_test_state *uts, char *disk)
+{
+	const struct spl_fit_ut_image *img;
+	char *fit = disk + SPL_FIT_UT_SECTOR * SPL_FIT_UT_BLKSZ;
+	char *data = fit + SPL_FIT_UT_HDR_SIZE;
+	uint8_t value[HASH_MAX_DIGEST_SIZE];
+	int images, conf, node, hash;
+	int i, j;
+
+	memset(disk, '\0', SPL_FIT_UT_DISK_SIZE);
+	ut_assertok(fdt_create_empty_tree(fit, SPL_FIT_UT_HDR_SIZE));
+	images = fdt_add_subnode(fit, 0, "images");
+	ut_assert(images >= 0);
+	for (i = ARRAY_SIZE(spl_fit_ut_images) - 1; i >= 0; i--) {
+		img = &spl_fit_ut_images[i];
+		if (img->load) {
+			for (j = 0; j < img->size; j++)
+				data[img->offset + j] = i * 0x40 + j * 7 +
+							(j >> 8);
+		} else {
+			ut_assertok(fdt_create_empty_tree(data + img->offset,
+							  img->size));
+		}
+
+		node = fdt_add_subnode(fit, images, img->name);
+		ut_assert(node >= 0);
+		ut_assertok(fdt_setprop_u32(fit, node, "data-offset",
+					    img->offset));
+		ut_assertok(fdt_setprop_u32(fit, node, "data-size",
+					    img->size));
+		if (img->load) {
+			ut_assertok(fdt_setprop_string(fit, node, "type",
+						       "firmware"));
+			ut_assertok(fdt_setprop_u32(fit, node, "load",
+						    img->load));
+		} else {
+			ut_assertok(fdt_setprop_string(fit, node, "type",
+						       "flat_dt"));
+		}
+		if (!img->algo)
+			continue;
+
+		hash = fdt_add_subnode(fit, node, FIT_HASH_NODENAME "-1");
+		ut_assert(hash >= 0);
+		ut_assertok(fdt_setprop_string(fit, hash, FIT_ALGO_PROP,
+					       img->algo));
+		j = sizeof(value);
+		ut_assertok(hash_block(img->algo, data + img->offset,
+				       img->size, value, &j));
+		ut_assertok(fdt_setprop(fit, hash, FIT_VALUE_PROP, value, j));
+	}
+
+	conf = fdt_add_subnode(fit, 0, "configurations");
+	ut_assert(conf >= 0);
+	ut_assertok(fdt_setprop_string(fit, conf, "default", "conf"));
+	node = fdt_add_subnode(fit, conf, "conf");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fit, node, "description", "test"));
+	ut_assertok(fdt_setprop_string(fit, node, "firmware", "fw"));
+	ut_assertok(fdt_setprop(fit, node, "loadables", "a\0b", 4));
+	ut_assertok(fdt_setprop_string(fit, node, FIT_FDT_PROP, "fdt"));
+	ut_asserteq(SPL_FIT_UT_HDR_SIZE, fdt_totalsize(fit));
+
+	return 0;
+}
+
+/* Load the FIT from the disk, counting the reads */
+static int spl_fit_ut_load(char *disk, struct spl_image_info *spl_image)
+{
+	const struct spl_fit_ut_image *img;
+	struct spl_load_info info;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(spl_fit_ut_images); i++) {
+		img = &spl_fit_ut_images[i];
+		if (img->load)
+			memset(map_sysmem(img->load, img->size), '\0',
+			       img->size);
+	}
+	memset(spl_image, '\0', sizeof(*spl_image));
+	memset(&info, '\0', sizeof(info));
+	info.priv = disk;
+	info.bl_len = SPL_FIT_UT_BLKSZ;
+	info.read = spl_fit_ut_read;
+	spl_fit_ut_reads = 0;
+	spl_fit_ut_blocks = 0;
+
+	return spl_load_simple_fit(spl_image, &info, SPL_FIT_UT_SECTOR,
+				   disk + SPL_FIT_UT_SECTOR * SPL_FIT_UT_BLKSZ);
+}
+
+/* Check that an image is at its load address */
+static int spl_fit_ut_check(struct unit_test_state *uts, char *disk,
+			    const char *name)
+{
+	const struct spl_fit_ut_image *img;
+	char *data = disk + SPL_FIT_UT_SECTOR * SPL_FIT_UT_BLKSZ +
+		     SPL_FIT_UT_HDR_SIZE;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(spl_fit_ut_images); i++) {
+		img = &spl_fit_ut_images[i];
+		if (!strcmp(img->name, name)) {
+			ut_assertok(memcmp(map_sysmem(img->load, img->size),
+					   data + img->offset, img->size));
+			return 0;
+		}
+	}
+	ut_assert(false);
+
+	return 0;
+}
+
+static int spl_fit_ut_run(struct unit_test_state *uts, char *disk)
+{
+	char *fit = disk + SPL_FIT_UT_SECTOR * SPL_FIT_UT_BLKSZ;
+	struct spl_image_info spl_image;
+	int node;
+
+	ut_assertok(spl_fit_ut_make(uts, disk));
+
+	/*
+	 * One read for the header, then one each for the piece holding "fw",
+	 * "a" and the FDT, and the two pieces of "b". The block shared by "fw"
+	 * and "a" is read once, and the gap not at all.
+	 */
+	ut_assertok(spl_fit_ut_load(disk, &spl_image));
+	ut_asserteq(4, spl_fit_ut_reads);
+	ut_asserteq((SPL_FIT_UT_HDR_SIZE + 0x1000 + 0x1800) / SPL_FIT_UT_BLKSZ,
+		    spl_fit_ut_blocks);
+	ut_asserteq(0x2000000, spl_image.load_addr);
+	ut_asserteq(0x300, spl_image.size);
+	ut_assertok(spl_fit_ut_check(uts, disk, "fw"));
+	ut_assertok(spl_fit_ut_check(uts, disk, "a"));
+	ut_assertok(spl_fit_ut_check(uts, disk, "b"));
+
+	/* The FDT follows U-Boot and lists the loadables */
+	ut_asserteq_ptr(map_sysmem(0x2000300, 0), spl_image.fdt_addr);
+	ut_assertok(fdt_check_header(spl_image.fdt_addr));
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/a");
+	ut_assert(node >= 0);
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/b");
+	ut_assert(node >= 0);
+
+	/* A loadable which does not match its hash is left out */
+	fit[SPL_FIT_UT_HDR_SIZE + 0x5000 + 0x1000]++;
+	ut_assertok(spl_fit_ut_load(disk, &spl_image));
+	ut_asserteq(4, spl_fit_ut_reads);
+	ut_assertok(spl_fit_ut_check(uts, disk, "a"));
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/a");
+	ut_assert(node >= 0);
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/b");
+	ut_asserteq(-FDT_ERR_NOTFOUND, node);
+
+	/* U-Boot itself must match */
+	fit[SPL_FIT_UT_HDR_SIZE + 0x100]++;
+	ut_asserteq(-EPERM, spl_fit_ut_load(disk, &spl_image));
+
+	/*
+	 * Loading "a" over the read buffer has the images read one by one,
+	 * which still checks their hashes
+	 */
+	ut_assertok(spl_fit_ut_make(uts, disk));
+	node = fdt_path_offset(fit, "/images/a");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_inplace_u32(fit, node, "load",
+					    SPL_FIT_UT_BUF_LOAD));
+	ut_assertok(spl_fit_ut_load(disk, &spl_image));
+	ut_asserteq(5, spl_fit_ut_reads);
+	ut_assertok(memcmp(map_sysmem(SPL_FIT_UT_BUF_LOAD, 0x500),
+			   fit + SPL_FIT_UT_HDR_SIZE + 0x300, 0x500));
+	ut_assertok(spl_fit_ut_check(uts, disk, "b"));
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/a");
+	ut_assert(node >= 0);
+
+	fit[SPL_FIT_UT_HDR_SIZE + 0x300]++;
+	ut_assertok(spl_fit_ut_load(disk, &spl_image));
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/a");
+	ut_asserteq(-FDT_ERR_NOTFOUND, node);
+	node = fdt_path_offset(spl_image.fdt_addr, "/fit-images/b");
+	ut_assert(node >= 0);
+
+	fit[SPL_FIT_UT_HDR_SIZE + 0x100]++;
+	ut_asserteq(-EPERM, spl_fit_ut_load(disk, &spl_image));
+
+	return 0;
+}
+
+int do_ut_spl_fit(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test_state uts = { .fail_count = 0 };
+	char *disk = map_sysmem(SPL_FIT_UT_DISK, SPL_FIT_UT_DISK_SIZE);
+
+	spl_fit_ut_run(&uts, disk);
+	printf("Test %s\n", uts.fail_count ? "failed" : "passed");
+
+	return uts.fail_count ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
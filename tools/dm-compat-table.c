@@ -0,0 +1,529 @@
+/*
+ * Fill in the driver compatible-string table of a linked U-Boot
+ *
+ * lists_bind_fdt() looks up the driver for each compatible string. This
+ * tool reads the driver linker list and each driver's of_match table from
+ * the ELF file, then writes a table of string hashes, sorted by hash, into
+ * the space reserved by lists_compat_table so that the lookup is a binary
+ * search even before relocation. The table holds only indexes, so it needs
+ * no relocation itself.
+ *
+ * Pointers in the image are read from the section contents, or for
+ * position-independent images from the addend of the RELATIVE relocation
+ * for that address. Little-endian targets only.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <elf.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compiler.h"
+
+/* These must match struct lists_compat_table in drivers/core/lists.c */
+#define COMPAT_TABLE_MAGIC	0x54434d44	/* "DMCT" */
+#define COMPAT_TABLE_HDR_SIZE	8
+#define COMPAT_ENTRY_SIZE	8
+
+#define DRIVER_PREFIX		"_u_boot_list_2_driver_2_"
+#define TABLE_SYMBOL		"lists_compat_table"
+
+struct compat_entry {
+	uint32_t hash;
+	uint16_t driver;
+	uint16_t of_id;
+	const char *compat;
+};
+
+struct reloc {
+	uint64_t offset;
+	uint64_t addend;
+};
+
+struct image {
+	const char *fname;
+	uint8_t *buf;
+	size_t size;
+	bool is64;
+	int ptr_size;
+
+	/* Section headers, as read from the file */
+	uint8_t *shdrs;
+	int shnum;
+	int shentsize;
+
+	/* RELATIVE relocations, sorted by offset */
+	struct reloc *relocs;
+	int reloc_count;
+};
+
+static const char *prog;
+
+static uint64_t get_num(const uint8_t *ptr, int size)
+{
+	uint64_t val = 0;
+	int i;
+
+	for (i = size - 1; i >= 0; i--)
+		val = (val << 8) | ptr[i];
+
+	return val;
+}
+
+static void put_num(uint8_t *ptr, uint64_t val, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++, val >>= 8)
+		ptr[i] = val & 0xff;
+}
+
+/* Read a field of an ELF structure, whose offset depends on the class */
+#define ELF_FIELD(img, ptr, type, field) \
+	((img)->is64 ? \
+	 get_num((ptr) + offsetof(Elf64_##type, field), \
+		 sizeof(((Elf64_##type *)0)->field)) : \
+	 get_num((ptr) + offsetof(Elf32_##type, field), \
+		 sizeof(((Elf32_##type *)0)->field)))
+
+static uint8_t *section(struct image *img, int idx)
+{
+	return img->shdrs + idx * img->shentsize;
+}
+
+/* Find the file data for @size bytes at address @addr, or NULL */
+static uint8_t *addr_to_data(struct image *img, uint64_t addr, uint64_t size)
+{
+	uint64_t start, len, offset;
+	uint8_t *sh;
+	int i;
+
+	for (i = 0; i < img->shnum; i++) {
+		sh = section(img, i);
+		if (ELF_FIELD(img, sh, Shdr, sh_type) != SHT_PROGBITS ||
+		    !(ELF_FIELD(img, sh, Shdr, sh_flags) & SHF_ALLOC))
+			continue;
+		start = ELF_FIELD(img, sh, Shdr, sh_addr);
+		len = ELF_FIELD(img, sh, Shdr, sh_size);
+		offset = ELF_FIELD(img, sh, Shdr, sh_offset);
+		if (addr < start || addr + size > start + len ||
+		    offset + len > img->size)
+			continue;
+
+		return img->buf + offset + (addr - start);
+	}
+
+	return NULL;
+}
+
+static int reloc_cmp(const void *a, const void *b)
+{
+	const struct reloc *ra = a, *rb = b;
+
+	return ra->offset < rb->offset ? -1 : ra->offset > rb->offset;
+}
+
+/*
+ * Collect the relocations with no symbol from the RELA sections, which
+ * is what a position-independent image uses for pointers to itself
+ */
+static int read_relocs(struct image *img)
+{
+	uint64_t offset, entsize, count, info, sym;
+	uint8_t *sh, *rela;
+	int i, j;
+
+	for (i = 0; i < img->shnum; i++) {
+		sh = section(img, i);
+		if (ELF_FIELD(img, sh, Shdr, sh_type) != SHT_RELA)
+			continue;
+		offset = ELF_FIELD(img, sh, Shdr, sh_offset);
+		entsize = ELF_FIELD(img, sh, Shdr, sh_entsize);
+		if (!entsize)
+			continue;
+		count = ELF_FIELD(img, sh, Shdr, sh_size) / entsize;
+		if (offset + count * entsize > img->size)
+			return -EINVAL;
+		img->relocs = realloc(img->relocs, (img->reloc_count + count) *
+				      sizeof(*img->relocs));
+		if (!img->relocs)
+			return -ENOMEM;
+		for (j = 0; j < count; j++) {
+			rela = img->buf + offset + j * entsize;
+			info = ELF_FIELD(img, rela, Rela, r_info);
+			sym = img->is64 ? ELF64_R_SYM(info) : ELF32_R_SYM(info);
+			if (sym)
+				continue;
+			img->relocs[img->reloc_count].offset =
+				ELF_FIELD(img, rela, Rela, r_offset);
+			img->relocs[img->reloc_count].addend =
+				ELF_FIELD(img, rela, Rela, r_addend);
+			img->reloc_count++;
+		}
+	}
+	qsort(img->relocs, img->reloc_count, sizeof(*img->relocs), reloc_cmp);
+
+	return 0;
+}
+
+/* Read the pointer at @addr in the image, 0 if it cannot be read */
+static uint64_t read_ptr(struct image *img, uint64_t addr)
+{
+	struct reloc key, *rel;
+	uint8_t *data;
+
+	key.offset = addr;
+	rel = bsearch(&key, img->relocs, img->reloc_count,
+		      sizeof(*img->relocs), reloc_cmp);
+	if (rel)
+		return rel->addend;
+	data = addr_to_data(img, addr, img->ptr_size);
+
+	return data ? get_num(data, img->ptr_size) : 0;
+}
+
+static const char *read_str(struct image *img, uint64_t addr)
+{
+	const char *str = (const char *)addr_to_data(img, addr, 1);
+	uint8_t *end;
+
+	if (!str)
+		return NULL;
+	/* Make sure the string ends inside its section */
+	end = addr_to_data(img, addr + strnlen(str, 256), 1);
+	if (!end || *end)
+		return NULL;
+
+	return str;
+}
+
+struct symbol {
+	const char *name;
+	uint64_t value;
+	uint64_t size;
+};
+
+static int symbol_cmp(const void *a, const void *b)
+{
+	const struct symbol *sa = a, *sb = b;
+
+	return sa->value < sb->value ? -1 : sa->value > sb->value;
+}
+
+/*
+ * Find the driver list entries, sorted by address, and the table. Returns
+ * the number of drivers, or -ve on error
+ */
+static int read_symbols(struct image *img, struct symbol **driversp,
+			struct symbol *table)
+{
+	uint64_t offset, entsize, count, strtab, str_size;
+	struct symbol *drivers = NULL;
+	uint8_t *sh, *sym, *link;
+	int num_drivers = 0;
+	const char *name;
+	uint64_t name_off;
+	int i, j;
+
+	memset(table, '\0', sizeof(*table));
+	for (i = 0; i < img->shnum; i++) {
+		sh = section(img, i);
+		if (ELF_FIELD(img, sh, Shdr, sh_type) != SHT_SYMTAB)
+			continue;
+		link = section(img, ELF_FIELD(img, sh, Shdr, sh_link));
+		strtab = ELF_FIELD(img, link, Shdr, sh_offset);
+		str_size = ELF_FIELD(img, link, Shdr, sh_size);
+		offset = ELF_FIELD(img, sh, Shdr, sh_offset);
+		entsize = ELF_FIELD(img, sh, Shdr, sh_entsize);
+		count = ELF_FIELD(img, sh, Shdr, sh_size) / entsize;
+		if (offset + count * entsize > img->size ||
+		    strtab + str_size > img->size)
+			return -EINVAL;
+
+		for (j = 0; j < count; j++) {
+			sym = img->buf + offset + j * entsize;
+			name_off = ELF_FIELD(img, sym, Sym, st_name);
+			if (name_off >= str_size)
+				continue;
+			name = (const char *)img->buf + strtab + name_off;
+			if (!strcmp(name, TABLE_SYMBOL)) {
+				table->name = name;
+				table->value = ELF_FIELD(img, sym, Sym, st_value);
+				table->size = ELF_FIELD(img, sym, Sym, st_size);
+				continue;
+			}
+			if (strncmp(name, DRIVER_PREFIX, strlen(DRIVER_PREFIX)))
+				continue;
+			drivers = realloc(drivers, (num_drivers + 1) *
+					  sizeof(*drivers));
+			if (!drivers)
+				return -ENOMEM;
+			drivers[num_drivers].name = name;
+			drivers[num_drivers].value =
+				ELF_FIELD(img, sym, Sym, st_value);
+			drivers[num_drivers].size =
+				ELF_FIELD(img, sym, Sym, st_size);
+			num_drivers++;
+		}
+	}
+	qsort(drivers, num_drivers, sizeof(*drivers), symbol_cmp);
+	*driversp = drivers;
+
+	return num_drivers;
+}
+
+/* FNV-1a, as lists_compat_hash() */
+static uint32_t compat_hash(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (uint8_t)*str++;
+		hash *= 16777619;
+	}
+
+	return hash ?: 1;
+}
+
+static int entry_cmp(const void *a, const void *b)
+{
+	const struct compat_entry *ea = a, *eb = b;
+
+	if (ea->hash != eb->hash)
+		return ea->hash < eb->hash ? -1 : 1;
+	if (ea->driver != eb->driver)
+		return ea->driver < eb->driver ? -1 : 1;
+
+	return ea->of_id < eb->of_id ? -1 : ea->of_id > eb->of_id;
+}
+
+/*
+ * Sort the entries, keeping only the first driver (in linker-list order)
+ * for each string since that is the one a linear search would find
+ */
+static int sort_entries(struct compat_entry *entries, int count)
+{
+	int i, j, out = 0;
+
+	qsort(entries, count, sizeof(*entries), entry_cmp);
+	for (i = 0; i < count; i++) {
+		for (j = out - 1; j >= 0 && entries[j].hash == entries[i].hash;
+		     j--) {
+			if (!strcmp(entries[j].compat, entries[i].compat))
+				break;
+		}
+		if (j >= 0 && entries[j].hash == entries[i].hash)
+			continue;
+		entries[out++] = entries[i];
+	}
+
+	return out;
+}
+
+static int build_table(struct image *img)
+{
+	struct compat_entry *entries = NULL;
+	uint64_t stride, of_match, str;
+	struct symbol *drivers, table;
+	int num_drivers, count = 0;
+	int capacity, i, j, ret;
+	uint8_t *data, *buf;
+	const char *compat;
+	size_t size;
+
+	num_drivers = read_symbols(img, &drivers, &table);
+	if (num_drivers < 0)
+		return num_drivers;
+	if (!table.name) {
+		fprintf(stderr, "%s: %s: no %s symbol\n", prog, img->fname,
+			TABLE_SYMBOL);
+		return -ENOENT;
+	}
+	data = addr_to_data(img, table.value, table.size);
+	if (!data || table.size < COMPAT_TABLE_HDR_SIZE ||
+	    get_num(data, 4) != COMPAT_TABLE_MAGIC) {
+		fprintf(stderr, "%s: %s: bad %s\n", prog, img->fname,
+			TABLE_SYMBOL);
+		return -EINVAL;
+	}
+	capacity = (table.size - COMPAT_TABLE_HDR_SIZE) / COMPAT_ENTRY_SIZE;
+
+	/* The entries must be evenly spaced for the indexes to work */
+	stride = num_drivers ? drivers[0].size : 0;
+	for (i = 1; i < num_drivers; i++) {
+		if (drivers[i].value != drivers[0].value + i * stride) {
+			fprintf(stderr, "%s: %s: driver list has a gap at %s\n",
+				prog, img->fname, drivers[i].name);
+			return -EINVAL;
+		}
+	}
+	if (num_drivers > 0xffff) {
+		fprintf(stderr, "%s: %s: too many drivers\n", prog,
+			img->fname);
+		return -E2BIG;
+	}
+
+	for (i = 0; i < num_drivers; i++) {
+		/* struct driver is name, id, of_match */
+		of_match = read_ptr(img, drivers[i].value + 2 * img->ptr_size);
+		if (!of_match)
+			continue;
+		/* struct udevice_id is compatible, data */
+		for (j = 0; ; j++) {
+			str = read_ptr(img, of_match + j * 2 * img->ptr_size);
+			if (!str)
+				break;
+			compat = read_str(img, str);
+			if (!compat) {
+				fprintf(stderr, "%s: %s: cannot read compatible string %d of %s\n",
+					prog, img->fname, j, drivers[i].name);
+				return -EINVAL;
+			}
+			entries = realloc(entries,
+					  (count + 1) * sizeof(*entries));
+			if (!entries)
+				return -ENOMEM;
+			entries[count].hash = compat_hash(compat);
+			entries[count].driver = i;
+			entries[count].of_id = j;
+			entries[count].compat = compat;
+			count++;
+		}
+	}
+	count = sort_entries(entries, count);
+	if (count > capacity) {
+		fprintf(stderr, "%s: %s: %d compatible strings, but space for %d: increase CONFIG_DM_COMPAT_TABLE_SIZE\n",
+			prog, img->fname, count, capacity);
+		return -ENOSPC;
+	}
+
+	size = COMPAT_TABLE_HDR_SIZE + count * COMPAT_ENTRY_SIZE;
+	buf = calloc(1, size);
+	if (!buf)
+		return -ENOMEM;
+	put_num(buf, COMPAT_TABLE_MAGIC, 4);
+	put_num(buf + 4, count, 2);
+	put_num(buf + 6, num_drivers, 2);
+	for (i = 0; i < count; i++) {
+		uint8_t *ent = buf + COMPAT_TABLE_HDR_SIZE +
+			       i * COMPAT_ENTRY_SIZE;
+
+		put_num(ent, entries[i].hash, 4);
+		put_num(ent + 4, entries[i].driver, 2);
+		put_num(ent + 6, entries[i].of_id, 2);
+	}
+
+	/* Leave the file alone if it is already up to date */
+	ret = memcmp(data, buf, size) ? 1 : 0;
+	memcpy(data, buf, size);
+	free(buf);
+	free(entries);
+	free(drivers);
+
+	return ret;
+}
+
+static int read_image(struct image *img)
+{
+	uint64_t shoff;
+	FILE *f;
+	long size;
+
+	f = fopen(img->fname, "rb");
+	if (!f)
+		return -errno;
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET)) {
+		fclose(f);
+		return -EIO;
+	}
+	img->size = size;
+	img->buf = malloc(size);
+	if (!img->buf) {
+		fclose(f);
+		return -ENOMEM;
+	}
+	if (fread(img->buf, 1, size, f) != size) {
+		fclose(f);
+		return -EIO;
+	}
+	fclose(f);
+
+	if (size < EI_NIDENT || memcmp(img->buf, ELFMAG, SELFMAG)) {
+		fprintf(stderr, "%s: %s: not an ELF file\n", prog, img->fname);
+		return -EINVAL;
+	}
+	if (img->buf[EI_DATA] != ELFDATA2LSB) {
+		fprintf(stderr, "%s: %s: only little-endian is supported\n",
+			prog, img->fname);
+		return -EINVAL;
+	}
+	img->is64 = img->buf[EI_CLASS] == ELFCLASS64;
+	img->ptr_size = img->is64 ? 8 : 4;
+	if (size < (img->is64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)))
+		return -EINVAL;
+
+	shoff = ELF_FIELD(img, img->buf, Ehdr, e_shoff);
+	img->shnum = ELF_FIELD(img, img->buf, Ehdr, e_shnum);
+	img->shentsize = ELF_FIELD(img, img->buf, Ehdr, e_shentsize);
+	if (!shoff || shoff + img->shnum * img->shentsize > size)
+		return -EINVAL;
+	img->shdrs = img->buf + shoff;
+
+	return read_relocs(img);
+}
+
+static int write_image(struct image *img)
+{
+	FILE *f;
+
+	f = fopen(img->fname, "r+b");
+	if (!f)
+		return -errno;
+	if (fwrite(img->buf, 1, img->size, f) != img->size) {
+		fclose(f);
+		return -EIO;
+	}
+
+	return fclose(f) ? -errno : 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct image img;
+	int ret;
+
+	prog = argv[0];
+	if (argc != 2) {
+		fprintf(stderr, "Fill in the driver compatible-string table\n");
+		fprintf(stderr, "Usage: %s <u-boot ELF file>\n", prog);
+		return 1;
+	}
+
+	memset(&img, '\0', sizeof(img));
+	img.fname = argv[1];
+	ret = read_image(&img);
+	if (ret) {
+		fprintf(stderr, "%s: %s: cannot read: %s\n", prog, img.fname,
+			strerror(-ret));
+		return 2;
+	}
+
+	ret = build_table(&img);
+	if (ret < 0)
+		return 3;
+	if (ret) {
+		ret = write_image(&img);
+		if (ret) {
+			fprintf(stderr, "%s: %s: cannot write: %s\n", prog,
+				img.fname, strerror(-ret));
+			return 4;
+		}
+	}
+
+	return 0;
+}